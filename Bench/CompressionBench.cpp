@@ -0,0 +1,234 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+// Bytes on wire against CPU time for each compression mode.
+//
+// Usage: CompressionBench [trace]
+//
+// Trace has one frame per line, exactly as sent to server. Without trace a
+// synthetic session is used: album played track by track, playback ticks
+// every second, cover once per album.
+
+#include "FrameCompressor.hpp"
+#include "Payload.hpp"
+#include "Serializer.hpp"
+
+#include <zlib.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace foo_showplay;
+
+namespace {
+
+struct Mode
+{
+    const char*           Name;
+    int                   Level; // 0 means raw.
+    CompressionDictionary Dictionary;
+    std::size_t           Threshold;
+};
+
+auto WriteFrame(int frame, const Payload& payload) -> std::string
+{
+    auto buffer = std::string();
+    auto writer = JsonWriter(buffer);
+
+    auto masks = FieldMasks<Payload>();
+    for (auto& mask : masks.Fields)
+    {
+        mask = ALL_FIELDS;
+    }
+
+    writer.BeginObject();
+    WriteSections(writer, payload, masks, "", "Frame");
+    writer.Key("Frame");
+    writer.Integer(frame);
+    WriteSections(writer, payload, masks, "Frame", "Token");
+    writer.Key("Token");
+    writer.String("6f1d2c3b-4a59-4e68-8f77-1a2b3c4d5e6f");
+    WriteSections(writer, payload, masks, "Token", "");
+    writer.EndObject();
+
+    return buffer;
+}
+
+auto SyntheticTrace() -> std::vector<std::string>
+{
+    auto random = std::mt19937(1);
+    auto frames = std::vector<std::string>();
+    auto frame  = 0;
+
+    for (auto album = 0; album < 4; ++album)
+    {
+        // JPEG is incompressible, random bytes are close enough.
+        auto cover = std::make_shared<std::vector<std::uint8_t>>(48 * 1024);
+        for (auto& byte : *cover)
+        {
+            byte = static_cast<std::uint8_t>(random());
+        }
+
+        auto image = BinaryData(std::shared_ptr<const std::uint8_t>(cover, cover->data()), cover->size());
+
+        for (auto track = 1; track <= 10; ++track)
+        {
+            auto song        = SongInfo();
+            song.Title       = "Track Title Number " + std::to_string(track);
+            song.Artist      = "Some Artist";
+            song.Album       = "Album " + std::to_string(album);
+            song.Date        = "2019-05-17";
+            song.Year        = "2019";
+            song.TrackNumber = track;
+            song.Length      = 180.0 + track * 7.25;
+            song.Path        = "file://C:\\Users\\Music\\Some Artist\\Album " + std::to_string(album) +
+                               "\\" + std::to_string(track) + " - Track Title Number " + std::to_string(track) + ".flac";
+
+            auto coverInfo  = CoverInfo();
+            coverInfo.Hash  = "0123456789abcdef";
+            coverInfo.Image = track == 1 ? std::optional<BinaryData>(image) : std::nullopt;
+
+            auto playback    = PlaybackInfo();
+            playback.State   = PlaybackState::Playing;
+            playback.Elapsed = 0.0;
+
+            frames.push_back(WriteFrame(frame++, Payload(std::nullopt, playback, song, coverInfo)));
+
+            // Per second updates.
+            for (auto second = 1; second < 180; ++second)
+            {
+                auto tick    = PlaybackInfo();
+                tick.Elapsed = static_cast<double>(second);
+                frames.push_back(WriteFrame(frame++, Payload(std::nullopt, tick, std::nullopt, std::nullopt)));
+            }
+        }
+    }
+
+    return frames;
+}
+
+auto ReadTrace(const char* path) -> std::vector<std::string>
+{
+    auto frames = std::vector<std::string>();
+    auto file   = std::ifstream(path, std::ios::binary);
+    auto line   = std::string();
+    while (std::getline(file, line))
+    {
+        if (!line.empty())
+        {
+            frames.push_back(line);
+        }
+    }
+
+    return frames;
+}
+
+// Server side of the protocol, proves the frame can be restored.
+auto Inflate(const std::string& message, std::size_t size) -> std::string
+{
+    auto stream = z_stream();
+    inflateInit2(&stream, -15);
+
+    auto dictionary = FrameCompressor::GetDictionary(static_cast<CompressionDictionary>(message[3]));
+    if (!dictionary.empty())
+    {
+        inflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.data()), static_cast<uInt>(dictionary.size()));
+    }
+
+    auto result = std::string(size, '\0');
+    stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(message.data() + 4));
+    stream.avail_in  = static_cast<uInt>(message.size() - 4);
+    stream.next_out  = reinterpret_cast<Bytef*>(result.data());
+    stream.avail_out = static_cast<uInt>(result.size());
+    inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto frames = argc > 1 ? ReadTrace(argv[1]) : SyntheticTrace();
+    if (frames.empty())
+    {
+        std::fprintf(stderr, "Empty trace.\n");
+        return 1;
+    }
+
+    static const Mode modes[] = {
+        { "raw",                0, CompressionDictionary::None, 0   },
+        { "deflate-1",          1, CompressionDictionary::None, 256 },
+        { "deflate-6",          6, CompressionDictionary::None, 256 },
+        { "deflate-6-all",      6, CompressionDictionary::None, 0   },
+        { "deflate-6-song",     6, CompressionDictionary::Song, 256 },
+        { "deflate-6-song-all", 6, CompressionDictionary::Song, 0   },
+        { "deflate-9-song",     9, CompressionDictionary::Song, 256 },
+    };
+
+    auto rawBytes = std::size_t(0);
+    for (const auto& frame : frames)
+    {
+        rawBytes += frame.size();
+    }
+
+    std::printf("%zu frames, %zu bytes\n\n", frames.size(), rawBytes);
+    std::printf("%-20s %12s %8s %12s %10s\n", "mode", "wire bytes", "ratio", "cpu us", "us/frame");
+
+    for (const auto& mode : modes)
+    {
+        auto compressor = FrameCompressor(mode.Level > 0 ? mode.Level : 1);
+        auto wireBytes  = std::size_t(0);
+        auto start      = std::chrono::steady_clock::now();
+
+        for (const auto& frame : frames)
+        {
+            auto message = static_cast<const std::string*>(nullptr);
+            if (mode.Level > 0 && frame.size() >= mode.Threshold)
+            {
+                message = compressor.Compress(frame, mode.Dictionary);
+            }
+
+            wireBytes += message != nullptr ? message->size() : frame.size();
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("%-20s %12zu %7.3f %12lld %10.2f\n", mode.Name, wireBytes,
+                    static_cast<double>(wireBytes) / rawBytes, static_cast<long long>(elapsed),
+                    static_cast<double>(elapsed) / frames.size());
+
+        // Round trip check of every compressed frame.
+        for (const auto& frame : frames)
+        {
+            auto message = mode.Level > 0 ? compressor.Compress(frame, mode.Dictionary) : nullptr;
+            if (message != nullptr && Inflate(*message, frame.size()) != frame)
+            {
+                std::fprintf(stderr, "%s: frame doesn't round trip\n", mode.Name);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
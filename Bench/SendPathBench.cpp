@@ -0,0 +1,310 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+// Cost of each stage of sending a frame, from payload to bytes on the wire.
+//
+// Usage: SendPathBench [--benchmark_out=results.json --benchmark_out_format=json]
+//
+// Stages are run the way WebSocketClient runs them, on payloads shaped like
+// the ones foobar2000 produces. nlohmann::json document and cpp-base64 are
+// kept as reference for the writers that replaced them.
+
+#include "Base64.hpp"
+#include "FrameCompressor.hpp"
+#include "Payload.hpp"
+#include "Serializer.hpp"
+#include "ServerMessage.hpp"
+#include "SharedPayload.hpp"
+#include "SongInfoFormat.hpp"
+#include "Uuid.hpp"
+
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <base64.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace foo_showplay;
+
+namespace {
+
+constexpr auto TOKEN = "6f1d2c3b-4a59-4e68-8f77-1a2b3c4d5e6f";
+
+auto MakeImage(std::size_t size) -> BinaryData
+{
+    // JPEG is incompressible, random bytes are close enough.
+    auto random = std::mt19937(1);
+    auto bytes  = std::make_shared<std::vector<std::uint8_t>>(size);
+    for (auto& byte : *bytes)
+    {
+        byte = static_cast<std::uint8_t>(random());
+    }
+
+    return BinaryData(std::shared_ptr<const std::uint8_t>(bytes, bytes->data()), bytes->size());
+}
+
+auto MakeSong() -> SongInfo
+{
+    auto song        = SongInfo();
+    song.Title       = "Track Title Number 7";
+    song.Artist      = "Some Artist";
+    song.Album       = "Album 3";
+    song.Date        = "2019-05-17";
+    song.Year        = "2019";
+    song.TrackNumber = 7;
+    song.Length      = 230.373333;
+    song.Path        = "file://C:\\Users\\Music\\Some Artist\\Album 3\\07 - Track Title Number 7.flac";
+    return song;
+}
+
+// New track: player, playback, song and cover known by hash only.
+auto MakeTrackPayload() -> Payload
+{
+    auto player = PlayerInfo();
+    player.Name = "foobar2000";
+
+    auto playback    = PlaybackInfo();
+    playback.State   = PlaybackState::Playing;
+    playback.Elapsed = 0.0;
+
+    auto cover = CoverInfo();
+    cover.Hash = "0123456789abcdef";
+
+    return Payload(player, playback, MakeSong(), cover);
+}
+
+// Per second update.
+auto MakeTickPayload() -> Payload
+{
+    auto playback    = PlaybackInfo();
+    playback.Elapsed = 42.0;
+
+    return Payload(std::nullopt, playback, std::nullopt, std::nullopt);
+}
+
+auto AllFields() -> FieldMasks<Payload>
+{
+    auto masks = FieldMasks<Payload>();
+    for (auto& mask : masks.Fields)
+    {
+        mask = ALL_FIELDS;
+    }
+
+    return masks;
+}
+
+// Same key order as WebSocketClient::WriteFrame.
+template <typename Writer>
+auto WriteFrame(Writer& writer, int frame, const Payload& payload, const FieldMasks<Payload>& masks) -> void
+{
+    writer.BeginObject();
+    WriteSections(writer, payload, masks, "", "Frame");
+    writer.Key("Frame");
+    writer.Integer(frame);
+    WriteSections(writer, payload, masks, "Frame", "Token");
+    writer.Key("Token");
+    writer.String(TOKEN);
+    WriteSections(writer, payload, masks, "Token", "");
+    writer.EndObject();
+}
+
+// -------------------------------------------------------------------------- //
+
+// Reference: whole payload as nlohmann::json document, then dumped.
+auto BM_JsonDocument(benchmark::State& state) -> void
+{
+    auto payload = MakeTrackPayload();
+    auto bytes   = std::size_t(0);
+    for (auto _ : state)
+    {
+        auto json     = nlohmann::json(payload);
+        json["Frame"] = 1;
+        json["Token"] = TOKEN;
+
+        auto text = json.dump();
+        bytes = text.size();
+        benchmark::DoNotOptimize(text);
+    }
+
+    state.counters["frame_bytes"] = static_cast<double>(bytes);
+}
+BENCHMARK(BM_JsonDocument);
+
+template <typename Writer>
+auto BM_WriteFrame(benchmark::State& state) -> void
+{
+    auto payload = MakeTrackPayload();
+    auto masks   = AllFields();
+    auto buffer  = std::string();
+    for (auto _ : state)
+    {
+        buffer.clear();
+        auto writer = Writer(buffer);
+        WriteFrame(writer, 1, payload, masks);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.counters["frame_bytes"] = static_cast<double>(buffer.size());
+}
+BENCHMARK_TEMPLATE(BM_WriteFrame, JsonWriter);
+BENCHMARK_TEMPLATE(BM_WriteFrame, CborWriter);
+
+// Delta frame of per second update: diff against previous state, then write.
+auto BM_WriteDeltaFrame(benchmark::State& state) -> void
+{
+    auto before  = MakeTrackPayload();
+    auto after   = MakeTickPayload();
+    auto buffer  = std::string();
+    for (auto _ : state)
+    {
+        auto masks = FieldMasks<Payload>();
+        masks.Fields[FieldIndex(Payload::FieldNames, "Playback")] = DiffFields(before.Playback, after.Playback);
+
+        buffer.clear();
+        auto writer = JsonWriter(buffer);
+        WriteFrame(writer, 2, after, masks);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.counters["frame_bytes"] = static_cast<double>(buffer.size());
+}
+BENCHMARK(BM_WriteDeltaFrame);
+
+// Frame of payload shared by several endpoints, sections encoded by first one.
+auto BM_WriteSharedFrame(benchmark::State& state) -> void
+{
+    auto shared = SharedPayload(MakeTrackPayload());
+    auto masks  = AllFields();
+    auto buffer = std::string();
+    for (auto _ : state)
+    {
+        buffer.clear();
+        auto writer = JsonWriter(buffer);
+        writer.BeginObject();
+        WriteSharedSections(writer, shared.Get(), shared, masks, "", "");
+        writer.EndObject();
+        benchmark::DoNotOptimize(buffer.data());
+    }
+}
+BENCHMARK(BM_WriteSharedFrame);
+
+// Cover sizes: typical embedded art, large scan, high resolution covers.
+auto BM_Base64(benchmark::State& state) -> void
+{
+    auto image  = MakeImage(static_cast<std::size_t>(state.range(0)));
+    auto buffer = std::string();
+    for (auto _ : state)
+    {
+        buffer.clear();
+        Base64Append(image.Data.get(), image.Size, buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * image.Size));
+}
+BENCHMARK(BM_Base64)->Arg(50 << 10)->Arg(500 << 10)->Arg(5 << 20)->Arg(10 << 20);
+
+// Reference: cpp-base64, what Base64Append replaced.
+auto BM_Base64Reference(benchmark::State& state) -> void
+{
+    auto image = MakeImage(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        auto encoded = base64_encode(image.Data.get(), image.Size);
+        benchmark::DoNotOptimize(encoded.data());
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * image.Size));
+}
+BENCHMARK(BM_Base64Reference)->Arg(50 << 10)->Arg(500 << 10)->Arg(5 << 20)->Arg(10 << 20);
+
+auto BM_CompressFrame(benchmark::State& state) -> void
+{
+    auto buffer = std::string();
+    auto writer = JsonWriter(buffer);
+    WriteFrame(writer, 1, MakeTrackPayload(), AllFields());
+
+    auto compressor = FrameCompressor(6);
+    auto size       = std::size_t(0);
+    for (auto _ : state)
+    {
+        auto compressed = compressor.Compress(buffer, CompressionDictionary::Song);
+        size = compressed != nullptr ? compressed->size() : buffer.size();
+        benchmark::DoNotOptimize(compressed);
+    }
+
+    state.counters["frame_bytes"]      = static_cast<double>(buffer.size());
+    state.counters["compressed_bytes"] = static_cast<double>(size);
+}
+BENCHMARK(BM_CompressFrame);
+
+// -------------------------------------------------------------------------- //
+
+// Activation message, token is validated while parsing.
+auto BM_ParseTokenMessage(benchmark::State& state) -> void
+{
+    auto text = std::string("{\"Token\":\"") + TOKEN + "\",\"Features\":[\"Delta\",\"Cbor\",\"CoverHash\",\"Anchor\"]}";
+    for (auto _ : state)
+    {
+        auto message = ParseServerMessage(text);
+        benchmark::DoNotOptimize(message);
+    }
+}
+BENCHMARK(BM_ParseTokenMessage);
+
+auto BM_ParseRequestMessage(benchmark::State& state) -> void
+{
+    auto text = std::string("{\"Request\":\"Cover\",\"Hash\":\"0123456789abcdef\"}");
+    for (auto _ : state)
+    {
+        auto message = ParseServerMessage(text);
+        benchmark::DoNotOptimize(message);
+    }
+}
+BENCHMARK(BM_ParseRequestMessage);
+
+auto BM_ParseUuid(benchmark::State& state) -> void
+{
+    auto text = std::string_view(TOKEN);
+    for (auto _ : state)
+    {
+        auto uuid = ParseUuid(text);
+        benchmark::DoNotOptimize(uuid);
+    }
+}
+BENCHMARK(BM_ParseUuid);
+
+// Output of combined song info script for one track.
+auto BM_ParseSongInfo(benchmark::State& state) -> void
+{
+    auto text = std::string("Track Title Number 7\x1FSome Artist\x1F" "Album 3\x1F" "2019-05-17\x1F" "2019\x1F" "7\x1F" "230.373333\x1F"
+                            "C:\\Users\\Music\\Some Artist\\Album 3\\07 - Track Title Number 7.flac");
+    for (auto _ : state)
+    {
+        auto song = ParseSongInfo(text);
+        benchmark::DoNotOptimize(song);
+    }
+}
+BENCHMARK(BM_ParseSongInfo);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,148 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+// Per track cost of turning titleformat output into SongInfo: eight
+// separate scripts against one combined script. Formatting itself needs
+// foobar2000, so the benchmark starts from already formatted text.
+
+#include "SongInfoFormat.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace foo_showplay;
+
+namespace {
+
+// Titleformat output for one track, as foobar2000 would produce it.
+struct FormattedTrack
+{
+    std::string Fields[8];
+    std::string Combined;
+};
+
+auto MakePlaylist(int count) -> std::vector<FormattedTrack>
+{
+    auto playlist = std::vector<FormattedTrack>(count);
+    for (auto i = 0; i < count; ++i)
+    {
+        auto& track = playlist[i];
+        track.Fields[0] = "Track Title Number " + std::to_string(i);
+        track.Fields[1] = "Some Artist " + std::to_string(i / 100);
+        track.Fields[2] = "Album " + std::to_string(i / 10);
+        track.Fields[3] = i % 3 == 0 ? "?" : "2019-05-17";
+        track.Fields[4] = "2019";
+        track.Fields[5] = std::to_string(i % 10 + 1);
+        track.Fields[6] = std::to_string(180 + i % 120) + ".373333";
+        track.Fields[7] = "C:\\Users\\Music\\Some Artist " + std::to_string(i / 100) + "\\Album " +
+                          std::to_string(i / 10) + "\\Track Title Number " + std::to_string(i) + ".flac";
+
+        for (auto j = 0; j < 8; ++j)
+        {
+            if (j > 0)
+            {
+                track.Combined.push_back(SONG_INFO_SEPARATOR);
+            }
+            track.Combined.append(track.Fields[j]);
+        }
+    }
+
+    return playlist;
+}
+
+// Previous path: one string per script, then atof/atoi.
+auto ParseSeparate(const FormattedTrack& track) -> SongInfo
+{
+    auto get = [&](int index) -> std::optional<std::string>
+    {
+        auto info = std::string(track.Fields[index]);
+        return info != "?" ? info : std::optional<std::string>(std::nullopt);
+    };
+
+    auto song   = SongInfo();
+    song.Title  = get(0);
+    song.Artist = get(1);
+    song.Album  = get(2);
+    song.Date   = get(3);
+    song.Year   = get(4);
+    song.Path   = get(7);
+
+    auto lengthStr = get(6);
+    if (lengthStr.has_value())
+    {
+        song.Length = std::atof(lengthStr.value().c_str());
+    }
+
+    auto trackNumberStr = get(5);
+    if (trackNumberStr.has_value())
+    {
+        song.TrackNumber = std::atoi(trackNumberStr.value().c_str());
+    }
+
+    return song;
+}
+
+template <typename Parse>
+auto Measure(const char* name, const std::vector<FormattedTrack>& playlist, Parse&& parse) -> void
+{
+    static constexpr auto ROUNDS = 20;
+
+    auto checksum = 0.0;
+    auto start    = std::chrono::steady_clock::now();
+    for (auto round = 0; round < ROUNDS; ++round)
+    {
+        for (const auto& track : playlist)
+        {
+            auto song = parse(track);
+            checksum += song.Length.value_or(0.0) + song.TrackNumber.value_or(0) + song.Title->size();
+        }
+    }
+
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-10s %10.1f ns/track (checksum %.0f)\n", name, elapsed / (ROUNDS * playlist.size()), checksum);
+}
+
+} // namespace
+
+int main()
+{
+    auto playlist = MakePlaylist(10000);
+
+    // Both paths must agree before their speed is compared.
+    for (const auto& track : playlist)
+    {
+        auto separate = std::optional<SongInfo>(ParseSeparate(track));
+        auto combined = std::optional<SongInfo>(ParseSongInfo(track.Combined));
+        if (DiffFields(separate, combined) != 0)
+        {
+            std::fprintf(stderr, "Parsed songs differ.\n");
+            return 1;
+        }
+    }
+
+    std::printf("%zu tracks, script: %zu bytes\n\n", playlist.size(), GetSongInfoScript().size());
+    Measure("separate", playlist, ParseSeparate);
+    Measure("combined", playlist, [](const FormattedTrack& track) { return ParseSongInfo(track.Combined); });
+
+    return 0;
+}
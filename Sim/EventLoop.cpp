@@ -0,0 +1,103 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "EventLoop.hpp"
+
+#include <cstdio>
+
+namespace foo_showplay {
+
+EventLoop::EventLoop(bool isVerbose)
+    : mTimerTime (std::nullopt)
+    , mStartTime (Clock::now())
+    , mIsVerbose (isVerbose)
+{
+}
+
+auto EventLoop::InMainThread(std::function<void()> task) -> void
+{
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        mTasks.push_back(std::move(task));
+    }
+
+    mCondition.notify_one();
+}
+
+auto EventLoop::StartTimer(std::chrono::milliseconds delay, std::function<void()> callback) -> void
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    mTimerTime     = Clock::now() + delay;
+    mTimerCallback = std::move(callback);
+}
+
+auto EventLoop::StopTimer() -> void
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    mTimerTime.reset();
+    mTimerCallback = nullptr;
+}
+
+auto EventLoop::Log(const std::string& message) -> void
+{
+    if (mIsVerbose)
+    {
+        auto elapsed = std::chrono::duration<double>(Clock::now() - mStartTime).count();
+        std::printf("[%9.3f] %s\n", elapsed, message.c_str());
+    }
+}
+
+auto EventLoop::RunUntil(Clock::time_point deadline) -> void
+{
+    for (;;)
+    {
+        auto task = std::function<void()>();
+        {
+            auto lock = std::unique_lock<std::mutex>(mMutex);
+
+            auto isTimerDue = [this]() { return mTimerTime.has_value() && mTimerTime.value() <= Clock::now(); };
+            auto wakeTime   = mTimerTime.has_value() ? std::min(mTimerTime.value(), deadline) : deadline;
+            mCondition.wait_until(lock, wakeTime, [&]() { return !mTasks.empty() || isTimerDue(); });
+
+            if (!mTasks.empty())
+            {
+                task = std::move(mTasks.front());
+                mTasks.pop_front();
+            }
+            else if (isTimerDue())
+            {
+                // One shot, callback may start it again.
+                task = std::move(mTimerCallback);
+                mTimerTime.reset();
+                mTimerCallback = nullptr;
+            }
+            else if (Clock::now() >= deadline)
+            {
+                return;
+            }
+        }
+
+        if (task)
+        {
+            task();
+        }
+    }
+}
+
+} // namespace foo_showplay
@@ -0,0 +1,63 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+
+#include "Player.hpp"
+
+namespace foo_showplay {
+
+// Main thread of simulator. Tasks and the timer run on the thread calling
+// RunUntil, the way foobar2000 runs them on its main thread.
+class EventLoop : public Host
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    std::mutex                        mMutex;
+    std::condition_variable           mCondition;
+    std::deque<std::function<void()>> mTasks;
+    std::optional<Clock::time_point>  mTimerTime;
+    std::function<void()>             mTimerCallback;
+    Clock::time_point                 mStartTime;
+    bool                              mIsVerbose;
+
+public:
+    EventLoop(bool isVerbose);
+
+    auto InMainThread    (std::function<void()> task) -> void override;
+    auto StartTimer      (std::chrono::milliseconds delay, std::function<void()> callback) -> void override;
+    auto StopTimer       () -> void override;
+    auto Log             (const std::string& message) -> void override;
+    auto OnStatusChanged () -> void override {}
+
+    // Runs tasks and timer as they come until deadline.
+    auto RunUntil   (Clock::time_point deadline) -> void;
+    auto RunPending () -> void { RunUntil(Clock::now()); }
+};
+
+} // namespace foo_showplay
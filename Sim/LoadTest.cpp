@@ -0,0 +1,682 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+// Runs many simulated clients against local server stand-in and reports how
+// long events take from player to server.
+//
+//     showplay_load [options]
+//
+//     --clients <count>     Simulated clients, default 10.
+//     --script <file>       Timeline script, see Timeline.hpp.
+//     --tracks <count>      Generated timeline, default 3 tracks.
+//     --length <seconds>    Track length of generated timeline, default 30.
+//     --speed <factor>      Playback speed, 0 is as fast as possible. Default 1.
+//     --features <list>     Advertised by server, default Delta,CoverHash.
+//     --max-rate <fps>      Max send rate, default as in preferences.
+//     --ramp <seconds>      Clients start spread over this time, default 1.
+//     --port <port>         Server port, default 8590.
+//
+// Latency is measured from the moment player reports new track, time or seek
+// to the moment server receives frame with its title or position. Events
+// merged with later ones never arrive on their own and are not measured.
+// Anchor feature is not useful here, it replaces time events. With Ack
+// feature client side round trip is reported too.
+//
+// Server stand-in runs in forked child process, so CPU reported per client
+// doesn't include server sockets and threads. Child reports every frame it
+// decoded over pipe, stamped with its arrival time. Steady clock is
+// monotonic clock of the whole system, times of both processes compare.
+//
+// Not yet verified end to end. So far it ran only against IXWebSocket stub
+// that never connects: fork, pipes and report came out right, with no client
+// activated and no frame received. Figures are not to be quoted until a run
+// against real IXWebSocket with every client activated is recorded. Run with
+// any client not activated exits with failure and says so.
+
+#include "EventLoop.hpp"
+#include "Session.hpp"
+#include "SimulatedPlayer.hpp"
+#include "TestServer.hpp"
+#include "Timeline.hpp"
+#include "Constants.hpp"
+
+#include <ixwebsocket/IXNetSystem.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace foo_showplay;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::size_t              Clients  = 10;
+    std::string              Script;
+    std::size_t              Tracks   = 3;
+    double                   Length   = 30.0;
+    double                   Speed    = 1.0;
+    std::vector<std::string> Features = { FEATURE_DELTA, FEATURE_COVER_HASH };
+    int                      MaxRate  = DEFAULT_MAX_SEND_RATE;
+    double                   Ramp     = 1.0;
+    int                      Port     = 8590;
+};
+
+// Events of one client waiting for server, matched by what frame carries.
+class ClientRecord
+{
+    std::mutex                                         mMutex;
+    std::unordered_map<std::string, Clock::time_point> mTitles;
+    std::map<double, Clock::time_point>                mPositions;
+    std::vector<std::int64_t>                          mLatencies; // In microseconds.
+    std::uint64_t                                      mEvents;
+
+public:
+    ClientRecord()
+        : mEvents (0)
+    {
+    }
+
+    auto OnEvent(const Timeline& timeline, const TimelineEvent& event) -> void
+    {
+        auto now  = Clock::now();
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        switch (event.Type)
+        {
+        case TimelineEventType::Track:
+            mTitles[timeline.Tracks[event.Track].Song.Title.value_or("")] = now;
+            mEvents += 1;
+            break;
+
+        case TimelineEventType::Time:
+        case TimelineEventType::Seek:
+            mPositions[event.Position] = now;
+            mEvents += 1;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    auto OnFrame(const nlohmann::json& frame, Clock::time_point received) -> void
+    {
+        auto lock   = std::lock_guard<std::mutex>(mMutex);
+        auto record = [&](Clock::time_point sent)
+        {
+            mLatencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(received - sent).count());
+        };
+
+        auto song = frame.find("Song");
+        if (song != frame.end() && song->is_object())
+        {
+            auto title = song->find("Title");
+            if (title != song->end() && title->is_string())
+            {
+                auto it = mTitles.find(title->get<std::string>());
+                if (it != mTitles.end())
+                {
+                    record(it->second);
+                    mTitles.erase(it);
+                }
+            }
+        }
+
+        auto playback = frame.find("Playback");
+        if (playback != frame.end() && playback->is_object())
+        {
+            auto elapsed = playback->find("Elapsed");
+            if (elapsed != playback->end() && elapsed->is_number())
+            {
+                auto it = mPositions.find(elapsed->get<double>());
+                if (it != mPositions.end())
+                {
+                    record(it->second);
+                    mPositions.erase(it);
+                }
+            }
+        }
+    }
+
+    auto GetEventCount () -> std::uint64_t
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        return mEvents;
+    }
+
+    auto GetLatencies () -> std::vector<std::int64_t>
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        return mLatencies;
+    }
+};
+
+struct ClientResult
+{
+    bool          IsActivated = false;
+    std::uint64_t Merged      = 0;
+    std::uint64_t Dropped     = 0;
+    std::uint64_t Acked       = 0;
+    std::uint64_t Lost        = 0;
+    std::uint64_t Stuck       = 0;
+    std::int64_t  RoundTrip   = 0; // p99, in microseconds.
+};
+
+auto ParseList(const std::string& list) -> std::vector<std::string>
+{
+    auto result = std::vector<std::string>();
+    auto start  = std::size_t(0);
+    while (start <= list.size())
+    {
+        auto end = std::min(list.find(',', start), list.size());
+        if (end > start)
+        {
+            result.push_back(list.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+
+    return result;
+}
+
+auto ParseOptions(int argc, char** argv) -> std::optional<Options>
+{
+    auto options = Options();
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto arg = std::string(argv[i]);
+        if (i + 1 >= argc)
+        {
+            return std::nullopt;
+        }
+
+        if      (arg == "--clients")  { options.Clients  = std::strtoul(argv[++i], nullptr, 10); }
+        else if (arg == "--script")   { options.Script   = argv[++i]; }
+        else if (arg == "--tracks")   { options.Tracks   = std::strtoul(argv[++i], nullptr, 10); }
+        else if (arg == "--length")   { options.Length   = std::atof(argv[++i]); }
+        else if (arg == "--speed")    { options.Speed    = std::atof(argv[++i]); }
+        else if (arg == "--features") { options.Features = ParseList(argv[++i]); }
+        else if (arg == "--max-rate") { options.MaxRate  = std::atoi(argv[++i]); }
+        else if (arg == "--ramp")     { options.Ramp     = std::atof(argv[++i]); }
+        else if (arg == "--port")     { options.Port     = std::atoi(argv[++i]); }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    if (options.Clients == 0)
+    {
+        return std::nullopt;
+    }
+
+    return options;
+}
+
+auto LoadTimeline(const Options& options) -> std::optional<Timeline>
+{
+    if (options.Script.empty())
+    {
+        return GenerateTimeline(options.Tracks, options.Length);
+    }
+
+    auto file = std::ifstream(options.Script);
+    if (!file)
+    {
+        std::fprintf(stderr, "Can't open %s\n", options.Script.c_str());
+        return std::nullopt;
+    }
+
+    auto errorLine = std::size_t(0);
+    auto timeline  = ParseTimeline(file, errorLine);
+    if (!timeline.has_value())
+    {
+        std::fprintf(stderr, "%s:%zu: invalid timeline event\n", options.Script.c_str(), errorLine);
+    }
+
+    return timeline;
+}
+
+auto GetProcessCpuTime() -> std::chrono::microseconds
+{
+    auto usage = rusage();
+    getrusage(RUSAGE_SELF, &usage);
+
+    auto toMicroseconds = [](const timeval& time)
+    {
+        return std::chrono::seconds(time.tv_sec) + std::chrono::microseconds(time.tv_usec);
+    };
+
+    return toMicroseconds(usage.ru_utime) + toMicroseconds(usage.ru_stime);
+}
+
+auto GetThreadCpuTime(std::thread& thread) -> std::chrono::microseconds
+{
+    auto clock = clockid_t();
+    auto time  = timespec();
+    if (pthread_getcpuclockid(thread.native_handle(), &clock) != 0 || clock_gettime(clock, &time) != 0)
+    {
+        return std::chrono::microseconds(0);
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec));
+}
+
+struct ServerStats
+{
+    std::uint64_t Frames    = 0;
+    std::uint64_t Bytes     = 0;
+    std::uint64_t Undecoded = 0;
+};
+
+// TestServer in child process. Lines written by child:
+//
+//     R <0|1>                          Listening or not, first line.
+//     F <client> <received> <frame>    Decoded frame, received in steady clock ns.
+//     S <frames> <bytes> <undecoded>   Totals, last line.
+//
+// Child stops when parent closes its end of control pipe.
+class ServerProcess
+{
+public:
+    using OnFrameCallback = std::function<void(std::size_t client, const nlohmann::json& frame, Clock::time_point received)>;
+
+private:
+    pid_t mPid;
+    FILE* mReports;
+    int   mControl;
+
+    static auto Serve(const Options& options, FILE* reports, int control) -> bool
+    {
+        auto mutex  = std::mutex();
+        auto server = TestServer(options.Port, options.Clients + 1, options.Features);
+        server.SetOnFrameCallback([&mutex, reports](std::size_t client, const nlohmann::json& frame, Clock::time_point received)
+        {
+            auto line = frame.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+            auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(received.time_since_epoch()).count();
+            auto lock = std::lock_guard<std::mutex>(mutex);
+            std::fprintf(reports, "F %zu %" PRId64 " %s\n", client, static_cast<std::int64_t>(time), line.c_str());
+            std::fflush(reports);
+        });
+
+        auto isListening = server.Start();
+        std::fprintf(reports, "R %d\n", isListening ? 1 : 0);
+        std::fflush(reports);
+        if (!isListening)
+        {
+            return false;
+        }
+
+        auto byte = char();
+        while (read(control, &byte, 1) > 0)
+        {
+        }
+
+        server.Stop();
+        std::fprintf(reports, "S %" PRIu64 " %" PRIu64 " %" PRIu64 "\n",
+            server.GetFrameCount(), server.GetByteCount(), server.GetUndecodedCount());
+        return true;
+    }
+
+    auto ReadLine(std::string& line) -> bool
+    {
+        line.clear();
+        auto c = 0;
+        while ((c = std::fgetc(mReports)) != EOF && c != '\n')
+        {
+            line.push_back(static_cast<char>(c));
+        }
+
+        return c != EOF || !line.empty();
+    }
+
+public:
+    ServerProcess()
+        : mPid     (-1)
+        , mReports (nullptr)
+        , mControl (-1)
+    {
+    }
+
+    ~ServerProcess()
+    {
+        Stop();
+        if (mReports != nullptr)
+        {
+            std::fclose(mReports);
+        }
+
+        if (mPid > 0)
+        {
+            waitpid(mPid, nullptr, 0);
+        }
+    }
+
+    // Must be called before any thread is started, child gets copy of caller
+    // only. Returns when server listens or failed to.
+    auto Start(const Options& options) -> bool
+    {
+        int reports[2];
+        int control[2];
+        if (pipe(reports) != 0)
+        {
+            return false;
+        }
+
+        if (pipe(control) != 0)
+        {
+            close(reports[0]);
+            close(reports[1]);
+            return false;
+        }
+
+        std::fflush(nullptr);
+        mPid = fork();
+        if (mPid == 0)
+        {
+            close(reports[0]);
+            close(control[1]);
+
+            auto output = fdopen(reports[1], "w");
+            auto isDone = output != nullptr && ix::initNetSystem() && Serve(options, output, control[0]);
+            if (output != nullptr)
+            {
+                std::fclose(output);
+            }
+
+            _exit(isDone ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+
+        close(reports[1]);
+        close(control[0]);
+        mControl = control[1];
+        mReports = mPid > 0 ? fdopen(reports[0], "r") : nullptr;
+        if (mReports == nullptr)
+        {
+            close(reports[0]);
+            return false;
+        }
+
+        auto line = std::string();
+        return ReadLine(line) && line == "R 1";
+    }
+
+    // Calls back with every frame until child exits, returns its totals.
+    auto Read(const OnFrameCallback& callback) -> ServerStats
+    {
+        auto stats = ServerStats();
+        auto line  = std::string();
+        while (ReadLine(line))
+        {
+            if (line.size() > 2 && line[0] == 'F')
+            {
+                auto end      = static_cast<char*>(nullptr);
+                auto client   = std::strtoull(line.c_str() + 2, &end, 10);
+                auto received = std::strtoll(end, &end, 10);
+                auto frame    = nlohmann::json::parse(static_cast<const char*>(end), line.c_str() + line.size(), nullptr, false);
+                if (frame.is_object())
+                {
+                    callback(static_cast<std::size_t>(client), frame, Clock::time_point(std::chrono::nanoseconds(received)));
+                }
+            }
+            else if (line.size() > 2 && line[0] == 'S')
+            {
+                std::sscanf(line.c_str(), "S %" SCNu64 " %" SCNu64 " %" SCNu64, &stats.Frames, &stats.Bytes, &stats.Undecoded);
+            }
+        }
+
+        return stats;
+    }
+
+    // Child sends totals and exits, Read returns after that.
+    auto Stop() -> void
+    {
+        if (mControl >= 0)
+        {
+            close(mControl);
+            mControl = -1;
+        }
+    }
+};
+
+// One client with its own main thread, as if it was separate foobar2000.
+auto RunClient(std::size_t index, const Options& options, const Timeline& timeline, ClientRecord& record) -> ClientResult
+{
+    static constexpr auto ACTIVATION_TIMEOUT = std::chrono::seconds(5);
+    static constexpr auto DRAIN_TIME         = std::chrono::seconds(1);
+
+    auto loop     = EventLoop(false);
+    auto player   = SimulatedPlayer(timeline, options.Speed);
+    auto settings = ReconnectSettings(
+        std::chrono::milliseconds(DEFAULT_RECONNECT_BASE_DELAY),
+        std::chrono::milliseconds(DEFAULT_RECONNECT_MAX_DELAY),
+        std::chrono::seconds(DEFAULT_PING_INTERVAL),
+        std::chrono::seconds(DEFAULT_DEAD_PEER_TIMEOUT),
+        CIRCUIT_FAILURE_THRESHOLD
+    );
+
+    auto session = ShowPlaySession(player, loop, []() { return std::unique_ptr<ImageCodec>(); }, settings);
+    session.SetMaxSendRate(options.MaxRate);
+    session.Connect("ws://127.0.0.1:" + std::to_string(options.Port) + "/client/" + std::to_string(index));
+
+    // Token means server is ready for frames.
+    auto result  = ClientResult();
+    auto waitEnd = Clock::now() + ACTIVATION_TIMEOUT;
+    while (!session.GetToken().has_value() && Clock::now() < waitEnd)
+    {
+        loop.RunUntil(Clock::now() + std::chrono::milliseconds(10));
+    }
+
+    result.IsActivated = session.GetToken().has_value();
+    if (result.IsActivated)
+    {
+        player.SetOnEventCallback([&record, &timeline](const TimelineEvent& event) { record.OnEvent(timeline, event); });
+        player.Play(session, loop);
+        loop.RunUntil(Clock::now() + DRAIN_TIME);
+    }
+
+    const auto& metrics = session.GetMetrics();
+    result.Merged    = session.GetMergedCount();
+    result.Dropped   = session.GetDroppedCount();
+    result.Acked     = metrics.RoundTripTime.GetCount();
+    result.Lost      = metrics.FramesLost.Get();
+    result.Stuck     = metrics.FramesStuck.Get();
+    result.RoundTrip = metrics.RoundTripTime.GetPercentile(0.99).count();
+
+    session.Disconnect();
+    return result;
+}
+
+auto Percentile(const std::vector<std::int64_t>& sorted, double percentile) -> std::int64_t
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+
+    auto index = static_cast<std::size_t>(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto options = ParseOptions(argc, argv);
+    if (!options.has_value())
+    {
+        std::fprintf(stderr, "usage: %s [--clients n] [--script file] [--tracks n] [--length s] [--speed x] "
+                             "[--features a,b] [--max-rate fps] [--ramp s] [--port n]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto timeline = LoadTimeline(options.value());
+    if (!timeline.has_value())
+    {
+        return EXIT_FAILURE;
+    }
+
+    // Forked before any thread exists.
+    auto server = ServerProcess();
+    if (!server.Start(options.value()))
+    {
+        std::fprintf(stderr, "Can't listen on port %d\n", options->Port);
+        return EXIT_FAILURE;
+    }
+
+    if (!ix::initNetSystem())
+    {
+        std::fprintf(stderr, "Failed to ix::initNetSystem()\n");
+        return EXIT_FAILURE;
+    }
+
+    auto records = std::vector<std::unique_ptr<ClientRecord>>();
+    for (auto i = std::size_t(0); i < options->Clients; ++i)
+    {
+        records.push_back(std::make_unique<ClientRecord>());
+    }
+
+    // Matches frames with events, its CPU time is not client's.
+    auto stats  = ServerStats();
+    auto reader = std::thread([&server, &records, &stats]()
+    {
+        stats = server.Read([&records](std::size_t client, const nlohmann::json& frame, Clock::time_point received)
+        {
+            if (client < records.size())
+            {
+                records[client]->OnFrame(frame, received);
+            }
+        });
+    });
+
+    auto cpuStart    = GetProcessCpuTime();
+    auto readerStart = GetThreadCpuTime(reader);
+    auto wallStart   = Clock::now();
+
+    auto results = std::vector<ClientResult>(options->Clients);
+    auto threads = std::vector<std::thread>();
+    for (auto i = std::size_t(0); i < options->Clients; ++i)
+    {
+        auto delay = std::chrono::duration<double>(options->Ramp * i / options->Clients);
+        threads.emplace_back([&, i, delay]()
+        {
+            std::this_thread::sleep_for(delay);
+            results[i] = RunClient(i, options.value(), timeline.value(), *records[i]);
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto wallTime = std::chrono::duration<double>(Clock::now() - wallStart).count();
+    auto cpuTime  = GetProcessCpuTime() - cpuStart - (GetThreadCpuTime(reader) - readerStart);
+
+    server.Stop();
+    reader.join();
+    ix::uninitNetSystem();
+
+    // Everything measured, summed over clients.
+    auto latencies = std::vector<std::int64_t>();
+    auto events    = std::uint64_t(0);
+    auto activated = std::size_t(0);
+    auto merged    = std::uint64_t(0);
+    auto dropped   = std::uint64_t(0);
+    auto acked     = std::uint64_t(0);
+    auto lost      = std::uint64_t(0);
+    auto stuck     = std::uint64_t(0);
+    auto roundTrip = std::int64_t(0);
+    for (auto i = std::size_t(0); i < options->Clients; ++i)
+    {
+        auto clientLatencies = records[i]->GetLatencies();
+        latencies.insert(latencies.end(), clientLatencies.begin(), clientLatencies.end());
+        events    += records[i]->GetEventCount();
+        activated += results[i].IsActivated ? 1 : 0;
+        merged    += results[i].Merged;
+        dropped   += results[i].Dropped;
+        acked     += results[i].Acked;
+        lost      += results[i].Lost;
+        stuck     += results[i].Stuck;
+        roundTrip  = std::max(roundTrip, results[i].RoundTrip);
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    auto clientCpu = std::chrono::duration<double>(cpuTime).count();
+    auto frames    = stats.Frames;
+    auto bytes     = stats.Bytes;
+
+    std::printf("clients        %zu (%zu activated)\n", options->Clients, activated);
+    std::printf("duration       %.3f s\n", wallTime);
+    std::printf("events         %llu (%llu measured, %llu merged, %llu dropped)\n",
+        static_cast<unsigned long long>(events),
+        static_cast<unsigned long long>(latencies.size()),
+        static_cast<unsigned long long>(merged),
+        static_cast<unsigned long long>(dropped));
+    std::printf("frames         %llu (%.1f/s, %llu undecoded)\n",
+        static_cast<unsigned long long>(frames), frames / wallTime,
+        static_cast<unsigned long long>(stats.Undecoded));
+    std::printf("bytes          %llu (%.1f KiB/s)\n",
+        static_cast<unsigned long long>(bytes), bytes / wallTime / 1024.0);
+    std::printf("latency        p50 %lld us, p90 %lld us, p99 %lld us, max %lld us\n",
+        static_cast<long long>(Percentile(latencies, 50.0)),
+        static_cast<long long>(Percentile(latencies, 90.0)),
+        static_cast<long long>(Percentile(latencies, 99.0)),
+        static_cast<long long>(latencies.empty() ? 0 : latencies.back()));
+    if (acked > 0)
+    {
+        std::printf("round trip     p99 %lld us worst client, %llu acked, %llu lost, %llu stuck\n",
+            static_cast<long long>(roundTrip),
+            static_cast<unsigned long long>(acked),
+            static_cast<unsigned long long>(lost),
+            static_cast<unsigned long long>(stuck));
+    }
+    std::printf("cpu per client %.3f ms (%.3f%% of one core)\n",
+        clientCpu * 1000.0 / options->Clients, clientCpu * 100.0 / wallTime / options->Clients);
+
+    // Idle clients cost next to nothing, figures would look better than any
+    // real run.
+    if (activated != options->Clients)
+    {
+        std::fprintf(stderr, "%zu of %zu clients never activated, figures don't describe real load\n",
+            options->Clients - activated, options->Clients);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+// Drives ShowPlay session with simulated player, so client core runs and is
+// load tested without foobar2000.
+//
+//     showplay_sim [options] <server urls separated by ';'>
+//
+//     --script <file>     Timeline script, see Timeline.hpp.
+//     --tracks <count>    Generated timeline, default 8 tracks.
+//     --length <seconds>  Track length of generated timeline, default 180.
+//     --speed <factor>    Playback speed, 0 is as fast as possible. Default 1.
+//     --max-rate <fps>    Max send rate, default as in preferences.
+//     --wait <seconds>    Time to connect before playing, default 5.
+//     --quiet             No log.
+
+#include "EventLoop.hpp"
+#include "Session.hpp"
+#include "SimulatedPlayer.hpp"
+#include "Timeline.hpp"
+#include "Constants.hpp"
+
+#if defined(SHOWPLAY_PORTABLE_CODEC)
+    #include "PortableImageCodec.hpp"
+#endif
+
+#include <ixwebsocket/IXNetSystem.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+using namespace foo_showplay;
+
+namespace {
+
+struct Options
+{
+    std::string Urls;
+    std::string Script;
+    std::size_t Tracks  = 8;
+    double      Length  = 180.0;
+    double      Speed   = 1.0;
+    int         MaxRate = DEFAULT_MAX_SEND_RATE;
+    double      Wait    = 5.0;
+    bool        IsQuiet = false;
+};
+
+auto ParseOptions(int argc, char** argv) -> std::optional<Options>
+{
+    auto options = Options();
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto arg    = std::string(argv[i]);
+        auto isLast = i + 1 >= argc;
+        if (arg == "--quiet")
+        {
+            options.IsQuiet = true;
+        }
+        else if (arg.rfind("--", 0) == 0 && isLast)
+        {
+            return std::nullopt;
+        }
+        else if (arg == "--script")   { options.Script  = argv[++i]; }
+        else if (arg == "--tracks")   { options.Tracks  = std::strtoul(argv[++i], nullptr, 10); }
+        else if (arg == "--length")   { options.Length  = std::atof(argv[++i]); }
+        else if (arg == "--speed")    { options.Speed   = std::atof(argv[++i]); }
+        else if (arg == "--max-rate") { options.MaxRate = std::atoi(argv[++i]); }
+        else if (arg == "--wait")     { options.Wait    = std::atof(argv[++i]); }
+        else if (arg.rfind("--", 0) == 0)
+        {
+            return std::nullopt;
+        }
+        else
+        {
+            options.Urls = arg;
+        }
+    }
+
+    if (options.Urls.empty())
+    {
+        return std::nullopt;
+    }
+
+    return options;
+}
+
+auto LoadTimeline(const Options& options) -> std::optional<Timeline>
+{
+    if (options.Script.empty())
+    {
+        return GenerateTimeline(options.Tracks, options.Length);
+    }
+
+    auto file = std::ifstream(options.Script);
+    if (!file)
+    {
+        std::fprintf(stderr, "Can't open %s\n", options.Script.c_str());
+        return std::nullopt;
+    }
+
+    auto errorLine = std::size_t(0);
+    auto timeline  = ParseTimeline(file, errorLine);
+    if (!timeline.has_value())
+    {
+        std::fprintf(stderr, "%s:%zu: invalid timeline event\n", options.Script.c_str(), errorLine);
+    }
+
+    return timeline;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto options = ParseOptions(argc, argv);
+    if (!options.has_value())
+    {
+        std::fprintf(stderr, "usage: %s [--script file] [--tracks n] [--length s] [--speed x] [--max-rate fps] [--wait s] [--quiet] urls\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto timeline = LoadTimeline(options.value());
+    if (!timeline.has_value())
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (!ix::initNetSystem())
+    {
+        std::fprintf(stderr, "Failed to ix::initNetSystem()\n");
+        return EXIT_FAILURE;
+    }
+
+    {
+        auto loop     = EventLoop(!options->IsQuiet);
+        auto player   = SimulatedPlayer(timeline.value(), options->Speed);
+        auto settings = ReconnectSettings(
+            std::chrono::milliseconds(DEFAULT_RECONNECT_BASE_DELAY),
+            std::chrono::milliseconds(DEFAULT_RECONNECT_MAX_DELAY),
+            std::chrono::seconds(DEFAULT_PING_INTERVAL),
+            std::chrono::seconds(DEFAULT_DEAD_PEER_TIMEOUT),
+            CIRCUIT_FAILURE_THRESHOLD
+        );
+
+        // Without codec covers are sent as stored.
+        auto session = ShowPlaySession(player, loop, []() -> std::unique_ptr<ImageCodec>
+        {
+#if defined(SHOWPLAY_PORTABLE_CODEC)
+            return std::make_unique<PortableImageCodec>();
+#else
+            return nullptr;
+#endif
+        }, settings);
+        session.SetMaxSendRate(options->MaxRate);
+        session.Connect(options->Urls);
+
+        // Servers that are up by then get events live, later ones snapshot.
+        auto waitEnd = EventLoop::Clock::now() + std::chrono::duration_cast<EventLoop::Clock::duration>(std::chrono::duration<double>(options->Wait));
+        while (session.GetConnectionStatus() != "Connected" && EventLoop::Clock::now() < waitEnd)
+        {
+            loop.RunUntil(EventLoop::Clock::now() + std::chrono::milliseconds(10));
+        }
+
+        auto start = EventLoop::Clock::now();
+        player.Play(session, loop);
+        auto elapsed = std::chrono::duration<double>(EventLoop::Clock::now() - start).count();
+
+        // Let senders drain.
+        loop.RunUntil(EventLoop::Clock::now() + std::chrono::milliseconds(500));
+
+        std::printf("events      %zu in %.3f s\n", timeline->Events.size(), elapsed);
+        std::printf("status      %s\n", session.GetConnectionStatus().c_str());
+        std::printf("queue depth %zu\n", session.GetSendQueueDepth());
+        std::printf("latency     %lld us (max %lld us)\n",
+            static_cast<long long>(session.GetSendLatency().count()),
+            static_cast<long long>(session.GetMaxSendLatency().count()));
+        std::printf("merged      %llu\n", static_cast<unsigned long long>(session.GetMergedCount()));
+        std::printf("dropped     %llu\n", static_cast<unsigned long long>(session.GetDroppedCount()));
+        std::printf("metrics     %s\n", session.GetMetrics().Format().c_str());
+
+        session.Disconnect();
+    }
+
+    ix::uninitNetSystem();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "SimulatedPlayer.hpp"
+
+#include <algorithm>
+
+namespace foo_showplay {
+
+SimulatedPlayer::SimulatedPlayer(const Timeline& timeline, double speed)
+    : mTimeline     (timeline)
+    , mSpeed        (std::max(speed, 0.0))
+    , mTrack        (std::nullopt)
+    , mState        (PlaybackState::Nothing)
+    , mPosition     (0.0)
+    , mPositionTime (EventLoop::Clock::now())
+{
+}
+
+auto SimulatedPlayer::GetPosition() -> double
+{
+    if (mState != PlaybackState::Playing || mSpeed == 0.0)
+    {
+        return mPosition;
+    }
+
+    // Moves between time events too, like real player does.
+    auto elapsed = std::chrono::duration<double>(EventLoop::Clock::now() - mPositionTime).count();
+    return mPosition + elapsed * mSpeed;
+}
+
+auto SimulatedPlayer::GetSong() -> std::optional<SongInfo>
+{
+    if (!mTrack.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return mTimeline.Tracks[mTrack.value()].Song;
+}
+
+auto SimulatedPlayer::GetCover() -> std::optional<BinaryData>
+{
+    if (!mTrack.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return mTimeline.Tracks[mTrack.value()].Cover;
+}
+
+auto SimulatedPlayer::GetFields() -> std::optional<CustomFields>
+{
+    if (mSchema.empty() || !mTrack.has_value())
+    {
+        return std::nullopt;
+    }
+
+    // Only plain %tag% expressions, anything else is missing field.
+    const auto& tags = mTimeline.Tracks[mTrack.value()].Tags;
+
+    auto fields = CustomFields();
+    fields.Values.reserve(mSchema.size());
+    for (const auto& field : mSchema)
+    {
+        auto formatted  = std::string("?");
+        auto expression = std::string_view(field.Expression);
+        if (expression.size() > 2 && expression.front() == '%' && expression.back() == '%')
+        {
+            auto it = tags.find(std::string(expression.substr(1, expression.size() - 2)));
+            if (it != tags.end())
+            {
+                formatted = it->second;
+            }
+        }
+
+        fields.Values.push_back(CustomField{ field.Name, ParseFieldValue(formatted, field.Type), field.Expression, field.Type });
+    }
+
+    return fields;
+}
+
+auto SimulatedPlayer::SetPosition(double position) -> void
+{
+    mPosition     = position;
+    mPositionTime = EventLoop::Clock::now();
+}
+
+auto SimulatedPlayer::Apply(const TimelineEvent& event, ShowPlaySession& session) -> void
+{
+    if (mOnEventCallback)
+    {
+        mOnEventCallback(event);
+    }
+
+    switch (event.Type)
+    {
+    case TimelineEventType::Track:
+        mTrack = event.Track;
+        mState = PlaybackState::Playing;
+        SetPosition(0.0);
+        session.OnNewTrack(GetSong(), GetFields());
+        break;
+
+    case TimelineEventType::AlbumArt:
+        session.OnAlbumArt();
+        break;
+
+    case TimelineEventType::Time:
+        SetPosition(event.Position);
+        session.OnTime(event.Position);
+        break;
+
+    case TimelineEventType::Seek:
+        SetPosition(event.Position);
+        session.OnSeek(event.Position);
+        break;
+
+    case TimelineEventType::Pause:
+        SetPosition(GetPosition());
+        mState = PlaybackState::Paused;
+        session.OnPause(true);
+        break;
+
+    case TimelineEventType::Resume:
+        SetPosition(mPosition);
+        mState = PlaybackState::Playing;
+        session.OnPause(false);
+        break;
+
+    case TimelineEventType::Stop:
+        mTrack = std::nullopt;
+        mState = PlaybackState::Nothing;
+        SetPosition(0.0);
+        session.OnStop();
+        break;
+    }
+}
+
+auto SimulatedPlayer::Play(ShowPlaySession& session, EventLoop& loop) -> void
+{
+    auto start = EventLoop::Clock::now();
+    for (const auto& event : mTimeline.Events)
+    {
+        if (mSpeed > 0.0)
+        {
+            auto offset = std::chrono::duration<double>(event.Time / mSpeed);
+            loop.RunUntil(start + std::chrono::duration_cast<EventLoop::Clock::duration>(offset));
+        }
+        else
+        {
+            loop.RunPending();
+        }
+
+        Apply(event, session);
+    }
+
+    loop.RunPending();
+}
+
+} // namespace foo_showplay
@@ -0,0 +1,72 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <functional>
+#include <optional>
+
+#include "EventLoop.hpp"
+#include "Player.hpp"
+#include "Session.hpp"
+#include "Timeline.hpp"
+
+namespace foo_showplay {
+
+// Plays timeline into session, in place of foobar2000. Speed scales time
+// between events, 0 replays them as fast as possible. Anchor servers see
+// drift at speeds other than 1, anchors are sent with rate 1.
+class SimulatedPlayer : public Player
+{
+public:
+    using OnEventCallback = std::function<void(const TimelineEvent&)>;
+
+private:
+    const Timeline&              mTimeline;
+    double                       mSpeed;
+    std::optional<std::size_t>   mTrack;
+    PlaybackState                mState;
+    double                       mPosition; // At mPositionTime.
+    EventLoop::Clock::time_point mPositionTime;
+    FieldSchema                  mSchema;
+    OnEventCallback              mOnEventCallback;
+
+    auto SetPosition (double position) -> void;
+    auto Apply       (const TimelineEvent& event, ShowPlaySession& session) -> void;
+
+public:
+    SimulatedPlayer(const Timeline& timeline, double speed);
+
+    auto GetName        () -> std::string override { return "ShowPlay Simulator"; }
+    auto HasTrack       () -> bool override { return mTrack.has_value(); }
+    auto GetState       () -> PlaybackState override { return mState; }
+    auto GetPosition    () -> double override;
+    auto GetSong        () -> std::optional<SongInfo> override;
+    auto GetCover       () -> std::optional<BinaryData> override;
+    auto SetFieldSchema (const FieldSchema& schema) -> void override { mSchema = schema; }
+    auto GetFields      () -> std::optional<CustomFields> override;
+
+    // Called right before event is passed to session.
+    auto SetOnEventCallback (OnEventCallback callback) -> void { mOnEventCallback = std::move(callback); }
+
+    // Blocks until last event is played, running loop meanwhile.
+    auto Play (ShowPlaySession& session, EventLoop& loop) -> void;
+};
+
+} // namespace foo_showplay
@@ -0,0 +1,228 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "TestServer.hpp"
+#include "Constants.hpp"
+#include "FrameCompressor.hpp"
+#include "Uuid.hpp"
+
+#include <zlib.h>
+#include <algorithm>
+
+namespace foo_showplay {
+
+// "SPZ", dictionary id, raw deflate stream, see FrameCompressor.
+static auto Inflate(const std::string& message) -> std::optional<std::string>
+{
+    auto stream = z_stream();
+    if (inflateInit2(&stream, -15) != Z_OK)
+    {
+        return std::nullopt;
+    }
+
+    auto dictionary = FrameCompressor::GetDictionary(static_cast<CompressionDictionary>(message[3]));
+    if (!dictionary.empty())
+    {
+        inflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.data()), static_cast<uInt>(dictionary.size()));
+    }
+
+    stream.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(message.data() + 4));
+    stream.avail_in = static_cast<uInt>(message.size() - 4);
+
+    auto result = std::string();
+    auto status = Z_OK;
+    while (status == Z_OK)
+    {
+        auto size = result.size();
+        result.resize(size + 4 * message.size());
+
+        stream.next_out  = reinterpret_cast<Bytef*>(result.data() + size);
+        stream.avail_out = static_cast<uInt>(result.size() - size);
+        status = inflate(&stream, Z_FINISH);
+        if (status == Z_BUF_ERROR && stream.avail_out == 0)
+        {
+            status = Z_OK;
+        }
+    }
+
+    result.resize(stream.total_out);
+    inflateEnd(&stream);
+
+    if (status != Z_STREAM_END)
+    {
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+TestServer::TestServer(int port, std::size_t maxConnections, const std::vector<std::string>& features)
+    : mServer    (port, "127.0.0.1", ix::SocketServer::kDefaultTcpBacklog, maxConnections)
+    , mIsAcking  (std::find(features.begin(), features.end(), FEATURE_ACK) != features.end())
+    , mRandom    (std::random_device()())
+    , mFrames    (0)
+    , mBytes     (0)
+    , mUndecoded (0)
+{
+    auto message = nlohmann::json::object();
+    message["Features"] = features;
+    mTokenMessage = message.dump();
+
+    mServer.setOnClientMessageCallback([this](std::shared_ptr<ix::ConnectionState> state, ix::WebSocket& webSocket, const ix::WebSocketMessagePtr& message)
+    {
+        OnMessage(state->getId(), webSocket, message);
+    });
+}
+
+TestServer::~TestServer()
+{
+    Stop();
+}
+
+auto TestServer::SetOnFrameCallback(OnFrameCallback callback) -> void
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    mOnFrameCallback = std::move(callback);
+}
+
+auto TestServer::Start() -> bool
+{
+    if (!mServer.listen().first)
+    {
+        return false;
+    }
+
+    mServer.start();
+    return true;
+}
+
+auto TestServer::Stop() -> void
+{
+    mServer.stop();
+}
+
+auto TestServer::OnMessage(const std::string& id, ix::WebSocket& webSocket, const ix::WebSocketMessagePtr& message) -> void
+{
+    auto received = Clock::now();
+
+    if (message->type == ix::WebSocketMessageType::Open)
+    {
+        // Client index is last part of path.
+        const auto& uri   = message->openInfo.uri;
+        auto        slash = uri.find_last_of('/');
+        auto        index = std::strtoull(uri.c_str() + (slash == std::string::npos ? 0 : slash + 1), nullptr, 10);
+        {
+            auto lock = std::lock_guard<std::mutex>(mMutex);
+            mClients[id] = static_cast<std::size_t>(index);
+        }
+
+        webSocket.sendText(IssueToken());
+    }
+    else if (message->type == ix::WebSocketMessageType::Close)
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        mClients.erase(id);
+    }
+    else if (message->type == ix::WebSocketMessageType::Message)
+    {
+        mFrames += 1;
+        mBytes  += message->str.size();
+
+        auto frame = DecodeFrame(message->str, message->binary);
+        if (frame.is_object())
+        {
+            // Stamped on arrival, as the server does.
+            if (mIsAcking && frame.contains("Frame") && frame["Frame"].is_number_integer())
+            {
+                auto now = std::chrono::system_clock::now().time_since_epoch();
+                auto ack = nlohmann::json::object();
+                ack["Ack"]    = frame["Frame"];
+                ack["Time"]   = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+                ack["TimeUs"] = std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+
+                webSocket.sendText(ack.dump());
+            }
+
+            auto client   = std::optional<std::size_t>();
+            auto callback = OnFrameCallback();
+            {
+                auto lock = std::lock_guard<std::mutex>(mMutex);
+                auto it   = mClients.find(id);
+                if (it != mClients.end())
+                {
+                    client = it->second;
+                }
+                callback = mOnFrameCallback;
+            }
+
+            if (callback && client.has_value())
+            {
+                callback(client.value(), frame, received);
+            }
+        }
+        else
+        {
+            mUndecoded += 1;
+        }
+    }
+}
+
+auto TestServer::IssueToken() -> std::string
+{
+    auto uuid = Uuid();
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        uuid.High = mRandom();
+        uuid.Low  = mRandom();
+    }
+
+    // Version 4, variant 1, as the server generates them.
+    uuid.High = (uuid.High & ~std::uint64_t(0xF000)) | 0x4000;
+    uuid.Low  = (uuid.Low  & ~(std::uint64_t(0x3) << 62)) | (std::uint64_t(0x2) << 62);
+
+    auto message = nlohmann::json::parse(mTokenMessage);
+    message["Token"] = FormatUuid(uuid);
+
+    return message.dump();
+}
+
+auto TestServer::DecodeFrame(const std::string& data, bool isBinary) -> nlohmann::json
+{
+    if (!isBinary)
+    {
+        return nlohmann::json::parse(data, nullptr, false);
+    }
+
+    if (data.size() > 4 && data.compare(0, 3, "SPZ") == 0)
+    {
+        auto inflated = Inflate(data);
+        if (!inflated.has_value())
+        {
+            return nlohmann::json();
+        }
+
+        // Compressed frame is JSON or CBOR, whichever it was before.
+        auto frame = nlohmann::json::parse(inflated.value(), nullptr, false);
+        return frame.is_discarded() ? nlohmann::json::from_cbor(inflated.value(), true, false) : frame;
+    }
+
+    return nlohmann::json::from_cbor(data, true, false);
+}
+
+} // namespace foo_showplay
@@ -0,0 +1,77 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <ixwebsocket/IXWebSocketServer.h>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace foo_showplay {
+
+// Local stand-in for ShowPlay server. Issues random UUID token with given
+// features to every connection and decodes frames it receives, JSON, CBOR
+// or compressed. Clients connect to /client/<index>, so frames can be told
+// apart by client. With Ack feature every frame is acknowledged.
+class TestServer
+{
+public:
+    using Clock           = std::chrono::steady_clock;
+    using OnFrameCallback = std::function<void(std::size_t client, const nlohmann::json& frame, Clock::time_point received)>;
+
+private:
+    ix::WebSocketServer                          mServer;
+    std::string                                  mTokenMessage; // Without token, see IssueToken.
+    bool                                         mIsAcking;
+    std::mutex                                   mMutex;        // Guards members below.
+    std::unordered_map<std::string, std::size_t> mClients;      // By connection id.
+    std::mt19937_64                              mRandom;
+    OnFrameCallback                              mOnFrameCallback;
+
+    std::atomic<std::uint64_t> mFrames;
+    std::atomic<std::uint64_t> mBytes;
+    std::atomic<std::uint64_t> mUndecoded; // Binary cover attachments and garbage.
+
+    auto OnMessage   (const std::string& id, ix::WebSocket& webSocket, const ix::WebSocketMessagePtr& message) -> void;
+    auto IssueToken  () -> std::string;
+    auto DecodeFrame (const std::string& data, bool isBinary) -> nlohmann::json;
+
+public:
+    TestServer(int port, std::size_t maxConnections, const std::vector<std::string>& features);
+    ~TestServer();
+
+    auto SetOnFrameCallback (OnFrameCallback callback) -> void;
+
+    auto Start () -> bool;
+    auto Stop  () -> void;
+
+    auto GetFrameCount     () const -> std::uint64_t { return mFrames;    }
+    auto GetByteCount      () const -> std::uint64_t { return mBytes;     } // Payload bytes of all messages.
+    auto GetUndecodedCount () const -> std::uint64_t { return mUndecoded; }
+};
+
+} // namespace foo_showplay
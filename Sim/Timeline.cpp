@@ -0,0 +1,364 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "Timeline.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string_view>
+
+namespace foo_showplay {
+
+static auto Trim(std::string_view str) -> std::string_view
+{
+    static constexpr auto whitespace = std::string_view(" \t\r\n");
+
+    auto first = str.find_first_not_of(whitespace);
+    if (first == std::string_view::npos)
+    {
+        return std::string_view();
+    }
+
+    auto last = str.find_last_not_of(whitespace);
+    return str.substr(first, last - first + 1);
+}
+
+static auto ToBinaryData(std::vector<std::uint8_t> bytes) -> BinaryData
+{
+    auto buffer = std::make_shared<std::vector<std::uint8_t>>(std::move(bytes));
+    auto data   = buffer->data();
+    auto size   = buffer->size();
+
+    return BinaryData(std::shared_ptr<const std::uint8_t>(std::move(buffer), data), size);
+}
+
+static auto ReadFile(const std::string& path) -> std::optional<BinaryData>
+{
+    auto file = std::ifstream(path, std::ios::binary);
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    auto bytes = std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return ToBinaryData(std::move(bytes));
+}
+
+static auto ParseNumber(std::string_view str) -> std::optional<double>
+{
+    auto stream = std::istringstream(std::string(str));
+    auto value  = 0.0;
+    if (!(stream >> value) || !(stream >> std::ws).eof())
+    {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+// Title | Artist | Album | Date | Track | Length [| Cover] [| tag=value ...]
+static auto ParseTrack(std::string_view line, std::size_t index) -> std::optional<SimulatedTrack>
+{
+    auto parts = std::vector<std::string>();
+    while (!line.empty())
+    {
+        auto end = std::min(line.find('|'), line.size());
+        parts.emplace_back(Trim(line.substr(0, end)));
+        line.remove_prefix(std::min(end + 1, line.size()));
+    }
+
+    if (parts.size() < 6)
+    {
+        return std::nullopt;
+    }
+
+    auto optionalString = [](const std::string& str) -> std::optional<std::string>
+    {
+        return str.empty() ? std::nullopt : std::make_optional(str);
+    };
+
+    auto track = SimulatedTrack();
+    track.Song.Title  = optionalString(parts[0]);
+    track.Song.Artist = optionalString(parts[1]);
+    track.Song.Album  = optionalString(parts[2]);
+    track.Song.Date   = optionalString(parts[3]);
+    track.Song.Path   = "sim://track/" + std::to_string(index);
+    if (parts[3].size() >= 4)
+    {
+        track.Song.Year = parts[3].substr(0, 4);
+    }
+
+    auto number = ParseNumber(parts[4]);
+    auto length = ParseNumber(parts[5]);
+    if ((!parts[4].empty() && !number.has_value()) || !length.has_value() || length.value() <= 0.0)
+    {
+        return std::nullopt;
+    }
+
+    track.Song.TrackNumber = number.has_value() ? std::make_optional(static_cast<int>(number.value())) : std::nullopt;
+    track.Song.Length      = length;
+
+    if (parts.size() > 6 && !parts[6].empty())
+    {
+        track.Cover = ReadFile(parts[6]);
+        if (!track.Cover.has_value())
+        {
+            return std::nullopt;
+        }
+    }
+
+    for (auto i = std::size_t(7); i < parts.size(); ++i)
+    {
+        auto separator = parts[i].find('=');
+        if (separator == std::string::npos)
+        {
+            return std::nullopt;
+        }
+
+        auto name = parts[i].substr(0, separator);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        track.Tags[name] = parts[i].substr(separator + 1);
+    }
+
+    return track;
+}
+
+// Adds album art after every new track and time events while playing, the
+// way foobar2000 reports them.
+static auto AddPlayerEvents(Timeline& timeline) -> void
+{
+    std::stable_sort(timeline.Events.begin(), timeline.Events.end(), [](const TimelineEvent& a, const TimelineEvent& b)
+    {
+        return a.Time < b.Time;
+    });
+
+    auto events    = std::vector<TimelineEvent>();
+    auto track     = std::optional<std::size_t>();
+    auto isPlaying = false;
+    auto position  = 0.0;
+    auto time      = 0.0;
+
+    // Whole seconds of position passed while playing until given time.
+    auto advance = [&](double until)
+    {
+        if (track.has_value() && isPlaying)
+        {
+            auto length = timeline.Tracks[track.value()].Song.Length.value_or(std::numeric_limits<double>::infinity());
+            for (auto second = std::floor(position) + 1.0; second <= length; second += 1.0)
+            {
+                auto at = time + (second - position);
+                if (at > until)
+                {
+                    break;
+                }
+
+                events.emplace_back(at, TimelineEventType::Time, second);
+            }
+
+            position = std::min(position + (until - time), length);
+        }
+
+        time = until;
+    };
+
+    for (const auto& event : timeline.Events)
+    {
+        advance(event.Time);
+        events.push_back(event);
+
+        switch (event.Type)
+        {
+        case TimelineEventType::Track:
+            track     = event.Track;
+            isPlaying = true;
+            position  = 0.0;
+            events.emplace_back(event.Time, TimelineEventType::AlbumArt);
+            break;
+
+        case TimelineEventType::Seek:
+            position = event.Position;
+            break;
+
+        case TimelineEventType::Pause:
+            isPlaying = false;
+            break;
+
+        case TimelineEventType::Resume:
+            isPlaying = track.has_value();
+            break;
+
+        case TimelineEventType::Stop:
+            track     = std::nullopt;
+            isPlaying = false;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // Last track plays to its end.
+    if (track.has_value() && isPlaying)
+    {
+        auto length = timeline.Tracks[track.value()].Song.Length.value_or(position);
+        advance(time + (length - position));
+    }
+
+    timeline.Events = std::move(events);
+}
+
+auto ParseTimeline(std::istream& script, std::size_t& errorLine) -> std::optional<Timeline>
+{
+    auto timeline   = Timeline();
+    auto line       = std::string();
+    auto lineNumber = std::size_t(0);
+    while (std::getline(script, line))
+    {
+        lineNumber += 1;
+        errorLine   = lineNumber;
+
+        auto trimmed = Trim(line);
+        if (trimmed.empty() || trimmed.front() == '#')
+        {
+            continue;
+        }
+
+        // Time and command, then arguments.
+        auto stream  = std::istringstream(std::string(trimmed));
+        auto time    = 0.0;
+        auto command = std::string();
+        if (!(stream >> time >> command) || time < 0.0)
+        {
+            return std::nullopt;
+        }
+
+        auto arguments = std::string();
+        std::getline(stream, arguments);
+
+        if (command == "track")
+        {
+            auto index = timeline.Tracks.size();
+            auto track = ParseTrack(arguments, index);
+            if (!track.has_value())
+            {
+                return std::nullopt;
+            }
+
+            timeline.Tracks.push_back(std::move(track.value()));
+            timeline.Events.emplace_back(time, TimelineEventType::Track, 0.0, index);
+        }
+        else if (command == "seek")
+        {
+            auto position = ParseNumber(Trim(arguments));
+            if (!position.has_value() || position.value() < 0.0)
+            {
+                return std::nullopt;
+            }
+
+            timeline.Events.emplace_back(time, TimelineEventType::Seek, position.value());
+        }
+        else if (command == "pause")
+        {
+            timeline.Events.emplace_back(time, TimelineEventType::Pause);
+        }
+        else if (command == "resume")
+        {
+            timeline.Events.emplace_back(time, TimelineEventType::Resume);
+        }
+        else if (command == "stop")
+        {
+            timeline.Events.emplace_back(time, TimelineEventType::Stop);
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    AddPlayerEvents(timeline);
+    return timeline;
+}
+
+auto GenerateTimeline(std::size_t trackCount, double trackLength) -> Timeline
+{
+    static constexpr auto TRACKS_PER_ALBUM = std::size_t(4);
+    static constexpr auto COVER_SIZE       = std::size_t(48 * 1024);
+    static constexpr auto PAUSE_LENGTH     = 2.0;
+    static constexpr auto SEEK_LENGTH      = 10.0;
+
+    trackLength = std::max(trackLength, 30.0);
+
+    auto timeline = Timeline();
+    auto time     = 0.0;
+    auto cover    = std::optional<BinaryData>();
+    for (auto i = std::size_t(0); i < trackCount; ++i)
+    {
+        auto album = i / TRACKS_PER_ALBUM;
+
+        // Same cover for whole album, so cover cache and hashes get hits.
+        if (i % TRACKS_PER_ALBUM == 0)
+        {
+            auto random = std::mt19937(static_cast<std::mt19937::result_type>(album));
+            auto bytes  = std::vector<std::uint8_t>(COVER_SIZE);
+            std::generate(bytes.begin(), bytes.end(), [&random]() { return static_cast<std::uint8_t>(random()); });
+
+            cover = ToBinaryData(std::move(bytes));
+        }
+
+        auto track = SimulatedTrack();
+        track.Song.Title       = "Track " + std::to_string(i + 1);
+        track.Song.Artist      = "Artist " + std::to_string(album / 2 + 1);
+        track.Song.Album       = "Album " + std::to_string(album + 1);
+        track.Song.Date        = "2021-05-17";
+        track.Song.Year        = "2021";
+        track.Song.TrackNumber = static_cast<int>(i % TRACKS_PER_ALBUM + 1);
+        track.Song.Length      = trackLength;
+        track.Song.Path        = "sim://track/" + std::to_string(i);
+        track.Tags["genre"]    = album % 2 == 0 ? "Rock" : "Jazz";
+        track.Tags["rating"]   = std::to_string(i % 5 + 1);
+        track.Cover            = cover;
+        timeline.Tracks.push_back(std::move(track));
+
+        // Pause at third of track, then skip forward from the middle.
+        auto pauseAt = time + trackLength / 3.0;
+        auto seekAt  = time + trackLength / 2.0 + PAUSE_LENGTH;
+        timeline.Events.emplace_back(time, TimelineEventType::Track, 0.0, i);
+        timeline.Events.emplace_back(pauseAt, TimelineEventType::Pause);
+        timeline.Events.emplace_back(pauseAt + PAUSE_LENGTH, TimelineEventType::Resume);
+        timeline.Events.emplace_back(seekAt, TimelineEventType::Seek, trackLength / 2.0 + SEEK_LENGTH);
+
+        time += trackLength + PAUSE_LENGTH - SEEK_LENGTH;
+    }
+
+    if (trackCount > 0)
+    {
+        timeline.Events.emplace_back(time, TimelineEventType::Stop);
+    }
+
+    AddPlayerEvents(timeline);
+    return timeline;
+}
+
+} // namespace foo_showplay
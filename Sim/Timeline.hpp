@@ -0,0 +1,91 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Payload.hpp"
+
+namespace foo_showplay {
+
+struct SimulatedTrack
+{
+    SongInfo                           Song;
+    std::map<std::string, std::string> Tags;  // Other tags by lowercase name, for schema fields.
+    std::optional<BinaryData>          Cover; // Album art as stored.
+};
+
+enum class TimelineEventType
+{
+    Track,    // New track started, Track is its index.
+    AlbumArt, // Album art of current track loaded.
+    Time,     // Once per second of playback.
+    Seek,
+    Pause,
+    Resume,
+    Stop,
+};
+
+struct TimelineEvent
+{
+    double            Time;     // Seconds from start of timeline.
+    TimelineEventType Type;
+    double            Position; // Of Time and Seek.
+    std::size_t       Track;    // Of Track.
+
+    TimelineEvent(double time, TimelineEventType type, double position = 0.0, std::size_t track = 0)
+        : Time     (time)
+        , Type     (type)
+        , Position (position)
+        , Track    (track)
+    {
+    }
+};
+
+// Events in the order player would report them.
+struct Timeline
+{
+    std::vector<SimulatedTrack> Tracks;
+    std::vector<TimelineEvent>  Events;
+};
+
+// Reads timeline script, one event per line:
+//
+//     # Comment.
+//     0     track  Title | Artist | Album | Date | Track | Length [| Cover] [| tag=value ...]
+//     42.5  pause
+//     50    resume
+//     60    seek 120
+//     300   stop
+//
+// Times are seconds from start. Album art and time events are added the way
+// foobar2000 reports them. On error returns nullopt and sets errorLine.
+auto ParseTimeline (std::istream& script, std::size_t& errorLine) -> std::optional<Timeline>;
+
+// Albums of four tracks, each paused for a while and seeked forward once.
+// Track length is at least 30 seconds.
+auto GenerateTimeline (std::size_t trackCount, double trackLength) -> Timeline;
+
+} // namespace foo_showplay
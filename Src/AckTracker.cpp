@@ -0,0 +1,199 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "AckTracker.hpp"
+
+#include <algorithm>
+
+namespace foo_showplay {
+
+AckTracker::AckTracker(Metrics& metrics)
+    : mMetrics     (metrics)
+    , mOffsetCount (0)
+    , mEpoch       (0)
+{
+    Reset(0);
+}
+
+auto AckTracker::Reset(unsigned epoch) -> void
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    mEpoch = epoch;
+    for (auto& sent : mFrames)
+    {
+        sent.Frame = -1;
+    }
+
+    // Other server or other route, offset is measured again.
+    mOffsetCount = 0;
+}
+
+auto AckTracker::OnSent(int frame, unsigned epoch) -> void
+{
+    auto nowUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    OnSent(frame, epoch, Clock::now(), nowUs);
+}
+
+auto AckTracker::OnSent(int frame, unsigned epoch, Clock::time_point sentAt, std::int64_t sentAtUs) -> void
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+
+    // Reconnected between numbering and sending. Its number may be taken by
+    // frame of new connection, counting it would make that one look lost.
+    if (epoch != mEpoch)
+    {
+        return;
+    }
+
+    CheckStuck(sentAt);
+
+    // Window wrapped, server never acknowledged frame in this slot.
+    auto& slot = mFrames[static_cast<std::size_t>(frame) % ACK_WINDOW_SIZE];
+    if (slot.Frame >= 0 && !slot.IsAcked)
+    {
+        mMetrics.FramesLost.Add();
+    }
+
+    slot = SentFrame{ frame, sentAt, sentAtUs, false, false };
+}
+
+auto AckTracker::OnFailed(int frame, unsigned epoch) -> void
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    if (epoch != mEpoch)
+    {
+        return;
+    }
+
+    auto& slot = mFrames[static_cast<std::size_t>(frame) % ACK_WINDOW_SIZE];
+    if (slot.Frame == frame)
+    {
+        slot.Frame = -1;
+    }
+}
+
+auto AckTracker::OnAck(int frame, std::int64_t receivedAtUs) -> void
+{
+    OnAck(frame, receivedAtUs, Clock::now());
+}
+
+auto AckTracker::OnAck(int frame, std::int64_t receivedAtUs, Clock::time_point now) -> void
+{
+    if (frame < 0)
+    {
+        return;
+    }
+
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+
+    // Unknown frame, already lost, acked or sent on old connection.
+    auto& slot = mFrames[static_cast<std::size_t>(frame) % ACK_WINDOW_SIZE];
+    if (slot.Frame != frame || slot.IsAcked)
+    {
+        return;
+    }
+
+    // Server acknowledges frames in order, older ones it skipped are lost.
+    for (auto& sent : mFrames)
+    {
+        if (sent.Frame >= 0 && !sent.IsAcked && sent.Frame < frame)
+        {
+            mMetrics.FramesLost.Add();
+            sent.Frame = -1;
+        }
+    }
+
+    auto roundTrip   = now - slot.SentAt;
+    auto halfUs      = std::chrono::duration_cast<std::chrono::microseconds>(roundTrip).count() / 2;
+
+    // Fastest round trip waited in no queue, both of its halves are assumed
+    // equal. Server clock is related to ours through it.
+    mOffsetSamples[mOffsetCount % ACK_OFFSET_WINDOW] = OffsetSample{ roundTrip, receivedAtUs - (slot.SentAtUs + halfUs) };
+    mOffsetCount += 1;
+
+    // Offset of asymmetric fastest round trip may exceed true one, uplink
+    // then comes out below zero. Histogram would record it as zero.
+    auto uplinkUs = receivedAtUs - FindClockOffset() - slot.SentAtUs;
+    mMetrics.RoundTripTime.Record(roundTrip);
+    if (uplinkUs >= 0)
+    {
+        mMetrics.UplinkDelay.Record(std::chrono::microseconds(uplinkUs));
+    }
+    else
+    {
+        mMetrics.UplinkNegative.Add();
+    }
+
+    slot.IsAcked = true;
+    CheckStuck(now);
+}
+
+auto AckTracker::GetAckState(int frame, unsigned epoch) -> AckState
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    if (epoch != mEpoch || frame < 0)
+    {
+        return AckState::Lost;
+    }
+
+    // Freed slot was failed or skipped, reused one may have been acked but
+    // that's no longer known.
+    const auto& slot = mFrames[static_cast<std::size_t>(frame) % ACK_WINDOW_SIZE];
+    if (slot.Frame != frame)
+    {
+        return AckState::Lost;
+    }
+
+    return slot.IsAcked ? AckState::Acked : AckState::Pending;
+}
+
+auto AckTracker::GetClockOffset() -> std::optional<std::chrono::microseconds>
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    if (mOffsetCount == 0)
+    {
+        return std::nullopt;
+    }
+
+    return std::chrono::microseconds(FindClockOffset());
+}
+
+auto AckTracker::FindClockOffset() const -> std::int64_t
+{
+    auto count = std::min(mOffsetCount, ACK_OFFSET_WINDOW);
+    auto best  = std::min_element(mOffsetSamples.begin(), mOffsetSamples.begin() + count,
+        [](const OffsetSample& a, const OffsetSample& b) { return a.RoundTrip < b.RoundTrip; });
+    return best->Offset;
+}
+
+auto AckTracker::CheckStuck(Clock::time_point now) -> void
+{
+    // Counted once, frame is still matched if its ack comes later.
+    for (auto& sent : mFrames)
+    {
+        if (sent.Frame >= 0 && !sent.IsAcked && !sent.IsStuck && now - sent.SentAt > ACK_STUCK_TIMEOUT)
+        {
+            sent.IsStuck = true;
+            mMetrics.FramesStuck.Add();
+        }
+    }
+}
+
+} // namespace foo_showplay
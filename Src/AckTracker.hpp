@@ -0,0 +1,109 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+#include "Constants.hpp"
+#include "Metrics.hpp"
+
+namespace foo_showplay {
+
+enum class AckState
+{
+    Pending, // Sent, server hasn't acknowledged it yet.
+    Acked,
+    Lost,    // Failed, skipped by server, sent on old connection or out of window.
+};
+
+// Matches acknowledgements of server to frames sent on one connection.
+// Server echoes Frame with Unix time it received it at, that gives round
+// trip time and, with clock offset taken from the fastest of last
+// ACK_OFFSET_WINDOW round trips, delay of the way to server alone. All of
+// it is kept in microseconds, on local network both are well below one
+// millisecond. Uplink below zero means offset is off, such sample is
+// counted apart instead of recorded. Frames the server skipped are lost,
+// frames without ack for ACK_STUCK_TIMEOUT are stuck somewhere in between.
+class AckTracker
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    struct SentFrame
+    {
+        int               Frame;    // -1 if slot is free.
+        Clock::time_point SentAt;
+        std::int64_t      SentAtUs; // Unix time, compared to server timestamp.
+        bool              IsStuck;
+        bool              IsAcked;  // Kept until slot is reused, so its state can be asked.
+    };
+
+    // Clock offset one ack gives, if both halves of its round trip were equal.
+    struct OffsetSample
+    {
+        Clock::duration RoundTrip;
+        std::int64_t    Offset;
+    };
+
+    Metrics&                                    mMetrics;
+    std::mutex                                  mMutex;
+    std::array<SentFrame, ACK_WINDOW_SIZE>      mFrames;        // By frame number modulo window.
+    std::array<OffsetSample, ACK_OFFSET_WINDOW> mOffsetSamples; // Last acks, oldest is overwritten.
+    std::size_t                                 mOffsetCount;   // Acks of this connection.
+    unsigned                                    mEpoch;         // Of connection frames are tracked for.
+
+    auto CheckStuck      (Clock::time_point now) -> void;
+    auto FindClockOffset () const -> std::int64_t; // Of fastest sample, at least one needed.
+
+public:
+    AckTracker(Metrics& metrics);
+
+    AckTracker(const AckTracker&)            = delete;
+    AckTracker& operator=(const AckTracker&) = delete;
+
+    // New connection, frame numbers start over. Frames of old one are
+    // forgotten, snapshot replaces them.
+    auto Reset (unsigned epoch) -> void;
+
+    // Called right before frame is handed to socket, ack may arrive before
+    // send call returns. Epoch is of connection state frame was numbered
+    // with, frame numbered before last Reset is not tracked.
+    auto OnSent   (int frame, unsigned epoch) -> void;
+    auto OnFailed (int frame, unsigned epoch) -> void;
+    auto OnAck    (int frame, std::int64_t receivedAtUs) -> void;
+
+    // Same with times given, steady for round trip and Unix microseconds
+    // for comparison with server.
+    auto OnSent (int frame, unsigned epoch, Clock::time_point sentAt, std::int64_t sentAtUs) -> void;
+    auto OnAck  (int frame, std::int64_t receivedAtUs, Clock::time_point now) -> void;
+
+    // Whether server got frame. Frame numbered before last Reset is lost.
+    auto GetAckState (int frame, unsigned epoch) -> AckState;
+
+    // Server minus client clock, none before first ack.
+    auto GetClockOffset () -> std::optional<std::chrono::microseconds>;
+};
+
+} // namespace foo_showplay
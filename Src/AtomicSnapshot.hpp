@@ -0,0 +1,116 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace foo_showplay {
+
+// Immutable value read by any thread and replaced by few writers. Read path
+// is one counter increment and one pointer load, never lock nor wait, even
+// while value is being replaced. Writers are serialized by mutex. Replaced
+// values are kept until a writer sees no reader in flight, so a reader may
+// hold its value as long as it needs.
+template <typename T>
+class AtomicSnapshot
+{
+    static_assert(std::atomic<const T*>::is_always_lock_free,    "Read path must be lock-free");
+    static_assert(std::atomic<std::size_t>::is_always_lock_free, "Read path must be lock-free");
+
+    std::atomic<const T*>                 mCurrent;
+    mutable std::atomic<std::size_t>      mReaders; // Readers holding any value.
+    std::mutex                            mMutex;   // Guards members below, taken by writers only.
+    std::unique_ptr<const T>              mOwned;   // Same as mCurrent.
+    std::vector<std::unique_ptr<const T>> mRetired; // Replaced, maybe still read.
+
+public:
+    // Keeps value alive while reader holds it.
+    class Reader
+    {
+        const AtomicSnapshot* mOwner;
+        const T*              mValue;
+
+    public:
+        Reader(const AtomicSnapshot& owner)
+            : mOwner (&owner)
+        {
+            // Counted before load. Writer that doesn't see the count stored
+            // new value before, and that one is loaded here.
+            mOwner->mReaders.fetch_add(1);
+            mValue = mOwner->mCurrent.load();
+        }
+
+        ~Reader()
+        {
+            if (mOwner != nullptr)
+            {
+                mOwner->mReaders.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        Reader(Reader&& other)
+            : mOwner (std::exchange(other.mOwner, nullptr))
+            , mValue (other.mValue)
+        {
+        }
+
+        Reader(const Reader&)            = delete;
+        Reader& operator=(const Reader&) = delete;
+        Reader& operator=(Reader&&)      = delete;
+
+        auto operator-> () const -> const T* { return mValue;  }
+        auto operator*  () const -> const T& { return *mValue; }
+    };
+
+    AtomicSnapshot(T value)
+        : mCurrent (nullptr)
+        , mReaders (0)
+        , mOwned   (std::make_unique<const T>(std::move(value)))
+    {
+        mCurrent.store(mOwned.get());
+    }
+
+    AtomicSnapshot(const AtomicSnapshot&)            = delete;
+    AtomicSnapshot& operator=(const AtomicSnapshot&) = delete;
+
+    auto Read () const -> Reader { return Reader(*this); }
+
+    auto Publish (T value) -> void
+    {
+        auto lock  = std::lock_guard<std::mutex>(mMutex);
+        auto owned = std::make_unique<const T>(std::move(value));
+        mCurrent.store(owned.get());
+        mRetired.push_back(std::exchange(mOwned, std::move(owned)));
+
+        // Readers that start from now on get the new value. None in flight
+        // means no one holds a retired one.
+        if (mReaders.load() == 0)
+        {
+            mRetired.clear();
+        }
+    }
+};
+
+} // namespace foo_showplay
@@ -0,0 +1,269 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "Base64.hpp"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+    #define SHOWPLAY_BASE64_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define SHOWPLAY_TARGET_SSSE3
+        #define SHOWPLAY_TARGET_AVX2
+    #else
+        #define SHOWPLAY_TARGET_SSSE3 __attribute__((target("ssse3")))
+        #define SHOWPLAY_TARGET_AVX2  __attribute__((target("avx2")))
+    #endif
+#else
+    #define SHOWPLAY_BASE64_X86 0
+#endif
+
+namespace foo_showplay {
+
+static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// -------------------------------------------------------------------------- //
+
+// Encodes whole input, including padding. SIMD versions call it for tail.
+static auto EncodeScalar(const std::uint8_t* data, std::size_t size, char* out) -> void
+{
+    auto i = std::size_t(0);
+    for (; i + 3 <= size; i += 3)
+    {
+        auto value = (std::uint32_t(data[i]) << 16) | (std::uint32_t(data[i + 1]) << 8) | data[i + 2];
+        out[0] = ALPHABET[(value >> 18) & 0x3F];
+        out[1] = ALPHABET[(value >> 12) & 0x3F];
+        out[2] = ALPHABET[(value >>  6) & 0x3F];
+        out[3] = ALPHABET[ value        & 0x3F];
+        out += 4;
+    }
+
+    auto rest = size - i;
+    if (rest == 1)
+    {
+        auto value = std::uint32_t(data[i]) << 16;
+        out[0] = ALPHABET[(value >> 18) & 0x3F];
+        out[1] = ALPHABET[(value >> 12) & 0x3F];
+        out[2] = '=';
+        out[3] = '=';
+    }
+    else if (rest == 2)
+    {
+        auto value = (std::uint32_t(data[i]) << 16) | (std::uint32_t(data[i + 1]) << 8);
+        out[0] = ALPHABET[(value >> 18) & 0x3F];
+        out[1] = ALPHABET[(value >> 12) & 0x3F];
+        out[2] = ALPHABET[(value >>  6) & 0x3F];
+        out[3] = '=';
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+#if SHOWPLAY_BASE64_X86
+
+// Based on Wojciech Mula's "Base64 encoding with SIMD instructions":
+// split 12 input bytes into 16 6-bit indices, then map indices to ASCII by
+// adding per-range offset looked up with pshufb.
+
+SHOWPLAY_TARGET_SSSE3
+static inline auto SplitSSSE3(__m128i input) -> __m128i
+{
+    input = _mm_shuffle_epi8(input, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    auto t0 = _mm_and_si128(input, _mm_set1_epi32(0x0FC0FC00));
+    auto t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    auto t2 = _mm_and_si128(input, _mm_set1_epi32(0x003F03F0));
+    auto t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+    return _mm_or_si128(t1, t3);
+}
+
+SHOWPLAY_TARGET_SSSE3
+static inline auto LookupSSSE3(__m128i indices) -> __m128i
+{
+    // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+    auto result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    auto less   = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+    auto offsets = _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0
+    );
+
+    return _mm_add_epi8(_mm_shuffle_epi8(offsets, result), indices);
+}
+
+SHOWPLAY_TARGET_SSSE3
+static auto EncodeSSSE3(const std::uint8_t* data, std::size_t size, char* out) -> void
+{
+    // Loads 16 bytes but uses only 12, stop before reading past the end.
+    auto i = std::size_t(0);
+    for (; i + 16 <= size; i += 12)
+    {
+        auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        auto ascii = LookupSSSE3(SplitSSSE3(input));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), ascii);
+        out += 16;
+    }
+
+    EncodeScalar(data + i, size - i, out);
+}
+
+SHOWPLAY_TARGET_AVX2
+static auto EncodeAVX2(const std::uint8_t* data, std::size_t size, char* out) -> void
+{
+    const auto shuffle = _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10
+    );
+    const auto offsets = _mm256_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0
+    );
+
+    // Each lane takes 12 bytes, second lane loads at +12. Last load reads
+    // 16 bytes at i + 12, stop before reading past the end.
+    auto i = std::size_t(0);
+    for (; i + 28 <= size; i += 24)
+    {
+        auto lo    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        auto hi    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 12));
+        auto input = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+        input = _mm256_shuffle_epi8(input, shuffle);
+
+        auto t0      = _mm256_and_si256(input, _mm256_set1_epi32(0x0FC0FC00));
+        auto t1      = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        auto t2      = _mm256_and_si256(input, _mm256_set1_epi32(0x003F03F0));
+        auto t3      = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        auto indices = _mm256_or_si256(t1, t3);
+
+        auto result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        auto less   = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+
+        auto ascii = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, result), indices);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), ascii);
+        out += 32;
+    }
+
+    EncodeSSSE3(data + i, size - i, out);
+}
+
+static auto HasSSSE3() -> bool
+{
+#if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+static auto HasAVX2() -> bool
+{
+#if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    // OS must save YMM registers too.
+    __cpuid(info, 1);
+    auto hasOsxsave = (info[2] & (1 << 27)) != 0;
+    auto hasAvx     = (info[2] & (1 << 28)) != 0;
+    if (!hasOsxsave || !hasAvx || (_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // SHOWPLAY_BASE64_X86
+
+// -------------------------------------------------------------------------- //
+
+// Fastest first, scalar is always supported.
+static auto GetSupportedImplementations() -> std::vector<Base64Implementation>
+{
+    auto implementations = std::vector<Base64Implementation>();
+
+#if SHOWPLAY_BASE64_X86
+    if (HasAVX2())
+    {
+        implementations.push_back({ EncodeAVX2, "AVX2" });
+    }
+
+    if (HasSSSE3())
+    {
+        implementations.push_back({ EncodeSSSE3, "SSSE3" });
+    }
+#endif
+
+    implementations.push_back({ EncodeScalar, "Scalar" });
+    return implementations;
+}
+
+static auto SelectImplementation() -> Base64Implementation
+{
+    return GetSupportedImplementations().front();
+}
+
+static auto GetImplementation() -> const Base64Implementation&
+{
+    static const auto implementation = SelectImplementation();
+    return implementation;
+}
+
+auto Base64Encode(const std::uint8_t* data, std::size_t size, char* out) -> void
+{
+    GetImplementation().Encode(data, size, out);
+}
+
+auto Base64Append(const std::uint8_t* data, std::size_t size, std::string& out) -> void
+{
+    auto offset = out.size();
+    out.resize(offset + Base64EncodedSize(size));
+
+    Base64Encode(data, size, &out[offset]);
+}
+
+auto Base64ImplementationName() -> const char*
+{
+    return GetImplementation().Name;
+}
+
+auto Base64Implementations() -> std::vector<Base64Implementation>
+{
+    return GetSupportedImplementations();
+}
+
+} // namespace foo_showplay
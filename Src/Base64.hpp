@@ -0,0 +1,57 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace foo_showplay {
+
+// Standard alphabet with '=' padding, same output as cpp-base64 base64_encode.
+inline constexpr auto Base64EncodedSize(std::size_t size) -> std::size_t
+{
+    return (size + 2) / 3 * 4;
+}
+
+// Encodes into pre-sized buffer of Base64EncodedSize(size) bytes. Uses AVX2
+// or SSSE3 when CPU supports it, plain table lookup otherwise.
+auto Base64Encode (const std::uint8_t* data, std::size_t size, char* out) -> void;
+
+// Appends encoded data to string, growing it once.
+auto Base64Append (const std::uint8_t* data, std::size_t size, std::string& out) -> void;
+
+// Name of implementation picked for this CPU, for diagnostics.
+auto Base64ImplementationName () -> const char*;
+
+struct Base64Implementation
+{
+    using EncodeFunction = auto (*)(const std::uint8_t* data, std::size_t size, char* out) -> void;
+
+    EncodeFunction Encode;
+    const char*    Name;
+};
+
+// Every implementation this CPU can run, the one Base64Encode picked first.
+// Lets tests and benchmarks force each of them.
+auto Base64Implementations () -> std::vector<Base64Implementation>;
+
+} // namespace foo_showplay
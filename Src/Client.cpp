@@ -23,6 +23,8 @@
 #include "Constants.hpp"
 #include "Main.hpp"
 
+#include <algorithm>
+
 namespace foo_showplay {
 
 auto ShowPlayClient::on_playback_starting(play_control::t_track_command p_command, bool p_paused) -> void
@@ -31,34 +33,54 @@ auto ShowPlayClient::on_playback_starting(play_control::t_track_command p_comman
 
 auto ShowPlayClient::on_playback_new_track(metadb_handle_ptr p_track) -> void
 {
-    SendSongInfo(p_track);
-    SendPlaybackInfo();
+    // Previous track changed before its art came.
+    if (mIsHitPending)
+    {
+        CountPrefetch(false);
+    }
+
+    // Hit only if song was actually served from cache, cover is checked
+    // when its art comes.
+    auto isPrefetched = mPrefetchedTrack.is_valid() && mPrefetchedTrack == p_track;
+    auto songHits     = mSongInfoCache.GetHits();
+    auto song         = GetSongInfo(p_track);
+    if (isPrefetched && mSongInfoCache.GetHits() > songHits)
+    {
+        mIsHitPending  = true;
+        mExpectedCover = mPrefetchedCover;
+    }
+    else
+    {
+        CountPrefetch(false);
+    }
+
+    mSession.OnNewTrack(std::move(song), GetFields(p_track));
+
+    // Track after this one, even if the same was predicted before.
+    mPrefetchTarget.release();
+    PrefetchNextTrack();
 }
 
 auto ShowPlayClient::on_playback_stop(play_control::t_stop_reason p_reason) -> void
 {
-    SendPlaybackInfo(PlaybackState::Nothing, std::nullopt);
+    mSession.OnStop();
 }
 
 auto ShowPlayClient::on_playback_seek(double p_time) -> void
 {
-    SendPlaybackInfo(p_time);
+    mSession.OnSeek(p_time);
 }
 
 auto ShowPlayClient::on_playback_pause(bool p_state) -> void
 {
-    if (p_state)
-    {
-        SendPlaybackInfo(PlaybackState::Paused, std::nullopt);
-    }
-    else
-    {
-        SendPlaybackInfo(PlaybackState::Playing, std::nullopt);
-    }
+    mSession.OnPause(p_state);
 }
 
 auto ShowPlayClient::on_playback_edited(metadb_handle_ptr p_track) -> void
 {
+    // Tags of current track changed, servers need the new ones.
+    mSongInfoCache.Erase(p_track);
+    mSession.OnSongChanged();
 }
 
 auto ShowPlayClient::on_playback_dynamic_info(const file_info& p_info) -> void
@@ -71,7 +93,7 @@ auto ShowPlayClient::on_playback_dynamic_info_track(const file_info& p_info) ->
 
 auto ShowPlayClient::on_playback_time(double p_time) -> void
 {
-    SendPlaybackInfo(p_time);
+    mSession.OnTime(p_time);
 }
 
 auto ShowPlayClient::on_volume_change(float p_new_val) -> void
@@ -80,278 +102,306 @@ auto ShowPlayClient::on_volume_change(float p_new_val) -> void
 
 auto ShowPlayClient::on_album_art(album_art_data::ptr data) -> void
 {
-    SendCoverInfo(data);
+    mSession.OnAlbumArt();
+
+    // Prefetched cover was used, or track has no cover as prefetcher found.
+    if (mIsHitPending)
+    {
+        CountPrefetch(mExpectedCover.has_value() ? mSession.IsCoverCached() : data.is_empty());
+    }
 }
 
-auto ShowPlayClient::OnConnected() -> void
+auto ShowPlayClient::on_changed_sorted(metadb_handle_list_cref p_items_sorted, bool p_fromhook) -> void
 {
-    UpdatePreferencesStatus();
-    SendPlayerInfo();
+    // Cached songs may be formatted from old tags.
+    for (auto i = t_size(0); i < p_items_sorted.get_count(); ++i)
+    {
+        mSongInfoCache.Erase(p_items_sorted[i]);
+    }
 }
 
-auto ShowPlayClient::OnDisconnected() -> void
+auto ShowPlayClient::on_items_added(t_size p_playlist, t_size p_start, metadb_handle_list_cref p_data, const bit_array& p_selection) -> void
 {
-    UpdatePreferencesStatus();
+    PrefetchNextTrack();
 }
 
-auto ShowPlayClient::OnActivated() -> void
+auto ShowPlayClient::on_items_reordered(t_size p_playlist, const t_size* p_order, t_size p_count) -> void
 {
-    UpdatePreferencesStatus();
-    SendPlaybackInfo();
-    SendSongInfo();
-    SendCoverInfo();
+    PrefetchNextTrack();
 }
 
-auto ShowPlayClient::OnDeactivated() -> void
+auto ShowPlayClient::on_items_removed(t_size p_playlist, const bit_array& p_mask, t_size p_old_count, t_size p_new_count) -> void
 {
-    UpdatePreferencesStatus();
+    PrefetchNextTrack();
 }
 
-auto ShowPlayClient::GetPlayerInfo() -> std::optional<PlayerInfo>
+auto ShowPlayClient::on_items_replaced(t_size p_playlist, const bit_array& p_mask, const pfc::list_base_const_t<t_on_items_replaced_entry>& p_data) -> void
 {
-    auto player = PlayerInfo();
-    player.Name = PLAYER_NAME;
-    return player;
+    PrefetchNextTrack();
 }
 
-auto ShowPlayClient::GetPlaybackInfo() -> std::optional<PlaybackInfo>
+auto ShowPlayClient::on_playback_order_changed(t_size p_new_index) -> void
 {
-    // We need to get current playback state.
-    auto playbackControl = static_api_ptr_t<playback_control>();
+    PrefetchNextTrack();
+}
+
+auto ShowPlayClient::HasTrack() -> bool
+{
+    return GetNowPlaying().is_valid();
+}
 
-    auto playback = PlaybackInfo();
+auto ShowPlayClient::GetState() -> PlaybackState
+{
+    auto playbackControl = static_api_ptr_t<playback_control>();
     if (playbackControl->is_paused())
     {
-        playback.State   = PlaybackState::Paused;
-        playback.Elapsed = static_cast<int>(playbackControl->playback_get_position());
+        return PlaybackState::Paused;
     }
-    else if (playbackControl->is_playing())
-    {
-        playback.State   = PlaybackState::Playing;
-        playback.Elapsed = static_cast<int>(playbackControl->playback_get_position());
-    }
-    else
+
+    if (playbackControl->is_playing())
     {
-        playback.State   = PlaybackState::Nothing;
-        playback.Elapsed = std::nullopt;
+        return PlaybackState::Playing;
     }
 
-    return playback;
+    return PlaybackState::Nothing;
 }
 
-auto ShowPlayClient::GetSongInfo() -> std::optional<SongInfo>
+auto ShowPlayClient::GetPosition() -> double
 {
-    // We need to get current song.
-    auto playbackControl = static_api_ptr_t<playback_control>();
-    auto track = metadb_handle_ptr();
-    playbackControl->get_now_playing(track);
-
-    return GetSongInfo(track);
+    return static_api_ptr_t<playback_control>()->playback_get_position();
 }
 
-auto ShowPlayClient::GetCoverInfo() -> std::optional<CoverInfo>
+auto ShowPlayClient::GetSong() -> std::optional<SongInfo>
 {
-    // We need to get current song album art.
-    auto playbackControl = static_api_ptr_t<playback_control>();
-
-    auto track = metadb_handle_ptr();
-    playbackControl->get_now_playing(track);
+    return GetSongInfo(GetNowPlaying());
+}
 
-    if (track.is_empty())
+auto ShowPlayClient::GetCover() -> std::optional<BinaryData>
+{
+    auto artNotifyManager = static_api_ptr_t<now_playing_album_art_notify_manager>();
+    auto art = artNotifyManager->current();
+    if (!art.is_valid())
     {
         return std::nullopt;
     }
 
-    // Get Art.
-    auto artNotifyManager = static_api_ptr_t<now_playing_album_art_notify_manager>();
-    auto art = artNotifyManager->current();
+    // Share image with foobar2000 instead of copying it, deleter keeps
+    // album_art_data alive as long as session uses it.
+    auto data = static_cast<const std::uint8_t*>(art->get_ptr());
+    auto size = static_cast<std::size_t>(art->get_size());
+    auto ptr  = std::shared_ptr<const std::uint8_t>(data, [art](const std::uint8_t*) {});
 
-    return GetCoverInfo(art);
+    return BinaryData(std::move(ptr), size);
 }
 
-auto ShowPlayClient::GetSongInfo(metadb_handle_ptr p_track) -> std::optional<SongInfo>
+auto ShowPlayClient::GetFields() -> std::optional<CustomFields>
 {
-    if (p_track.is_empty())
+    // Nobody asked for any fields.
+    if (mFieldScripts.IsEmpty())
     {
         return std::nullopt;
     }
 
-    auto song   = SongInfo();
-    song.Title  = mFormatScripts.GetTitle(p_track);
-    song.Album  = mFormatScripts.GetAlbum(p_track);
-    song.Artist = mFormatScripts.GetArtist(p_track);
-    song.Date   = mFormatScripts.GetDate(p_track);
-    song.Year = mFormatScripts.GetYear(p_track);
-    song.Path   = mFormatScripts.GetPath(p_track);
-
-    auto lengthStr = mFormatScripts.GetLength(p_track);
-    if (lengthStr.has_value())
-    {
-        song.Length = std::atof(lengthStr.value().c_str());
-    }
-
-    auto trackNumberStr = mFormatScripts.GetTrackNumber(p_track);
-    if (trackNumberStr.has_value())
-    {
-        song.TrackNumber = std::atoi(trackNumberStr.value().c_str());
-    }
-
-    return song;
+    return GetFields(GetNowPlaying());
 }
 
-auto ShowPlayClient::GetCoverInfo(album_art_data::ptr data) -> std::optional<CoverInfo>
+auto ShowPlayClient::StartTimer(std::chrono::milliseconds delay, std::function<void()> callback) -> void
 {
-    // We need to get current song album art.
-    auto playbackControl = static_api_ptr_t<playback_control>();
+    StopTimer();
 
-    auto track = metadb_handle_ptr();
-    playbackControl->get_now_playing(track);
+    mTimerCallback = std::move(callback);
+    mTimer         = SetTimer(nullptr, 0, static_cast<UINT>(delay.count()), &OnTimer);
+}
 
-    if (track.is_empty())
+auto ShowPlayClient::StopTimer() -> void
+{
+    if (mTimer != 0)
     {
-        return std::nullopt;
+        KillTimer(nullptr, mTimer);
+        mTimer = 0;
     }
+}
 
-    // Get Art.
-    auto artNotifyManager = static_api_ptr_t<now_playing_album_art_notify_manager>();
-    auto art = artNotifyManager->current();
-
-    // Create cover.
-    auto cover = CoverInfo();
-    if (art.is_valid())
+VOID CALLBACK ShowPlayClient::OnTimer(HWND, UINT, UINT_PTR, DWORD)
+{
+    // Thread timer, runs on main thread.
+    auto client = GetShowPlayClient();
+    if (client)
     {
-        auto artDataPtr = art.get_ptr();
-        if (artDataPtr != nullptr)
+        // One shot, callback may start it again.
+        client->StopTimer();
+
+        auto callback = std::move(client->mTimerCallback);
+        if (callback)
         {
-            auto data = static_cast<const unsigned char*>(artDataPtr->get_ptr());
-            auto size = static_cast<size_t>(artDataPtr->get_size());
-            cover.Image = base64_encode(data, size);
+            callback();
         }
     }
-
-    return cover;
 }
 
-auto ShowPlayClient::SendPlayerInfo() -> void
+auto ShowPlayClient::OnStatusChanged() -> void
 {
-    // If client is not active then skip sending.
-    if (!mWebSocketPtr.IsActive())
+    auto prefs = GetShowPlayPreferences();
+    if (prefs)
     {
-        return;
+        prefs->UpdateStatus(mSession.GetConnectionStatus());
+        prefs->UpdateToken(mSession.GetToken());
     }
-
-    // Create PlayerInfo.
-    auto player = GetPlayerInfo();
-    SendPayload(Payload(player, std::nullopt, std::nullopt, std::nullopt));
 }
 
-auto ShowPlayClient::SendPlaybackInfo() -> void
+auto ShowPlayClient::OnPrefetched(PrefetchedTrack prefetched) -> void
 {
-    // If client is not active then skip sending.
-    if (!mWebSocketPtr.IsActive())
+    // Prediction changed meanwhile.
+    if (prefetched.Track != mPrefetchTarget)
     {
         return;
     }
 
-    auto playback = GetPlaybackInfo();
-    SendPayload(Payload(std::nullopt, playback, std::nullopt, std::nullopt));
-}
+    if (prefetched.Song.has_value())
+    {
+        mSongInfoCache.Insert(prefetched.Track, std::move(prefetched.Song.value()));
+    }
 
-auto ShowPlayClient::SendSongInfo() -> void
-{
-    // If client is not active then skip sending.
-    if (!mWebSocketPtr.IsActive())
+    if (prefetched.CoverHash.has_value())
     {
-        return;
+        mSession.AddCover(prefetched.CoverHash.value(), std::move(prefetched.Cover));
     }
 
-    auto song = GetSongInfo();
-    SendPayload(Payload(std::nullopt, std::nullopt, song, std::nullopt));
+    mPrefetchedTrack = prefetched.Track;
+    mPrefetchedCover = prefetched.CoverHash;
 }
 
-auto ShowPlayClient::SendCoverInfo() -> void
+auto ShowPlayClient::GetNowPlaying() -> metadb_handle_ptr
 {
-    // If client is not active then skip sending.
-    if (!mWebSocketPtr.IsActive())
-    {
-        return;
-    }
-    
-    auto cover = GetCoverInfo();
-    SendPayload(Payload(std::nullopt, std::nullopt, std::nullopt, cover));
+    auto track = metadb_handle_ptr();
+    static_api_ptr_t<playback_control>()->get_now_playing(track);
+
+    return track;
 }
 
-auto ShowPlayClient::SendPlaybackInfo(double elapsed) -> void
+auto ShowPlayClient::GetSongInfo(metadb_handle_ptr p_track) -> std::optional<SongInfo>
 {
-    // If client is not active then skip sending.
-    if (!mWebSocketPtr.IsActive())
+    if (p_track.is_empty())
     {
-        return;
+        return std::nullopt;
+    }
+
+    auto cached = mSongInfoCache.Find(p_track);
+    if (cached != nullptr)
+    {
+        return *cached;
     }
 
-    auto playback    = PlaybackInfo();
-    playback.State   = std::nullopt;
-    playback.Elapsed = elapsed;
+    auto song = mSongInfoScript.GetInfo(p_track);
+    if (!song.has_value())
+    {
+        return std::nullopt;
+    }
 
-    SendPayload(Payload(std::nullopt, playback, std::nullopt, std::nullopt));
+    return mSongInfoCache.Insert(p_track, std::move(song.value()));
 }
 
-auto ShowPlayClient::SendPlaybackInfo(PlaybackState state, std::optional<double> elapsed) -> void
+auto ShowPlayClient::GetFields(metadb_handle_ptr p_track) -> std::optional<CustomFields>
 {
-    // If client is not active then skip sending.
-    if (!mWebSocketPtr.IsActive())
-    {
-        return;
-    }
+    return mFieldScripts.GetInfo(p_track);
+}
 
-    // Create PlaybackInfo.
-    auto playback    = PlaybackInfo();
-    playback.State   = state;
-    playback.Elapsed = elapsed;
+auto ShowPlayClient::GetCoverLimits() -> CoverLimits
+{
+    auto maxEdge  = std::max<std::int64_t>(0, *gCfgCoverMaxEdge);
+    auto maxBytes = std::max<std::int64_t>(0, *gCfgCoverMaxBytes) * 1024;
 
-    SendPayload(Payload(std::nullopt, playback, std::nullopt, std::nullopt));
+    return CoverLimits(static_cast<std::uint32_t>(maxEdge), static_cast<std::size_t>(maxBytes));
 }
 
-auto ShowPlayClient::SendSongInfo(metadb_handle_ptr p_track) -> void
+auto ShowPlayClient::GetReconnectSettings() -> ReconnectSettings
 {
-    // If client is not active then skip sending.
-    if (!mWebSocketPtr.IsActive())
-    {
-        return;
-    }
+    auto baseDelay       = std::chrono::milliseconds(std::max<std::int64_t>(1, *gCfgReconnectBaseDelay));
+    auto maxDelay        = std::chrono::milliseconds(std::max<std::int64_t>(1, *gCfgReconnectMaxDelay));
+    auto pingInterval    = std::chrono::seconds(std::max<std::int64_t>(0, *gCfgPingInterval));
+    auto deadPeerTimeout = std::chrono::seconds(std::max<std::int64_t>(0, *gCfgDeadPeerTimeout));
 
-    auto song = GetSongInfo(p_track);
-    SendPayload(Payload(std::nullopt, std::nullopt, song, std::nullopt));
+    return ReconnectSettings(baseDelay, maxDelay, pingInterval, deadPeerTimeout, CIRCUIT_FAILURE_THRESHOLD);
 }
 
-auto ShowPlayClient::SendCoverInfo(album_art_data::ptr data) -> void
+auto ShowPlayClient::GetNextTrack() -> metadb_handle_ptr
 {
-    // If client is not active then skip sending.
-    if (!mWebSocketPtr.IsActive())
+    auto track = metadb_handle_ptr();
+
+    auto playbackControl = static_api_ptr_t<playback_control>();
+    if (playbackControl->get_stop_after_current())
     {
-        return;
+        return track;
+    }
+
+    // Queued tracks go first.
+    auto playlistManager = static_api_ptr_t<playlist_manager>();
+    auto queue = pfc::list_t<t_playback_queue_item>();
+    playlistManager->queue_get_contents(queue);
+    if (queue.get_count() > 0)
+    {
+        return queue[0].m_handle;
+    }
+
+    auto playlist = t_size(0);
+    auto index    = t_size(0);
+    if (!playlistManager->get_playing_item_location(&playlist, &index))
+    {
+        return track;
+    }
+
+    // Random orders can't be predicted.
+    auto order = std::string_view(playlistManager->playback_order_get_name(playlistManager->playback_order_get_active()));
+    auto count = playlistManager->playlist_get_item_count(playlist);
+    if (order == "Repeat (track)")
+    {
+        playlistManager->playlist_get_item_handle(track, playlist, index);
+    }
+    else if (order == "Default" && index + 1 < count)
+    {
+        playlistManager->playlist_get_item_handle(track, playlist, index + 1);
+    }
+    else if (order == "Repeat (playlist)" && count > 0)
+    {
+        playlistManager->playlist_get_item_handle(track, playlist, (index + 1) % count);
     }
 
-    auto cover = GetCoverInfo(data);
-    SendPayload(Payload(std::nullopt, std::nullopt, std::nullopt, cover));
+    return track;
 }
 
-auto ShowPlayClient::SendPayload(Payload payload) -> void
+auto ShowPlayClient::CountPrefetch(bool isHit) -> void
 {
-    auto json = nlohmann::json(payload);
+    if (isHit)
+    {
+        mPrefetchHits += 1;
+    }
+    else
+    {
+        mPrefetchMisses += 1;
+    }
 
-    mWebSocketPtr.Send(json);
+    mIsHitPending  = false;
+    mExpectedCover = std::nullopt;
 }
 
-auto ShowPlayClient::UpdatePreferencesStatus() -> void
+auto ShowPlayClient::PrefetchNextTrack() -> void
 {
-    auto prefs = GetShowPlayPreferences();
-    if (prefs)
+    // Prediction holds, prefetched song and cover stay useful.
+    auto track = GetNextTrack();
+    if (track == mPrefetchTarget)
+    {
+        return;
+    }
+
+    mPrefetchedTrack.release();
+    mPrefetchedCover = std::nullopt;
+    mPrefetchTarget  = track;
+    if (mPrefetchTarget.is_empty())
     {
-        prefs->UpdateStatus(mWebSocketPtr.IsConnected());
-        prefs->UpdateToken(mWebSocketPtr.GetToken());
+        return;
     }
+
+    mPrefetcher.Submit(mPrefetchTarget, GetCoverLimits(), mSession.AnyCoverBase64());
 }
 
 } // namespace foo_showplay
-
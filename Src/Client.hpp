@@ -20,20 +20,47 @@
 #pragma once
 
 #include <foobar2000.h>
+#include <memory>
+#include <vector>
 
 #include "Payload.hpp"
+#include "Player.hpp"
 #include "Preferences.hpp"
+#include "Session.hpp"
+#include "SongInfoCache.hpp"
 #include "TitleFormatScripts.hpp"
-#include "WebSocket.hpp"
+#include "TrackPrefetcher.hpp"
+#include "WicImageCodec.hpp"
+#include "Constants.hpp"
 
 namespace foo_showplay {
 
-class ShowPlayClient : private play_callback_impl_base
+// foobar2000 side of ShowPlay: reports playback to session and reads songs,
+// fields and covers from foobar2000.
+class ShowPlayClient
+    : private play_callback_impl_base
+    , private metadb_io_callback_dynamic_impl_base
+    , private playlist_callback_impl_base
+    , private Player
+    , private Host
 {
-    WebSocketClient mWebSocketPtr;
-    FormatScripts   mFormatScripts;
+    SongInfoScript   mSongInfoScript;
+    SongInfoCache    mSongInfoCache;
+    FieldScripts     mFieldScripts;
+    TrackPrefetcher  mPrefetcher;
+    UINT_PTR         mTimer;
+    std::function<void()> mTimerCallback;
+    ShowPlaySession  mSession; // After everything it reads through Player.
     now_playing_album_art_notify* mArtNotify;
 
+    metadb_handle_ptr            mPrefetchTarget;  // Track submitted to prefetcher.
+    metadb_handle_ptr            mPrefetchedTrack; // Track whose info and cover are cached ahead.
+    std::optional<std::uint64_t> mPrefetchedCover; // Hash of its cover, none if it has none.
+    std::optional<std::uint64_t> mExpectedCover;   // Prefetched cover of new track, until its art comes.
+    bool                         mIsHitPending;    // New track song was cached, hit if cover is too.
+    std::uint64_t                mPrefetchHits;
+    std::uint64_t                mPrefetchMisses;
+
     // Playback callback methods.
     auto on_playback_starting           (play_control::t_track_command p_command, bool p_paused) -> void;
     auto on_playback_new_track          (metadb_handle_ptr p_track)            -> void;
@@ -47,45 +74,70 @@ class ShowPlayClient : private play_callback_impl_base
     auto on_volume_change               (float p_new_val)                      -> void;
     auto on_album_art                   (album_art_data::ptr data)             -> void;
 
-    // WebSocket Client callbacks.
-    auto OnConnected    () -> void;
-    auto OnDisconnected () -> void;
-    auto OnActivated    () -> void;
-    auto OnDeactivated  () -> void;
-
-    auto InMainThreadOnConnected    () -> void { fb2k::inMainThread([this]() { OnConnected    (); }); }
-    auto InMainThreadOnDisconnected () -> void { fb2k::inMainThread([this]() { OnDisconnected (); }); }
-    auto InMainThreadOnActivated    () -> void { fb2k::inMainThread([this]() { OnActivated    (); }); }
-    auto InMainThreadOnDeactivated  () -> void { fb2k::inMainThread([this]() { OnDeactivated  (); }); }
-
-    auto GetPlayerInfo   ()                          -> std::optional<PlayerInfo>;
-    auto GetPlaybackInfo ()                          -> std::optional<PlaybackInfo>;
-    auto GetSongInfo     ()                          -> std::optional<SongInfo>;
-    auto GetCoverInfo    ()                          -> std::optional<CoverInfo>;
+    // Metadb callback methods.
+    auto on_changed_sorted (metadb_handle_list_cref p_items_sorted, bool p_fromhook) -> void;
+
+    // Playlist callback methods, next track may change with them.
+    auto on_items_added            (t_size p_playlist, t_size p_start, metadb_handle_list_cref p_data, const bit_array& p_selection) -> void;
+    auto on_items_reordered        (t_size p_playlist, const t_size* p_order, t_size p_count) -> void;
+    auto on_items_removed          (t_size p_playlist, const bit_array& p_mask, t_size p_old_count, t_size p_new_count) -> void;
+    auto on_items_replaced         (t_size p_playlist, const bit_array& p_mask, const pfc::list_base_const_t<t_on_items_replaced_entry>& p_data) -> void;
+    auto on_playback_order_changed (t_size p_new_index) -> void;
+
+    // Player methods.
+    auto GetName        () -> std::string override { return PLAYER_NAME; }
+    auto HasTrack       () -> bool override;
+    auto GetState       () -> PlaybackState override;
+    auto GetPosition    () -> double override;
+    auto GetSong        () -> std::optional<SongInfo> override;
+    auto GetCover       () -> std::optional<BinaryData> override;
+    auto SetFieldSchema (const FieldSchema& schema) -> void override { mFieldScripts.SetSchema(schema); }
+    auto GetFields      () -> std::optional<CustomFields> override;
+
+    // Host methods.
+    auto InMainThread    (std::function<void()> task) -> void override { fb2k::inMainThread(std::move(task)); }
+    auto StartTimer      (std::chrono::milliseconds delay, std::function<void()> callback) -> void override;
+    auto StopTimer       () -> void override;
+    auto Log             (const std::string& message) -> void override { console::info(message.c_str()); }
+    auto OnStatusChanged () -> void override;
+
+    static VOID CALLBACK OnTimer (HWND, UINT, UINT_PTR, DWORD);
+
+    // Track Prefetcher callbacks.
+    auto OnPrefetched (PrefetchedTrack prefetched) -> void;
+
+    auto InMainThreadOnPrefetched (PrefetchedTrack prefetched) -> void { fb2k::inMainThread([this, prefetched]() { OnPrefetched (prefetched); }); }
+
+    auto GetNowPlaying   ()                          -> metadb_handle_ptr;
     auto GetSongInfo     (metadb_handle_ptr p_track) -> std::optional<SongInfo>;
-    auto GetCoverInfo    (album_art_data::ptr data)  -> std::optional<CoverInfo>;
-
-    auto SendPlayerInfo   () -> void;
-    auto SendPlaybackInfo () -> void;
-    auto SendSongInfo     () -> void;
-    auto SendCoverInfo    () -> void;
-    auto SendPlaybackInfo (double elapsed) -> void;
-    auto SendPlaybackInfo (PlaybackState state, std::optional<double> elapsed) -> void;
-    auto SendSongInfo     (metadb_handle_ptr p_track) -> void;
-    auto SendCoverInfo    (album_art_data::ptr data)  -> void;
-
-    auto SendPayload (Payload payload) -> void;
+    auto GetFields       (metadb_handle_ptr p_track) -> std::optional<CustomFields>;
+    auto GetCoverLimits  ()                          -> CoverLimits;
+    auto GetReconnectSettings ()                     -> ReconnectSettings;
 
-    auto UpdatePreferencesStatus () -> void;
+    auto GetNextTrack    ()                          -> metadb_handle_ptr;
+    auto CountPrefetch   (bool isHit)                -> void;
 
 public:
     ShowPlayClient()
+        : playlist_callback_impl_base(
+              flag_on_items_added | flag_on_items_reordered | flag_on_items_removed |
+              flag_on_items_replaced | flag_on_playback_order_changed
+          )
+        , mSongInfoCache   (SONG_CACHE_SIZE)
+        , mPrefetcher      ([]() { return std::make_unique<WicImageCodec>(); })
+        , mTimer           (0)
+        , mSession         (*this, *this, []() { return std::make_unique<WicImageCodec>(); }, GetReconnectSettings())
+        , mPrefetchedCover (std::nullopt)
+        , mExpectedCover   (std::nullopt)
+        , mIsHitPending    (false)
+        , mPrefetchHits    (0)
+        , mPrefetchMisses  (0)
     {
         // Register callbacks.
-        mWebSocketPtr.SetOnConnectedCallback    ([this]() { InMainThreadOnConnected    (); });
-        mWebSocketPtr.SetOnDisconnectedCallback ([this]() { InMainThreadOnDisconnected (); });
-        mWebSocketPtr.SetOnActivatedCallback    ([this]() { InMainThreadOnActivated    (); });
-        mWebSocketPtr.SetOnDeactivatedCallback  ([this]() { InMainThreadOnDeactivated  (); });
+        mSession.SetMaxSendRate(static_cast<int>(*gCfgMaxSendRate));
+        mSession.SetCoverLimits(GetCoverLimits());
+
+        mPrefetcher.SetOnPrefetchedCallback([this](PrefetchedTrack prefetched) { InMainThreadOnPrefetched (std::move(prefetched)); });
 
         // Add art notify callback.
         auto artNotifyManager = static_api_ptr_t<now_playing_album_art_notify_manager>();
@@ -94,6 +146,8 @@ public:
 
     ~ShowPlayClient()
     {
+        StopTimer();
+
         // Delete art notify callback.
         if (mArtNotify)
         {
@@ -104,21 +158,53 @@ public:
 
     auto Start () -> void
     {
-        mWebSocketPtr.TryConnect(gCfgServerUrl->c_str());
+        Connect(gCfgServerUrl->c_str());
     }
 
     auto Stop  () -> void
     {
-        mWebSocketPtr.Disconnect();
+        mSession.Disconnect();
     }
 
-    auto Connect (std::string url) -> void
+    // List of server urls separated by ';'. Endpoints of urls that stay in
+    // the list keep their connection.
+    auto Connect (std::string urls) -> void
     {
-        mWebSocketPtr.TryConnect(url);
+        mSession.Connect(std::move(urls));
     }
 
-    auto IsConnected () const -> bool                       { return mWebSocketPtr.IsConnected(); }
-    auto GetToken    () const -> std::optional<std::string> { return mWebSocketPtr.GetToken(); }
+    auto SetMaxSendRate (int framesPerSecond) -> void
+    {
+        mSession.SetMaxSendRate(framesPerSecond);
+    }
+
+    // Reads reconnect preferences, used from next connection attempt.
+    auto UpdateReconnectSettings () -> void
+    {
+        mSession.SetReconnectSettings(GetReconnectSettings());
+    }
+
+    // Reads cover limits, cached covers were made with old ones.
+    auto ResetCovers () -> void
+    {
+        mSession.SetCoverLimits(GetCoverLimits());
+        mSession.OnAlbumArt();
+    }
+
+    auto GetConnectionStatus () const -> std::string                { return mSession.GetConnectionStatus(); }
+    auto GetToken            () const -> std::optional<std::string> { return mSession.GetToken(); }
+
+    auto GetSession () const -> const ShowPlaySession& { return mSession; }
+
+    // Predicts next track again and prefetches it if prediction changed.
+    // Called on track change and when playback queue, playlist, playback
+    // order or stop after current change.
+    auto PrefetchNextTrack () -> void;
+
+    auto GetSongCacheHits   () const -> std::uint64_t            { return mSongInfoCache.GetHits();   }
+    auto GetSongCacheMisses () const -> std::uint64_t            { return mSongInfoCache.GetMisses(); }
+    auto GetPrefetchHits    () const -> std::uint64_t            { return mPrefetchHits;   } // Track changes with next track ready.
+    auto GetPrefetchMisses  () const -> std::uint64_t            { return mPrefetchMisses; }
 };
 
 } // namespace foo_showplay
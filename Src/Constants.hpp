@@ -19,9 +19,67 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+
 namespace foo_showplay {
 
 inline constexpr auto PLAYER_NAME        = "foobar2000";
 inline constexpr auto DEFAULT_SERVER_URL = "ws://127.0.0.1:8585/";
+inline constexpr auto COVER_CACHE_SIZE   = 8;
+inline constexpr auto SONG_CACHE_SIZE    = 64;
+inline constexpr auto SEND_QUEUE_SIZE    = std::size_t(64);
+inline constexpr auto SCHEMA_SIZE        = std::size_t(32); // Fields per server, one FieldMask bit each.
+
+// Cover transcoding, 0 means no limit.
+inline constexpr auto DEFAULT_COVER_MAX_EDGE  = 0;
+inline constexpr auto DEFAULT_COVER_MAX_BYTES = 0; // In KiB.
+
+// Anchor mode, new anchor is sent when extrapolated position is off by more.
+inline constexpr auto ANCHOR_DRIFT_THRESHOLD = 0.5; // In seconds.
+
+// Frames per second, bursts of events are coalesced. 0 means no limit.
+inline constexpr auto DEFAULT_MAX_SEND_RATE = 4;
+
+// Reconnect policy, delays are randomized within window.
+inline constexpr auto DEFAULT_RECONNECT_BASE_DELAY = 1000;  // In milliseconds.
+inline constexpr auto DEFAULT_RECONNECT_MAX_DELAY  = 60000; // In milliseconds.
+inline constexpr auto DEFAULT_PING_INTERVAL        = 30;    // In seconds, 0 disables.
+inline constexpr auto DEFAULT_DEAD_PEER_TIMEOUT    = 75;    // In seconds, 0 disables.
+inline constexpr auto CIRCUIT_FAILURE_THRESHOLD    = 8;
+inline constexpr auto DEAD_PEER_CHECK_INTERVAL     = std::chrono::seconds(1);
+
+// Frames at least this large are compressed, if server supports it.
+inline constexpr auto COMPRESSION_THRESHOLD = std::size_t(256);
+inline constexpr auto COMPRESSION_LEVEL     = 6;
+
+// Tracks remembered while disconnected, sent to server on reconnect.
+inline constexpr auto TRACK_HISTORY_SIZE = std::size_t(16);
+
+// Stats section is sent with playback updates at most this often.
+inline constexpr auto STATS_INTERVAL = std::chrono::seconds(10);
+
+// Frames awaiting server ack, per connection. Frames without ack for longer
+// than timeout are counted as stuck.
+inline constexpr auto ACK_WINDOW_SIZE   = std::size_t(64);
+inline constexpr auto ACK_STUCK_TIMEOUT = std::chrono::seconds(5);
+
+// Clock offset is taken from fastest round trip among this many last acks,
+// old minimum expires so clock drift and route changes are followed.
+inline constexpr auto ACK_OFFSET_WINDOW = std::size_t(64);
+
+// Protocol.
+inline constexpr auto FEATURE_DELTA           = "Delta";
+inline constexpr auto FEATURE_CBOR            = "CBOR";
+inline constexpr auto FEATURE_COVER_HASH      = "CoverHash";
+inline constexpr auto FEATURE_BINARY_COVER    = "BinaryCover";
+inline constexpr auto FEATURE_ANCHOR          = "Anchor";
+inline constexpr auto FEATURE_DEFLATE         = "Deflate";
+inline constexpr auto FEATURE_SONG_DICTIONARY = "SongDictionary";
+inline constexpr auto FEATURE_STATS           = "Stats";
+inline constexpr auto FEATURE_ACK             = "Ack";
+inline constexpr auto FEATURE_SYNC            = "Sync";
+inline constexpr auto REQUEST_SNAPSHOT        = "Snapshot";
+inline constexpr auto REQUEST_COVER           = "Cover";
 
 } // namespace foo_showplay
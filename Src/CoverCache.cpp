@@ -0,0 +1,65 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "CoverCache.hpp"
+
+namespace foo_showplay {
+
+auto CoverCache::Insert(std::uint64_t hash, BinaryData image) -> CachedCover&
+{
+    // Already cached, just mark as recently used.
+    auto entry = Find(hash);
+    if (entry != nullptr)
+    {
+        return *entry;
+    }
+
+    mEntries.emplace_front(hash, std::move(image));
+    mIndex[hash] = mEntries.begin();
+
+    // Drop least recently used.
+    while (mEntries.size() > mCapacity)
+    {
+        mIndex.erase(mEntries.back().Hash);
+        mEntries.pop_back();
+    }
+
+    return mEntries.front();
+}
+
+auto CoverCache::Find(std::uint64_t hash) -> CachedCover*
+{
+    auto indexIt = mIndex.find(hash);
+    if (indexIt == mIndex.end())
+    {
+        return nullptr;
+    }
+
+    mEntries.splice(mEntries.begin(), mEntries, indexIt->second);
+    return &mEntries.front();
+}
+
+auto CoverCache::Clear() -> void
+{
+    mIndex.clear();
+    mEntries.clear();
+}
+
+} // namespace foo_showplay
@@ -0,0 +1,64 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+#include "Serializer.hpp"
+
+namespace foo_showplay {
+
+struct CachedCover
+{
+    std::uint64_t Hash;
+    BinaryData    Image;
+
+    CachedCover(std::uint64_t hash, BinaryData image)
+        : Hash  (hash)
+        , Image (std::move(image))
+    {
+    }
+};
+
+// LRU of recent covers keyed by content hash. Keeps encoded image around so
+// the same album art isn't encoded again for every track of an album.
+class CoverCache
+{
+    using EntryList = std::list<CachedCover>;
+
+    EntryList                                              mEntries; // Most recently used first.
+    std::unordered_map<std::uint64_t, EntryList::iterator> mIndex;
+    std::size_t                                            mCapacity;
+
+public:
+    CoverCache(std::size_t capacity)
+        : mCapacity (capacity)
+    {
+    }
+
+    auto Insert (std::uint64_t hash, BinaryData image) -> CachedCover&;
+    auto Find   (std::uint64_t hash)                   -> CachedCover*;
+
+    auto Clear  () -> void;
+};
+
+} // namespace foo_showplay
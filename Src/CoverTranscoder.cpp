@@ -0,0 +1,188 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "CoverTranscoder.hpp"
+
+#include <algorithm>
+
+namespace foo_showplay {
+
+// Qualities tried in order until encoded cover fits in byte budget.
+static constexpr int JPEG_QUALITIES[] = { 90, 80, 70, 60, 50 };
+
+// Don't shrink cover below this to meet byte budget.
+static constexpr std::uint32_t MIN_EDGE = 64;
+
+static auto ToBinaryData(std::vector<std::uint8_t> bytes) -> BinaryData
+{
+    auto buffer = std::make_shared<std::vector<std::uint8_t>>(std::move(bytes));
+    auto data   = buffer->data();
+    auto size   = buffer->size();
+
+    return BinaryData(std::shared_ptr<const std::uint8_t>(std::move(buffer), data), size);
+}
+
+CoverTranscoder::CoverTranscoder(CodecFactory codecFactory)
+    : mCodecFactory (std::move(codecFactory))
+    , mPendingJob   (std::nullopt)
+    , mIsStopping   (false)
+{
+    mThread = std::thread([this]() { Run(); });
+}
+
+CoverTranscoder::~CoverTranscoder()
+{
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        mIsStopping = true;
+    }
+
+    mCondition.notify_one();
+    mThread.join();
+}
+
+auto CoverTranscoder::SetOnTranscodedCallback(OnTranscodedCallback callback) -> void
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    mOnTranscodedCallback = std::move(callback);
+}
+
+auto CoverTranscoder::Submit(std::uint64_t hash, BinaryData image, CoverLimits limits) -> void
+{
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        mPendingJob = Job{ hash, std::move(image), limits };
+    }
+
+    mCondition.notify_one();
+}
+
+auto CoverTranscoder::Run() -> void
+{
+    // Codec is created here, it may need thread specific setup.
+    auto codec = mCodecFactory();
+
+    for (;;)
+    {
+        auto job      = Job();
+        auto callback = OnTranscodedCallback();
+        {
+            auto lock = std::unique_lock<std::mutex>(mMutex);
+            mCondition.wait(lock, [this]() { return mIsStopping || mPendingJob.has_value(); });
+
+            if (mIsStopping)
+            {
+                return;
+            }
+
+            job      = std::move(mPendingJob.value());
+            callback = mOnTranscodedCallback;
+            mPendingJob.reset();
+        }
+
+        auto image = codec != nullptr ? Transcode(*codec, job.Image, job.Limits) : job.Image;
+        if (callback)
+        {
+            callback(job.Hash, std::move(image));
+        }
+    }
+}
+
+auto CoverTranscoder::Transcode(ImageCodec& codec, const BinaryData& image, const CoverLimits& limits) -> BinaryData
+{
+    auto decoded = codec.Decode(image.Data.get(), image.Size);
+    if (!decoded.has_value())
+    {
+        return image;
+    }
+
+    // Fit longest edge, keep aspect ratio.
+    auto width  = decoded->Width;
+    auto height = decoded->Height;
+    auto edge   = std::max(width, height);
+    if (limits.MaxEdge != 0 && edge > limits.MaxEdge)
+    {
+        width  = std::max<std::uint32_t>(1, static_cast<std::uint32_t>(std::uint64_t(width)  * limits.MaxEdge / edge));
+        height = std::max<std::uint32_t>(1, static_cast<std::uint32_t>(std::uint64_t(height) * limits.MaxEdge / edge));
+    }
+
+    auto isTooLarge = limits.MaxBytes != 0 && image.Size > limits.MaxBytes;
+    auto isResized  = width != decoded->Width || height != decoded->Height;
+    if (!isTooLarge && !isResized)
+    {
+        return image;
+    }
+
+    if (isResized)
+    {
+        decoded = codec.Resize(decoded.value(), width, height);
+        if (!decoded.has_value())
+        {
+            return image;
+        }
+    }
+
+    // Lower quality first, then size, until cover fits in budget.
+    auto smallest = std::optional<std::vector<std::uint8_t>>();
+    for (;;)
+    {
+        for (auto quality : JPEG_QUALITIES)
+        {
+            auto encoded = codec.EncodeJpeg(decoded.value(), quality);
+            if (!encoded.has_value())
+            {
+                break;
+            }
+
+            if (limits.MaxBytes == 0 || encoded->size() <= limits.MaxBytes)
+            {
+                return ToBinaryData(std::move(encoded.value()));
+            }
+
+            if (!smallest.has_value() || encoded->size() < smallest->size())
+            {
+                smallest = std::move(encoded);
+            }
+        }
+
+        width  = decoded->Width  * 3 / 4;
+        height = decoded->Height * 3 / 4;
+        if (std::max(width, height) < MIN_EDGE || std::min(width, height) == 0)
+        {
+            break;
+        }
+
+        decoded = codec.Resize(decoded.value(), width, height);
+        if (!decoded.has_value())
+        {
+            break;
+        }
+    }
+
+    // Budget can't be met, send smallest we've got.
+    if (smallest.has_value() && (isResized || smallest->size() < image.Size))
+    {
+        return ToBinaryData(std::move(smallest.value()));
+    }
+
+    return image;
+}
+
+} // namespace foo_showplay
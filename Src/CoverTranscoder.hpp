@@ -0,0 +1,99 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "ImageCodec.hpp"
+#include "Serializer.hpp"
+
+namespace foo_showplay {
+
+struct CoverLimits
+{
+    std::uint32_t MaxEdge;  // Longest side in pixels, 0 means any.
+    std::size_t   MaxBytes; // Encoded size, 0 means any.
+
+    CoverLimits()
+        : MaxEdge  (0)
+        , MaxBytes (0)
+    {
+    }
+
+    CoverLimits(std::uint32_t maxEdge, std::size_t maxBytes)
+        : MaxEdge  (maxEdge)
+        , MaxBytes (maxBytes)
+    {
+    }
+
+    auto IsEnabled () const -> bool { return MaxEdge != 0 || MaxBytes != 0; }
+};
+
+// Downsamples and re-encodes album art on worker thread, so covers that are
+// too large don't block main thread nor get sent to server as they are.
+class CoverTranscoder
+{
+public:
+    using CodecFactory          = std::function<std::unique_ptr<ImageCodec>()>;
+    using OnTranscodedCallback  = std::function<void(std::uint64_t hash, BinaryData image)>;
+
+private:
+    struct Job
+    {
+        std::uint64_t Hash;
+        BinaryData    Image;
+        CoverLimits   Limits;
+    };
+
+    CodecFactory            mCodecFactory;
+    OnTranscodedCallback    mOnTranscodedCallback;
+
+    std::mutex              mMutex;
+    std::condition_variable mCondition;
+    std::optional<Job>      mPendingJob; // Only latest cover matters, older are replaced.
+    bool                    mIsStopping;
+    std::thread             mThread;
+
+    auto Run () -> void;
+
+public:
+    CoverTranscoder(CodecFactory codecFactory);
+    ~CoverTranscoder();
+
+    CoverTranscoder(const CoverTranscoder&)            = delete;
+    CoverTranscoder& operator=(const CoverTranscoder&) = delete;
+
+    // Callback is invoked on transcoder thread.
+    auto SetOnTranscodedCallback (OnTranscodedCallback callback) -> void;
+
+    auto Submit (std::uint64_t hash, BinaryData image, CoverLimits limits) -> void;
+
+    // Returns image that fits in limits, or original image if it already does
+    // or it can't be decoded.
+    static auto Transcode (ImageCodec& codec, const BinaryData& image, const CoverLimits& limits) -> BinaryData;
+};
+
+} // namespace foo_showplay
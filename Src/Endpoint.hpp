@@ -0,0 +1,56 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <cstdint>
+
+#include "Metrics.hpp"
+#include "PayloadSender.hpp"
+#include "WebSocket.hpp"
+
+namespace foo_showplay {
+
+// One ShowPlay server. Connection, token, features and server side state
+// (last frame, known covers) are per endpoint, payloads are shared.
+class Endpoint
+{
+    WebSocketClient mWebSocket;
+    PayloadSender   mSender; // Declared after socket, stopped before it.
+
+public:
+    Endpoint(ReconnectSettings settings, Metrics& metrics)
+        : mWebSocket (settings, metrics)
+        , mSender    (mWebSocket, metrics)
+    {
+    }
+
+    Endpoint(const Endpoint&)            = delete;
+    Endpoint& operator=(const Endpoint&) = delete;
+
+    auto GetWebSocket ()       -> WebSocketClient&       { return mWebSocket; }
+    auto GetWebSocket () const -> const WebSocketClient& { return mWebSocket; }
+    auto GetSender    ()       -> PayloadSender&         { return mSender;    }
+    auto GetSender    () const -> const PayloadSender&   { return mSender;    }
+
+    // Version server confirmed, not the one handed to sender.
+    auto GetSyncedVersion () -> std::uint64_t { return mSender.GetSyncedVersion(); }
+};
+
+} // namespace foo_showplay
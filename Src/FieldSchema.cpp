@@ -0,0 +1,136 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "FieldSchema.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <tuple>
+
+namespace foo_showplay {
+
+template <typename T>
+static auto ToNumber(std::string_view value) -> FieldValue
+{
+    auto number = T();
+    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (error != std::errc())
+    {
+        return std::monostate();
+    }
+
+    return number;
+}
+
+auto ParseFieldType(std::string_view type) -> std::optional<FieldType>
+{
+    if (type == "String")  return FieldType::String;
+    if (type == "Integer") return FieldType::Integer;
+    if (type == "Number")  return FieldType::Number;
+
+    return std::nullopt;
+}
+
+auto ParseFieldValue(std::string_view formatted, FieldType type) -> FieldValue
+{
+    if (formatted == "?")
+    {
+        return std::monostate();
+    }
+
+    switch (type)
+    {
+    case FieldType::Integer: return ToNumber<std::int64_t>(formatted);
+    case FieldType::Number:  return ToNumber<double>(formatted);
+    default:                 return std::string(formatted);
+    }
+}
+
+auto NormalizeSchema(FieldSchema schema) -> FieldSchema
+{
+    auto byName = [](const SchemaField& a, const SchemaField& b) { return a.Name < b.Name; };
+    auto isSame = [](const SchemaField& a, const SchemaField& b) { return a.Name == b.Name; };
+
+    std::stable_sort(schema.begin(), schema.end(), byName);
+    schema.erase(std::unique(schema.begin(), schema.end(), isSame), schema.end());
+
+    return schema;
+}
+
+// Whole definition, schema of one server sorted by name is sorted by it too.
+template <typename Field>
+static auto GetKey(const Field& field)
+{
+    return std::tie(field.Name, field.Expression, field.Type);
+}
+
+auto MergeSchemas(const std::vector<std::shared_ptr<const FieldSchema>>& schemas) -> FieldSchema
+{
+    auto merged = FieldSchema();
+    for (const auto& schema : schemas)
+    {
+        if (schema != nullptr)
+        {
+            merged.insert(merged.end(), schema->begin(), schema->end());
+        }
+    }
+
+    // Same name with other expression or type is other field, both are
+    // evaluated and each server gets its own.
+    auto byKey  = [](const SchemaField& a, const SchemaField& b) { return GetKey(a) < GetKey(b); };
+    auto isSame = [](const SchemaField& a, const SchemaField& b) { return GetKey(a) == GetKey(b); };
+
+    std::sort(merged.begin(), merged.end(), byKey);
+    merged.erase(std::unique(merged.begin(), merged.end(), isSame), merged.end());
+
+    return merged;
+}
+
+auto FindConflicts(const FieldSchema& schema) -> std::vector<std::string>
+{
+    auto names = std::vector<std::string>();
+    for (auto i = std::size_t(1); i < schema.size(); ++i)
+    {
+        if (schema[i].Name == schema[i - 1].Name && (names.empty() || names.back() != schema[i].Name))
+        {
+            names.push_back(schema[i].Name);
+        }
+    }
+
+    return names;
+}
+
+auto FilterFields(CustomFields& fields, const FieldSchema& schema) -> void
+{
+    auto isWanted = [&schema](const CustomField& field)
+    {
+        auto it = std::lower_bound(schema.begin(), schema.end(), field, [](const SchemaField& schemaField, const CustomField& field)
+        {
+            return GetKey(schemaField) < GetKey(field);
+        });
+
+        return it != schema.end() && GetKey(*it) == GetKey(field);
+    };
+
+    auto& values = fields.Values;
+    values.erase(std::remove_if(values.begin(), values.end(), [&](const CustomField& field) { return !isWanted(field); }), values.end());
+}
+
+} // namespace foo_showplay
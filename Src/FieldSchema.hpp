@@ -0,0 +1,69 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Payload.hpp"
+
+namespace foo_showplay {
+
+// Field server asked for, Expression is titleformat script.
+struct SchemaField
+{
+    std::string Name;
+    std::string Expression;
+    FieldType   Type;
+
+    SchemaField()
+        : Type (FieldType::String)
+    {
+    }
+};
+
+// Sorted by name. Names are unique in schema of one server, merged schema
+// has the same name more than once if servers define it differently.
+using FieldSchema = std::vector<SchemaField>;
+
+auto ParseFieldType  (std::string_view type) -> std::optional<FieldType>;
+
+// Converts titleformat output to value of given type, missing field ("?")
+// and malformed number are null.
+auto ParseFieldValue (std::string_view formatted, FieldType type) -> FieldValue;
+
+// Sorts fields of one server by name, first of fields with the same name
+// wins.
+auto NormalizeSchema (FieldSchema schema) -> FieldSchema;
+
+// Union of schemas, the one evaluated for all servers. Fields are the same
+// if name, expression and type are.
+auto MergeSchemas    (const std::vector<std::shared_ptr<const FieldSchema>>& schemas) -> FieldSchema;
+
+// Names defined differently by servers, in merged schema.
+auto FindConflicts   (const FieldSchema& schema) -> std::vector<std::string>;
+
+// Keeps only values evaluated from definitions in schema.
+auto FilterFields    (CustomFields& fields, const FieldSchema& schema) -> void;
+
+} // namespace foo_showplay
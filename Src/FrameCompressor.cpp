@@ -0,0 +1,112 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "FrameCompressor.hpp"
+
+namespace foo_showplay {
+
+// Deflate looks back into dictionary, most common strings are closest to
+// the end. Changing it requires new dictionary id.
+static constexpr char SONG_DICTIONARY[] =
+    ".mp3\",\".m4a\",\".ogg\",\".opus\",\".wav\",\"Disc 1\",\"Various Artists\",\"Original Mix\","
+    "\"Remastered\",\" (feat. \",\" - \",\"Soundtrack\",\"Live\",\"Remix\",\"Edit\","
+    "\"Sync\":null,\"Player\":{\"Name\":\"foobar2000\"},\"Player\":null,"
+    "\"Cover\":{\"Attachment\":null,\"Hash\":\"\",\"Image\":null},\"Cover\":null,"
+    "\"Playback\":{\"Elapsed\":null,\"Rate\":null,\"State\":0,\"Timestamp\":null},"
+    "\"Playback\":{\"Elapsed\":0.0,\"Rate\":1.0,\"State\":2,\"Timestamp\":"
+    "\"Path\":\"file://C:\\\\Users\\\\Music\\\\\",\"Path\":\"file://D:\\\\Music\\\\\",\".flac\","
+    "\"Song\":{\"Album\":\"\",\"Artist\":\"\",\"Date\":\"\",\"Length\":0.0,\"Path\":\"file://\","
+    "\"Title\":\"\",\"TrackNumber\":1,\"Year\":\"\"},\"Song\":null,"
+    "{\"Base\":0,\"Cover\":null,\"Frame\":1,\"Playback\":null,\"Token\":\"";
+
+FrameCompressor::FrameCompressor(int level)
+    : mStream        ()
+    , mIsInitialized (false)
+{
+    // Negative window bits, raw stream without zlib header and checksum,
+    // WebSocket already guarantees integrity.
+    mIsInitialized = deflateInit2(&mStream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+FrameCompressor::~FrameCompressor()
+{
+    if (mIsInitialized)
+    {
+        deflateEnd(&mStream);
+    }
+}
+
+auto FrameCompressor::GetDictionary(CompressionDictionary dictionary) -> std::string_view
+{
+    switch (dictionary)
+    {
+    case CompressionDictionary::Song:
+        return std::string_view(SONG_DICTIONARY, sizeof(SONG_DICTIONARY) - 1);
+
+    default:
+        return std::string_view();
+    }
+}
+
+auto FrameCompressor::Compress(std::string_view frame, CompressionDictionary dictionary) -> const std::string*
+{
+    static constexpr auto headerSize = std::size_t(4);
+
+    if (!mIsInitialized || deflateReset(&mStream) != Z_OK)
+    {
+        return nullptr;
+    }
+
+    auto dictionaryData = GetDictionary(dictionary);
+    if (!dictionaryData.empty())
+    {
+        auto data = reinterpret_cast<const Bytef*>(dictionaryData.data());
+        if (deflateSetDictionary(&mStream, data, static_cast<uInt>(dictionaryData.size())) != Z_OK)
+        {
+            return nullptr;
+        }
+    }
+
+    mBuffer.resize(headerSize + deflateBound(&mStream, static_cast<uLong>(frame.size())));
+    mBuffer[0] = 'S';
+    mBuffer[1] = 'P';
+    mBuffer[2] = 'Z';
+    mBuffer[3] = static_cast<char>(dictionary);
+
+    mStream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(frame.data()));
+    mStream.avail_in  = static_cast<uInt>(frame.size());
+    mStream.next_out  = reinterpret_cast<Bytef*>(mBuffer.data() + headerSize);
+    mStream.avail_out = static_cast<uInt>(mBuffer.size() - headerSize);
+
+    if (deflate(&mStream, Z_FINISH) != Z_STREAM_END)
+    {
+        return nullptr;
+    }
+
+    mBuffer.resize(headerSize + mStream.total_out);
+    if (mBuffer.size() >= frame.size())
+    {
+        return nullptr;
+    }
+
+    return &mBuffer;
+}
+
+} // namespace foo_showplay
@@ -0,0 +1,57 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <zlib.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace foo_showplay {
+
+// Preset dictionaries known to both sides, id is sent in message header.
+enum class CompressionDictionary : std::uint8_t
+{
+    None = 0,
+    Song = 1, // Keys and values typical for frames with SongInfo.
+};
+
+// Compresses frame into binary message: "SPZ", dictionary id, raw deflate
+// stream. Not thread safe, every connection has its own.
+class FrameCompressor
+{
+    z_stream    mStream;
+    bool        mIsInitialized;
+    std::string mBuffer; // Reused for every message.
+
+public:
+    FrameCompressor(int level);
+    ~FrameCompressor();
+
+    FrameCompressor(const FrameCompressor&)            = delete;
+    FrameCompressor& operator=(const FrameCompressor&) = delete;
+
+    // Returns nullptr if compression failed or didn't make frame smaller.
+    auto Compress (std::string_view frame, CompressionDictionary dictionary) -> const std::string*;
+
+    static auto GetDictionary (CompressionDictionary dictionary) -> std::string_view;
+};
+
+} // namespace foo_showplay
@@ -0,0 +1,162 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "Hash.hpp"
+
+#include <charconv>
+#include <cstring>
+
+namespace foo_showplay {
+
+static constexpr auto PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static constexpr auto PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr auto PRIME64_3 = 0x165667B19E3779F9ULL;
+static constexpr auto PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr auto PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline auto RotateLeft(std::uint64_t value, int bits) -> std::uint64_t
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline auto Read64(const std::uint8_t* ptr) -> std::uint64_t
+{
+    auto value = std::uint64_t(0);
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline auto Read32(const std::uint8_t* ptr) -> std::uint32_t
+{
+    auto value = std::uint32_t(0);
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline auto Round(std::uint64_t acc, std::uint64_t input) -> std::uint64_t
+{
+    acc += input * PRIME64_2;
+    acc  = RotateLeft(acc, 31);
+    acc *= PRIME64_1;
+    return acc;
+}
+
+static inline auto MergeRound(std::uint64_t acc, std::uint64_t value) -> std::uint64_t
+{
+    acc ^= Round(0, value);
+    acc  = acc * PRIME64_1 + PRIME64_4;
+    return acc;
+}
+
+auto Hash64(const void* data, std::size_t size, std::uint64_t seed) -> std::uint64_t
+{
+    // Reference: https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+    // Reads are little endian, same as every platform foobar2000 runs on.
+    auto ptr = static_cast<const std::uint8_t*>(data);
+    auto end = ptr + size;
+    auto hash = std::uint64_t(0);
+
+    if (size >= 32)
+    {
+        auto limit = end - 32;
+        auto v1 = seed + PRIME64_1 + PRIME64_2;
+        auto v2 = seed + PRIME64_2;
+        auto v3 = seed;
+        auto v4 = seed - PRIME64_1;
+
+        do
+        {
+            v1 = Round(v1, Read64(ptr));      ptr += 8;
+            v2 = Round(v2, Read64(ptr));      ptr += 8;
+            v3 = Round(v3, Read64(ptr));      ptr += 8;
+            v4 = Round(v4, Read64(ptr));      ptr += 8;
+        }
+        while (ptr <= limit);
+
+        hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+        hash = MergeRound(hash, v1);
+        hash = MergeRound(hash, v2);
+        hash = MergeRound(hash, v3);
+        hash = MergeRound(hash, v4);
+    }
+    else
+    {
+        hash = seed + PRIME64_5;
+    }
+
+    hash += static_cast<std::uint64_t>(size);
+
+    while (ptr + 8 <= end)
+    {
+        hash ^= Round(0, Read64(ptr));
+        hash  = RotateLeft(hash, 27) * PRIME64_1 + PRIME64_4;
+        ptr  += 8;
+    }
+
+    if (ptr + 4 <= end)
+    {
+        hash ^= static_cast<std::uint64_t>(Read32(ptr)) * PRIME64_1;
+        hash  = RotateLeft(hash, 23) * PRIME64_2 + PRIME64_3;
+        ptr  += 4;
+    }
+
+    while (ptr < end)
+    {
+        hash ^= static_cast<std::uint64_t>(*ptr) * PRIME64_5;
+        hash  = RotateLeft(hash, 11) * PRIME64_1;
+        ptr  += 1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+auto HashToString(std::uint64_t hash) -> std::string
+{
+    static constexpr char hex[] = "0123456789abcdef";
+
+    auto str = std::string(16, '0');
+    for (auto i = 15; i >= 0; --i)
+    {
+        str[i] = hex[hash & 0xF];
+        hash >>= 4;
+    }
+
+    return str;
+}
+
+auto HashFromString(const std::string& str) -> std::optional<std::uint64_t>
+{
+    auto hash = std::uint64_t(0);
+    auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), hash, 16);
+    if (str.size() != 16 || error != std::errc() || end != str.data() + str.size())
+    {
+        return std::nullopt;
+    }
+
+    return hash;
+}
+
+} // namespace foo_showplay
@@ -0,0 +1,36 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace foo_showplay {
+
+// XXH64, fast non-cryptographic hash used to identify album art.
+auto Hash64 (const void* data, std::size_t size, std::uint64_t seed = 0) -> std::uint64_t;
+
+// Formats hash as 16 lowercase hex digits.
+auto HashToString   (std::uint64_t hash)      -> std::string;
+auto HashFromString (const std::string& str)  -> std::optional<std::uint64_t>;
+
+} // namespace foo_showplay
@@ -0,0 +1,65 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace foo_showplay {
+
+// Decoded image, 24 bits per pixel BGR, rows padded to 4 bytes.
+struct DecodedImage
+{
+    std::uint32_t             Width;
+    std::uint32_t             Height;
+    std::uint32_t             Stride;
+    std::vector<std::uint8_t> Pixels;
+
+    DecodedImage()
+        : Width  (0)
+        , Height (0)
+        , Stride (0)
+    {
+    }
+
+    DecodedImage(std::uint32_t width, std::uint32_t height)
+        : Width  (width)
+        , Height (height)
+        , Stride ((width * 3 + 3) & ~std::uint32_t(3))
+        , Pixels (static_cast<std::size_t>(Stride) * height)
+    {
+    }
+};
+
+// Image decoding and encoding backend used by cover transcoder. Instance is
+// created and used only on transcoder thread.
+class ImageCodec
+{
+public:
+    virtual ~ImageCodec() = default;
+
+    virtual auto Decode     (const std::uint8_t* data, std::size_t size) -> std::optional<DecodedImage> = 0;
+    virtual auto Resize     (const DecodedImage& image, std::uint32_t width, std::uint32_t height) -> std::optional<DecodedImage> = 0;
+    virtual auto EncodeJpeg (const DecodedImage& image, int quality) -> std::optional<std::vector<std::uint8_t>> = 0;
+};
+
+} // namespace foo_showplay
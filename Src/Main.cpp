@@ -122,6 +122,48 @@ public:
 
 static auto gShowPlayPreferencesImplFactory = preferences_page_factory_t<ShowPlayPreferencesImpl>();
 
+// Queued tracks play next, prefetched track may no longer be.
+class ShowPlayQueueCallback : public playback_queue_callback
+{
+public:
+    auto on_changed(t_change_origin p_origin) -> void
+    {
+        auto client = GetShowPlayClient();
+        if (client)
+        {
+            client->PrefetchNextTrack();
+        }
+    }
+};
+
+static auto gShowPlayQueueCallbackFactory = service_factory_single_t<ShowPlayQueueCallback>();
+
+// Nothing plays after current track with stop after current set.
+class ShowPlayStopAfterCurrentNotify : public config_object_notify
+{
+public:
+    auto get_watched_object_count() -> t_size
+    {
+        return 1;
+    }
+
+    auto get_watched_object(t_size p_index) -> GUID
+    {
+        return standard_config_objects::bool_playlist_stop_after_current;
+    }
+
+    auto on_watched_object_changed(const service_ptr_t<config_object>& p_object) -> void
+    {
+        auto client = GetShowPlayClient();
+        if (client)
+        {
+            client->PrefetchNextTrack();
+        }
+    }
+};
+
+static auto gShowPlayStopAfterCurrentNotifyFactory = service_factory_single_t<ShowPlayStopAfterCurrentNotify>();
+
 // Get client.
 auto GetShowPlayClient()->foo_showplay::ShowPlayClient*
 {
@@ -0,0 +1,213 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace foo_showplay {
+
+// Number of significant bits, 0 for 0.
+static auto BucketIndex(std::uint64_t value) -> std::size_t
+{
+    auto index = std::size_t(0);
+    while (value != 0)
+    {
+        value >>= 1;
+        index  += 1;
+    }
+
+    return std::min(index, Histogram::BucketCount - 1);
+}
+
+Histogram::Histogram()
+    : mCount (0)
+    , mSum   (0)
+    , mMax   (0)
+{
+    for (auto& bucket : mBuckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+auto Histogram::Record(std::chrono::nanoseconds duration) -> void
+{
+    auto value = static_cast<std::uint64_t>(std::max<std::int64_t>(0, duration.count() / 1000));
+
+    mBuckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mSum.fetch_add(value, std::memory_order_relaxed);
+
+    auto max = mMax.load(std::memory_order_relaxed);
+    while (value > max && !mMax.compare_exchange_weak(max, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+auto Histogram::GetMax() const -> std::chrono::microseconds
+{
+    return std::chrono::microseconds(mMax.load(std::memory_order_relaxed));
+}
+
+auto Histogram::GetMean() const -> std::chrono::microseconds
+{
+    auto count = GetCount();
+    if (count == 0)
+    {
+        return std::chrono::microseconds(0);
+    }
+
+    return std::chrono::microseconds(mSum.load(std::memory_order_relaxed) / count);
+}
+
+auto Histogram::GetPercentile(double fraction) const -> std::chrono::microseconds
+{
+    auto count = GetCount();
+    if (count == 0)
+    {
+        return std::chrono::microseconds(0);
+    }
+
+    // Upper bound of bucket the percentile falls into, never above max.
+    auto rank  = static_cast<std::uint64_t>(fraction * count);
+    auto total = std::uint64_t(0);
+    for (auto i = std::size_t(0); i < BucketCount; ++i)
+    {
+        total += mBuckets[i].load(std::memory_order_relaxed);
+        if (total > rank)
+        {
+            auto bound = i == 0 ? std::uint64_t(0) : (std::uint64_t(1) << i) - 1;
+            return std::min(std::chrono::microseconds(bound), GetMax());
+        }
+    }
+
+    return GetMax();
+}
+
+auto Histogram::GetStats() const -> LatencyStats
+{
+    auto stats  = LatencyStats();
+    stats.Count = GetCount();
+    stats.Max   = GetMax().count();
+    stats.Mean  = GetMean().count();
+    stats.P50   = GetPercentile(0.50).count();
+    stats.P99   = GetPercentile(0.99).count();
+
+    return stats;
+}
+
+auto Metrics::CountFrame(const FieldMasks<Payload>& masks, bool isSent) -> void
+{
+    // By FrameChannel.
+    static constexpr std::size_t sections[FRAME_CHANNEL_COUNT] = {
+        FieldIndex(Payload::FieldNames, "Playback"),
+        FieldIndex(Payload::FieldNames, "Song"),
+        FieldIndex(Payload::FieldNames, "Cover"),
+    };
+
+    (isSent ? FramesSent : FramesDropped).Add();
+    for (auto i = std::size_t(0); i < FRAME_CHANNEL_COUNT; ++i)
+    {
+        if (masks.Fields[sections[i]] != 0)
+        {
+            (isSent ? ChannelSent[i] : ChannelDropped[i]).Add();
+        }
+    }
+}
+
+auto Metrics::GetStats() const -> StatsInfo
+{
+    auto getChannel = [this](FrameChannel channel)
+    {
+        auto index    = static_cast<std::size_t>(channel);
+        auto stats    = ChannelStats();
+        stats.Dropped = ChannelDropped[index].Get();
+        stats.Sent    = ChannelSent[index].Get();
+        return stats;
+    };
+
+    auto frames    = ChannelStats();
+    frames.Dropped = FramesDropped.Get();
+    frames.Sent    = FramesSent.Get();
+
+    auto stats           = StatsInfo();
+    stats.Activation     = ActivationTime.GetStats();
+    stats.Base64         = Base64Time.GetStats();
+    stats.Bytes          = BytesSent.Get();
+    stats.Cover          = getChannel(FrameChannel::Cover);
+    stats.Frames         = frames;
+    stats.Lost           = FramesLost.Get();
+    stats.Playback       = getChannel(FrameChannel::Playback);
+    stats.Reconnects     = Reconnects.Get();
+    stats.RoundTrip      = RoundTripTime.GetStats();
+    stats.Send           = SendTime.GetStats();
+    stats.Serialize      = SerializeTime.GetStats();
+    stats.Song           = getChannel(FrameChannel::Song);
+    stats.Stuck          = FramesStuck.Get();
+    stats.Uplink         = UplinkDelay.GetStats();
+    stats.UplinkNegative = UplinkNegative.Get();
+
+    return stats;
+}
+
+auto Metrics::Format() const -> std::string
+{
+    char buffer[160];
+    std::snprintf(buffer, sizeof(buffer),
+        "%llu sent, %llu dropped, %llu KiB, send p99 %lld us, %llu reconnects",
+        static_cast<unsigned long long>(FramesSent.Get()),
+        static_cast<unsigned long long>(FramesDropped.Get()),
+        static_cast<unsigned long long>(BytesSent.Get() / 1024),
+        static_cast<long long>(SendTime.GetPercentile(0.99).count()),
+        static_cast<unsigned long long>(Reconnects.Get())
+    );
+
+    auto summary = std::string(buffer);
+
+    std::snprintf(buffer, sizeof(buffer),
+        ", playback %llu/%llu, song %llu/%llu, cover %llu/%llu sent/dropped",
+        static_cast<unsigned long long>(ChannelSent[static_cast<std::size_t>(FrameChannel::Playback)].Get()),
+        static_cast<unsigned long long>(ChannelDropped[static_cast<std::size_t>(FrameChannel::Playback)].Get()),
+        static_cast<unsigned long long>(ChannelSent[static_cast<std::size_t>(FrameChannel::Song)].Get()),
+        static_cast<unsigned long long>(ChannelDropped[static_cast<std::size_t>(FrameChannel::Song)].Get()),
+        static_cast<unsigned long long>(ChannelSent[static_cast<std::size_t>(FrameChannel::Cover)].Get()),
+        static_cast<unsigned long long>(ChannelDropped[static_cast<std::size_t>(FrameChannel::Cover)].Get())
+    );
+    summary += buffer;
+
+    // Only servers with Ack feature acknowledge frames.
+    if (RoundTripTime.GetCount() > 0)
+    {
+        std::snprintf(buffer, sizeof(buffer),
+            ", rtt p50 %lld us, uplink p50 %lld us, %llu lost, %llu stuck",
+            static_cast<long long>(RoundTripTime.GetPercentile(0.50).count()),
+            static_cast<long long>(UplinkDelay.GetPercentile(0.50).count()),
+            static_cast<unsigned long long>(FramesLost.Get()),
+            static_cast<unsigned long long>(FramesStuck.Get())
+        );
+        summary += buffer;
+    }
+
+    return summary;
+}
+
+} // namespace foo_showplay
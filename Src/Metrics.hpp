@@ -0,0 +1,115 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Payload.hpp"
+
+namespace foo_showplay {
+
+// Monotonic counter, bumped from any thread without locking.
+class Counter
+{
+    std::atomic<std::uint64_t> mValue;
+
+public:
+    Counter()
+        : mValue (0)
+    {
+    }
+
+    auto Add (std::uint64_t value = 1) -> void { mValue.fetch_add(value, std::memory_order_relaxed); }
+    auto Get () const -> std::uint64_t         { return mValue.load(std::memory_order_relaxed); }
+};
+
+// Durations counted in power of two buckets of microseconds, bucket i holds
+// durations in [2^(i-1), 2^i). Recording is a few relaxed atomic adds,
+// percentiles are bucket bounds, accurate within factor of two.
+class Histogram
+{
+public:
+    static constexpr auto BucketCount = std::size_t(32);
+
+private:
+    std::atomic<std::uint64_t> mBuckets[BucketCount];
+    std::atomic<std::uint64_t> mCount;
+    std::atomic<std::uint64_t> mSum; // In microseconds.
+    std::atomic<std::uint64_t> mMax; // In microseconds.
+
+public:
+    Histogram();
+
+    Histogram(const Histogram&)            = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    auto Record (std::chrono::nanoseconds duration) -> void;
+
+    auto GetCount      () const -> std::uint64_t { return mCount.load(std::memory_order_relaxed); }
+    auto GetMax        () const -> std::chrono::microseconds;
+    auto GetMean       () const -> std::chrono::microseconds;
+    auto GetPercentile (double fraction) const -> std::chrono::microseconds;
+    auto GetStats      () const -> LatencyStats;
+};
+
+// Channels of PayloadScheduler, by payload section. Frame is counted in
+// every channel whose section it carries.
+enum class FrameChannel
+{
+    Playback = 0,
+    Song     = 1,
+    Cover    = 2,
+};
+
+inline constexpr auto FRAME_CHANNEL_COUNT = std::size_t(3);
+
+// Metrics of one session, shared by its endpoints and written from sender,
+// socket and main threads. Readers may see sample that is being recorded
+// counted in one value but not yet in another.
+struct Metrics
+{
+    Counter   FramesSent;     // Every frame, whatever it carries.
+    Counter   FramesDropped;  // Queue overflow, closed socket or failed send.
+    Counter   ChannelSent    [FRAME_CHANNEL_COUNT];
+    Counter   ChannelDropped [FRAME_CHANNEL_COUNT];
+    Counter   BytesSent;      // On the wire, after compression and framing.
+    Counter   Reconnects;     // Attempts scheduled after failure or lost connection.
+    Counter   FramesLost;     // Never acknowledged by server, see AckTracker.
+    Counter   FramesStuck;    // Not acknowledged within ACK_STUCK_TIMEOUT.
+    Histogram SerializeTime;  // Writing frame into buffer.
+    Histogram Base64Time;     // Encoding cover for JSON frames, once per cover.
+    Histogram SendTime;       // IXWebSocket send call, blocks while socket buffer is full.
+    Histogram ActivationTime; // From open until server sent token.
+    Histogram RoundTripTime;  // From send call until server ack.
+    Histogram UplinkDelay;    // From send call until server received frame, by server clock.
+    Counter   UplinkNegative; // Uplink samples below zero, clock offset was off. Not in UplinkDelay.
+
+    // Sections with non-empty mask are the ones frame carries.
+    auto CountFrame (const FieldMasks<Payload>& masks, bool isSent) -> void;
+
+    auto GetStats () const -> StatsInfo;
+    auto Format   () const -> std::string; // One line summary.
+};
+
+} // namespace foo_showplay
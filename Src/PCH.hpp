@@ -19,10 +19,12 @@
 
 #pragma once
 
-// foobar2000 SDK
+// foobar2000 SDK, not used by headless build of session core
+#ifndef SHOWPLAY_HEADLESS
 #include <foobar2000.h>
 #include <helpers/foobar2000+atl.h>
 #include <helpers/atl-misc.h>
+#endif
 
 // IXWebSocket
 #include <ixwebsocket/IXWebSocket.h>
@@ -19,10 +19,14 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <optional>
+#include <variant>
+#include <vector>
 
 #include "OptionalSerializer.hpp"
+#include "Serializer.hpp"
 
 namespace foo_showplay {
 
@@ -37,7 +41,7 @@ struct PlayerInfo
     {
     }
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(PlayerInfo, Name)
+    SHOWPLAY_DEFINE_TYPE(PlayerInfo, Name)
 };
 
 // -------------------------------------------------------------------------- //
@@ -53,14 +57,18 @@ struct PlaybackInfo
 {
     std::optional<PlaybackState> State;
     std::optional<double>        Elapsed;
+    std::optional<double>        Rate;      // Anchor mode, seconds of song per second.
+    std::optional<std::int64_t>  Timestamp; // Anchor mode, monotonic milliseconds when Elapsed was read.
 
     PlaybackInfo()
-        : State   (std::nullopt)
-        , Elapsed (std::nullopt)
+        : State     (std::nullopt)
+        , Elapsed   (std::nullopt)
+        , Rate      (std::nullopt)
+        , Timestamp (std::nullopt)
     {
     }
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(PlaybackInfo, State, Elapsed)
+    SHOWPLAY_DEFINE_TYPE(PlaybackInfo, Elapsed, Rate, State, Timestamp)
 };
 
 // -------------------------------------------------------------------------- //
@@ -88,8 +96,8 @@ struct SongInfo
     {
     }
 
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(
-        SongInfo, Title, Artist, Album, Date, Year, TrackNumber, Length, Path
+    SHOWPLAY_DEFINE_TYPE(
+        SongInfo, Album, Artist, Date, Length, Path, Title, TrackNumber, Year
     )
 };
 
@@ -97,30 +105,344 @@ struct SongInfo
 
 struct CoverInfo
 {
-    std::optional<std::string> Image; // in base64
+    std::optional<int>         Attachment; // Frame carrying Image as binary message.
+    std::optional<std::string> Hash;       // Content hash, see Hash64.
+    std::optional<BinaryData>  Image;      // Null if server already has Hash.
 
     CoverInfo()
-        : Image(std::nullopt)
+        : Attachment (std::nullopt)
+        , Hash       (std::nullopt)
+        , Image      (std::nullopt)
     {
     }
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(CoverInfo, Image)
+    SHOWPLAY_DEFINE_TYPE(CoverInfo, Attachment, Hash, Image)
 };
 
 // -------------------------------------------------------------------------- //
 
+// Track played while server was not connected.
+struct TrackRecord
+{
+    std::optional<std::string>  Title;
+    std::optional<std::string>  Artist;
+    std::optional<std::string>  Album;
+    std::optional<std::string>  Path;
+    std::optional<std::int64_t> PlayedAt; // Unix time in milliseconds.
+
+    TrackRecord()
+        : Title    (std::nullopt)
+        , Artist   (std::nullopt)
+        , Album    (std::nullopt)
+        , Path     (std::nullopt)
+        , PlayedAt (std::nullopt)
+    {
+    }
+
+    auto operator== (const TrackRecord& other) const -> bool
+    {
+        return Title == other.Title && Artist == other.Artist && Album == other.Album &&
+               Path == other.Path && PlayedAt == other.PlayedAt;
+    }
+
+    SHOWPLAY_DEFINE_TYPE(TrackRecord, Album, Artist, Path, PlayedAt, Title)
+};
+
+// Sent with snapshot after reconnect, tells server what it missed since
+// last state it got from us.
+struct SyncInfo
+{
+    std::optional<std::vector<std::string>> Changed; // Names of sections changed since.
+    std::optional<std::vector<TrackRecord>> History; // Oldest first, bounded.
+    std::optional<std::uint64_t>            Since;   // Version server had, 0 if none.
+    std::optional<std::uint64_t>            Version; // Version of this snapshot.
+
+    SyncInfo()
+        : Changed (std::nullopt)
+        , History (std::nullopt)
+        , Since   (std::nullopt)
+        , Version (std::nullopt)
+    {
+    }
+
+    SHOWPLAY_DEFINE_TYPE(SyncInfo, Changed, History, Since, Version)
+};
+
+// -------------------------------------------------------------------------- //
+
+// Frames of one channel or all of them, see Metrics.
+struct ChannelStats
+{
+    std::uint64_t Dropped;
+    std::uint64_t Sent;
+
+    ChannelStats()
+        : Dropped (0)
+        , Sent    (0)
+    {
+    }
+
+    auto operator== (const ChannelStats& other) const -> bool
+    {
+        return Dropped == other.Dropped && Sent == other.Sent;
+    }
+
+    SHOWPLAY_DEFINE_TYPE(ChannelStats, Dropped, Sent)
+};
+
+// Durations in microseconds. Percentiles are upper bounds of histogram
+// buckets, within factor of two.
+struct LatencyStats
+{
+    std::uint64_t Count;
+    std::int64_t  Max;
+    std::int64_t  Mean;
+    std::int64_t  P50;
+    std::int64_t  P99;
+
+    LatencyStats()
+        : Count (0)
+        , Max   (0)
+        , Mean  (0)
+        , P50   (0)
+        , P99   (0)
+    {
+    }
+
+    auto operator== (const LatencyStats& other) const -> bool
+    {
+        return Count == other.Count && Max == other.Max && Mean == other.Mean &&
+               P50 == other.P50 && P99 == other.P99;
+    }
+
+    SHOWPLAY_DEFINE_TYPE(LatencyStats, Count, Max, Mean, P50, P99)
+};
+
+// Client metrics since start, sent periodically to servers with Stats
+// feature. Not part of player state, never in snapshot.
+struct StatsInfo
+{
+    LatencyStats  Activation; // From open until token.
+    LatencyStats  Base64;     // Cover encoding.
+    std::uint64_t Bytes;      // On the wire.
+    ChannelStats  Cover;      // Frames carrying Cover section.
+    ChannelStats  Frames;     // All frames.
+    std::uint64_t Lost;       // Frames never acknowledged, Ack feature only.
+    ChannelStats  Playback;   // Frames carrying Playback section.
+    std::uint64_t Reconnects;
+    LatencyStats  RoundTrip;  // Until ack, Ack feature only.
+    LatencyStats  Send;       // Socket send call.
+    LatencyStats  Serialize;  // Frame writing.
+    ChannelStats  Song;       // Frames carrying Song section.
+    std::uint64_t Stuck;      // Frames acknowledged late or never.
+    LatencyStats  Uplink;     // Until server received frame, Ack feature only.
+    std::uint64_t UplinkNegative; // Uplink samples below zero, not in Uplink.
+
+    StatsInfo()
+        : Bytes          (0)
+        , Lost           (0)
+        , Reconnects     (0)
+        , Stuck          (0)
+        , UplinkNegative (0)
+    {
+    }
+
+    SHOWPLAY_DEFINE_TYPE(
+        StatsInfo, Activation, Base64, Bytes, Cover, Frames, Lost, Playback, Reconnects,
+        RoundTrip, Send, Serialize, Song, Stuck, Uplink, UplinkNegative
+    )
+};
+
+// -------------------------------------------------------------------------- //
+
+// Value of field defined by server schema, monostate is null.
+using FieldValue = std::variant<std::monostate, std::string, std::int64_t, double>;
+
+enum class FieldType
+{
+    String,
+    Integer,
+    Number,
+};
+
+// Servers may define fields of the same name differently, field is told
+// apart by whole definition it was evaluated from. Only Name and Value are
+// sent.
+struct CustomField
+{
+    std::string Name;
+    FieldValue  Value;
+    std::string Expression;
+    FieldType   Type;
+
+    auto operator== (const CustomField& other) const -> bool
+    {
+        return Name == other.Name && Value == other.Value && Expression == other.Expression && Type == other.Type;
+    }
+};
+
+// Fields requested by server schema, see FieldSchema. Written as object
+// keyed by field name, sorted by name. Has no field table, each entry has
+// its own FieldMask bit instead.
+struct CustomFields
+{
+    std::vector<CustomField> Values;
+
+    auto operator== (const CustomFields& other) const -> bool
+    {
+        return Values == other.Values;
+    }
+};
+
+inline auto ToJson(const FieldValue& value) -> nlohmann::json
+{
+    return std::visit([](const auto& alternative) -> nlohmann::json
+    {
+        if constexpr (std::is_same_v<std::decay_t<decltype(alternative)>, std::monostate>)
+        {
+            return nullptr;
+        }
+        else
+        {
+            return alternative;
+        }
+    }, value);
+}
+
+inline auto to_json(nlohmann::json& json, const CustomFields& fields) -> void
+{
+    json = nlohmann::json::object();
+    for (const auto& field : fields.Values)
+    {
+        json[field.Name] = ToJson(field.Value);
+    }
+}
+
+inline auto from_json(const nlohmann::json& json, CustomFields& fields) -> void
+{
+    fields.Values.clear();
+    for (const auto& [name, value] : json.items())
+    {
+        // Expression isn't sent, type is guessed from value.
+        auto field = CustomField{ name, std::monostate(), std::string(), FieldType::String };
+        if (value.is_string())
+        {
+            field.Value = value.get<std::string>();
+        }
+        else if (value.is_number_integer())
+        {
+            field.Value = value.get<std::int64_t>();
+            field.Type  = FieldType::Integer;
+        }
+        else if (value.is_number_float())
+        {
+            field.Value = value.get<double>();
+            field.Type  = FieldType::Number;
+        }
+
+        fields.Values.push_back(std::move(field));
+    }
+}
+
+// Entries past FieldMask width have no bit of their own, any change in them
+// marks all fields.
+inline auto DiffFields(const std::optional<CustomFields>& before, const std::optional<CustomFields>& after) -> FieldMask
+{
+    if (!before.has_value() && !after.has_value())
+    {
+        return 0;
+    }
+
+    if (!before.has_value() || !after.has_value())
+    {
+        return ALL_FIELDS;
+    }
+
+    const auto& beforeValues = before.value().Values;
+    const auto& afterValues  = after.value().Values;
+    if (beforeValues.size() != afterValues.size())
+    {
+        return ALL_FIELDS;
+    }
+
+    auto mask = FieldMask(0);
+    for (auto i = std::size_t(0); i < afterValues.size(); ++i)
+    {
+        // Other field at this position, masks of following ones are off.
+        if (beforeValues[i].Name != afterValues[i].Name || beforeValues[i].Expression != afterValues[i].Expression ||
+            beforeValues[i].Type != afterValues[i].Type)
+        {
+            return ALL_FIELDS;
+        }
+
+        if (!(beforeValues[i].Value == afterValues[i].Value))
+        {
+            if (i >= sizeof(FieldMask) * 8)
+            {
+                return ALL_FIELDS;
+            }
+
+            mask |= FieldMask(1) << i;
+        }
+    }
+
+    return mask;
+}
+
+template <typename Writer>
+auto WriteObject(Writer& writer, const CustomFields& fields, FieldMask mask = ALL_FIELDS) -> void
+{
+    writer.BeginObject();
+    for (auto i = std::size_t(0); i < fields.Values.size(); ++i)
+    {
+        const auto& field = fields.Values[i];
+        if (i < sizeof(FieldMask) * 8 && (mask & (FieldMask(1) << i)) == 0)
+        {
+            continue;
+        }
+
+        writer.Key(field.Name);
+        std::visit([&writer](const auto& value)
+        {
+            if constexpr (std::is_same_v<std::decay_t<decltype(value)>, std::monostate>)
+            {
+                writer.Null();
+            }
+            else
+            {
+                WriteValue(writer, value);
+            }
+        }, field.Value);
+    }
+    writer.EndObject();
+}
+
+template <typename Writer>
+auto WriteValue(Writer& writer, const CustomFields& fields) -> void
+{
+    WriteObject(writer, fields);
+}
+
+// -------------------------------------------------------------------------- //
+
 struct Payload
 {
     std::optional<PlayerInfo>   Player;
     std::optional<PlaybackInfo> Playback;
     std::optional<SongInfo>     Song;
     std::optional<CoverInfo>    Cover;
+    std::optional<SyncInfo>     Sync;   // Snapshot only.
+    std::optional<CustomFields> Fields; // Only if server sent schema.
+    std::optional<StatsInfo>    Stats;  // Only to servers with Stats feature.
 
     Payload()
         : Player   (std::nullopt)
         , Playback (std::nullopt)
         , Song     (std::nullopt)
         , Cover    (std::nullopt)
+        , Sync     (std::nullopt)
+        , Fields   (std::nullopt)
+        , Stats    (std::nullopt)
     {
     }
 
@@ -128,16 +450,20 @@ struct Payload
         std::optional<PlayerInfo>   player,
         std::optional<PlaybackInfo> playback,
         std::optional<SongInfo>     song,
-        std::optional<CoverInfo>    cover
+        std::optional<CoverInfo>    cover,
+        std::optional<SyncInfo>     sync = std::nullopt
     )
         : Player   (player)
         , Playback (playback)
         , Song     (song)
         , Cover    (cover)
+        , Sync     (sync)
+        , Fields   (std::nullopt)
+        , Stats    (std::nullopt)
     {
     }
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(Payload, Player, Playback, Song, Cover)
+    SHOWPLAY_DEFINE_TYPE(Payload, Cover, Fields, Playback, Player, Song, Stats, Sync)
 };
 
 // -------------------------------------------------------------------------- //
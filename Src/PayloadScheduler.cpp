@@ -0,0 +1,107 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "PayloadScheduler.hpp"
+
+namespace foo_showplay {
+
+auto PayloadScheduler::SetMaxRate(int framesPerSecond) -> void
+{
+    if (framesPerSecond <= 0)
+    {
+        mInterval = Clock::duration::zero();
+        return;
+    }
+
+    mInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / framesPerSecond;
+}
+
+auto PayloadScheduler::Schedule(Payload payload, Clock::time_point now) -> bool
+{
+    // Playback without State carries only Elapsed, it's merged into pending
+    // state change instead of replacing it.
+    if (payload.Playback.has_value() && mPending.Playback.has_value())
+    {
+        auto& pending  = mPending.Playback.value();
+        auto& playback = payload.Playback.value();
+        if (!playback.State.has_value() && pending.State.has_value())
+        {
+            pending.Elapsed = playback.Elapsed;
+            mMergedCount   += 1;
+            payload.Playback.reset();
+        }
+    }
+
+    // Newer section overwrites pending one.
+    Payload::VisitFields([&](const char*, auto member)
+    {
+        auto& pending = mPending.*member;
+        auto& section = payload.*member;
+        if (section.has_value())
+        {
+            if (pending.has_value())
+            {
+                mDroppedCount += 1;
+            }
+
+            pending     = std::move(section);
+            mHasPending = true;
+        }
+    });
+
+    // Play, pause and stop are sent without delay.
+    auto isTransition = mPending.Playback.has_value() &&
+                        mPending.Playback.value().State.has_value() &&
+                        mPending.Playback.value().State != mLastState;
+
+    return isTransition || now >= GetFlushTime();
+}
+
+auto PayloadScheduler::Take(Clock::time_point now) -> Payload
+{
+    if (mPending.Playback.has_value() && mPending.Playback.value().State.has_value())
+    {
+        mLastState = mPending.Playback.value().State;
+    }
+
+    auto payload = std::move(mPending);
+    mPending    = Payload();
+    mHasPending = false;
+    mLastFlush  = now;
+
+    return payload;
+}
+
+auto PayloadScheduler::Discard() -> void
+{
+    Payload::VisitFields([&](const char*, auto member)
+    {
+        auto& pending = mPending.*member;
+        if (pending.has_value())
+        {
+            mDroppedCount += 1;
+            pending.reset();
+        }
+    });
+
+    mHasPending = false;
+}
+
+} // namespace foo_showplay
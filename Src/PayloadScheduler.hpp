@@ -0,0 +1,72 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "Payload.hpp"
+
+namespace foo_showplay {
+
+// Coalesces payloads so bursts of events (seeking, skipping tracks) are sent
+// at bounded rate. Every section has pending slot overwritten by newer
+// events. Playback state change is flushed immediately.
+class PayloadScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    Payload                      mPending;
+    bool                         mHasPending;
+    Clock::duration              mInterval;  // Minimum time between flushes.
+    Clock::time_point            mLastFlush;
+    std::optional<PlaybackState> mLastState; // Last flushed playback state.
+    std::uint64_t                mMergedCount;
+    std::uint64_t                mDroppedCount;
+
+public:
+    PayloadScheduler()
+        : mHasPending   (false)
+        , mInterval     (Clock::duration::zero())
+        , mLastFlush    ()
+        , mLastState    (std::nullopt)
+        , mMergedCount  (0)
+        , mDroppedCount (0)
+    {
+    }
+
+    // 0 means unlimited.
+    auto SetMaxRate (int framesPerSecond) -> void;
+
+    // Returns true if pending payload should be flushed right away.
+    auto Schedule (Payload payload, Clock::time_point now) -> bool;
+    auto Take     (Clock::time_point now) -> Payload;
+    auto Discard  () -> void;
+
+    auto HasPending   () const -> bool              { return mHasPending; }
+    auto GetFlushTime () const -> Clock::time_point { return mLastFlush + mInterval; }
+
+    auto GetMergedCount  () const -> std::uint64_t { return mMergedCount;  }
+    auto GetDroppedCount () const -> std::uint64_t { return mDroppedCount; }
+};
+
+} // namespace foo_showplay
@@ -0,0 +1,386 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "PayloadSender.hpp"
+
+#include <algorithm>
+
+namespace foo_showplay {
+
+PayloadSender::PayloadSender(WebSocketClient& webSocket, Metrics& metrics)
+    : mWebSocket          (webSocket)
+    , mMetrics            (metrics)
+    , mCoverEpoch         (0)
+    , mIsSignaled         (false)
+    , mIsStopping         (false)
+    , mIsOverflowed       (false)
+    , mLastLatency        (0)
+    , mMaxLatency         (0)
+    , mSyncedVersion      (0)
+    , mIsGap              (false)
+    , mOnOverflowCallback ([]{})
+{
+    mThread = std::thread([this]() { Run(); });
+}
+
+PayloadSender::~PayloadSender()
+{
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        mIsStopping = true;
+    }
+
+    mCondition.notify_one();
+    mThread.join();
+}
+
+auto PayloadSender::SetOnOverflowCallback(std::function<void()> callback) -> void
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    mOnOverflowCallback = std::move(callback);
+}
+
+auto PayloadSender::Push(std::shared_ptr<const SharedPayload> payload, JobKind kind, std::uint64_t version) -> void
+{
+    auto job = SendJob{ std::move(payload), kind, Clock::now(), version };
+    if (!mQueue.TryPush(std::move(job)))
+    {
+        // Socket is stalled. Frames are dropped and server is resynced with
+        // snapshot when sender catches up. Full queue leaves job untouched.
+        mIsOverflowed.store(true);
+        mMetrics.CountFrame(GetSectionMasks(job.Data->Get()), false);
+        RecordVersion(job, false, false);
+        return;
+    }
+
+    // Lock only guards wake up, payloads go through queue.
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        mIsSignaled = true;
+    }
+
+    mCondition.notify_one();
+}
+
+auto PayloadSender::Run() -> void
+{
+    auto job = SendJob();
+    for (;;)
+    {
+        auto onOverflowCallback = std::function<void()>();
+        {
+            auto lock = std::unique_lock<std::mutex>(mMutex);
+            mCondition.wait(lock, [this]() { return mIsStopping || mIsSignaled; });
+
+            if (mIsStopping)
+            {
+                return;
+            }
+
+            mIsSignaled        = false;
+            onOverflowCallback = mOnOverflowCallback;
+        }
+
+        while (mQueue.TryPop(job))
+        {
+            Process(job);
+        }
+
+        if (mIsOverflowed.exchange(false))
+        {
+            onOverflowCallback();
+        }
+    }
+}
+
+auto PayloadSender::Process(SendJob& job) -> void
+{
+    const auto& shared = *job.Data;
+
+    // Server of new connection may not have covers of old one, even if it
+    // is the same server.
+    auto epoch = mWebSocket.GetEpoch();
+    if (epoch != mCoverEpoch)
+    {
+        mSentCovers.clear();
+        mCoverEpoch = epoch;
+    }
+
+    // Copy is cheap, image itself is shared. Sections this server doesn't
+    // need are removed from the copy only.
+    auto payload = shared.Get();
+    if (job.Kind != JobKind::Reply && !Filter(payload))
+    {
+        // Nothing this server needs, it's up to date anyway.
+        RecordVersion(job, true, false);
+        return;
+    }
+
+    auto imageHash = GetImageHash(payload);
+    auto isSent    = false;
+    if (job.Kind == JobKind::Snapshot)
+    {
+        // Failed snapshot leaves server with what it had before.
+        isSent = mWebSocket.Send(payload, &shared);
+        mMetrics.CountFrame(GetSectionMasks(payload), isSent);
+        RecordVersion(job, isSent, isSent);
+        if (isSent)
+        {
+            mLastSent = std::move(payload);
+        }
+    }
+    else if (mWebSocket.HasFeature(ServerFeature::Delta))
+    {
+        isSent = SendDelta(std::move(payload), job);
+    }
+    else
+    {
+        isSent = mWebSocket.Send(payload, &shared);
+        mMetrics.CountFrame(GetSectionMasks(payload), isSent);
+        RecordVersion(job, isSent, isSent);
+    }
+
+    // Server has image only if frame got out on connection it was filtered
+    // for, otherwise next frame carries it again.
+    if (isSent && imageHash.has_value() && mWebSocket.GetLastFrame().Epoch == mCoverEpoch)
+    {
+        MarkCoverSent(imageHash.value());
+    }
+
+    // Time from capture on main thread until frame is handed to socket.
+    auto elapsed = Clock::now() - job.EnqueuedAt;
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+    mLastLatency.store(latency);
+    if (latency > mMaxLatency.load())
+    {
+        mMaxLatency.store(latency);
+    }
+}
+
+auto PayloadSender::Filter(Payload& payload) -> bool
+{
+    // Server extrapolates Elapsed from anchors, position alone is useless.
+    if (mWebSocket.HasFeature(ServerFeature::Anchor) && payload.Playback.has_value())
+    {
+        if (!payload.Playback.value().State.has_value())
+        {
+            payload.Playback = std::nullopt;
+        }
+    }
+
+    // Server has this cover, hash is enough. Server sends Cover request if
+    // it doesn't.
+    if (mWebSocket.HasFeature(ServerFeature::CoverHash) && payload.Cover.has_value())
+    {
+        auto& cover = payload.Cover.value();
+        if (cover.Hash.has_value() && cover.Image.has_value())
+        {
+            if (IsCoverSent(cover.Hash.value()))
+            {
+                cover.Image = std::nullopt;
+            }
+        }
+    }
+
+    if (!mWebSocket.HasFeature(ServerFeature::Stats))
+    {
+        payload.Stats = std::nullopt;
+    }
+
+    // Only fields this server asked for, the rest belongs to other servers.
+    if (payload.Fields.has_value())
+    {
+        auto schema = mWebSocket.GetSchema();
+        if (schema != nullptr)
+        {
+            FilterFields(payload.Fields.value(), *schema);
+        }
+        else
+        {
+            payload.Fields = std::nullopt;
+        }
+    }
+
+    auto isEmpty = true;
+    Payload::VisitFields([&](const char*, auto member)
+    {
+        isEmpty = isEmpty && !(payload.*member).has_value();
+    });
+
+    return !isEmpty;
+}
+
+auto PayloadSender::GetSectionMasks(const Payload& payload) -> FieldMasks<Payload>
+{
+    auto masks = FieldMasks<Payload>();
+    auto index = 0;
+    Payload::VisitFields([&](const char*, auto member)
+    {
+        masks.Fields[index] = (payload.*member).has_value() ? ALL_FIELDS : 0;
+        index += 1;
+    });
+
+    return masks;
+}
+
+auto PayloadSender::GetImageHash(const Payload& payload) -> std::optional<std::string>
+{
+    if (!payload.Cover.has_value())
+    {
+        return std::nullopt;
+    }
+
+    const auto& cover = payload.Cover.value();
+    if (!cover.Hash.has_value() || !cover.Image.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return cover.Hash.value();
+}
+
+auto PayloadSender::IsCoverSent(const std::string& hash) const -> bool
+{
+    return std::find(mSentCovers.begin(), mSentCovers.end(), hash) != mSentCovers.end();
+}
+
+auto PayloadSender::MarkCoverSent(const std::string& hash) -> void
+{
+    if (IsCoverSent(hash))
+    {
+        return;
+    }
+
+    // Server cache is bounded too, assume it forgets the oldest covers.
+    mSentCovers.push_back(hash);
+    if (mSentCovers.size() > COVER_CACHE_SIZE)
+    {
+        mSentCovers.pop_front();
+    }
+}
+
+auto PayloadSender::SendDelta(Payload payload, const SendJob& job) -> bool
+{
+    // Missing section means unchanged. Player, Song and Cover are always
+    // sent whole. Playback without State carries only Elapsed.
+    if (payload.Playback.has_value() && mLastSent.Playback.has_value())
+    {
+        if (!payload.Playback.value().State.has_value())
+        {
+            payload.Playback.value().State = mLastSent.Playback.value().State;
+        }
+    }
+
+    // Merged into copy, server knows the new state only if the frame got
+    // out. Otherwise the next delta is diffed against what it really has.
+    auto merged    = mLastSent;
+    auto masks     = FieldMasks<Payload>();
+    auto isChanged = false;
+    auto index     = 0;
+    Payload::VisitFields([&](const char*, auto member)
+    {
+        auto& before = merged.*member;
+        auto& after  = payload.*member;
+        if (after.has_value())
+        {
+            masks.Fields[index] = DiffFields(before, after);
+            isChanged = isChanged || masks.Fields[index] != 0;
+            before = std::move(after);
+        }
+        index += 1;
+    });
+
+    // Server already has everything.
+    if (!isChanged)
+    {
+        RecordVersion(job, true, false);
+        return true;
+    }
+
+    auto isSent = mWebSocket.SendDelta(merged, masks, job.Data.get());
+    if (isSent)
+    {
+        mLastSent = std::move(merged);
+    }
+
+    mMetrics.CountFrame(masks, isSent);
+    RecordVersion(job, isSent, isSent);
+    return isSent;
+}
+
+auto PayloadSender::RecordVersion(const SendJob& job, bool isSent, bool isFramed) -> void
+{
+    if (job.Kind == JobKind::Reply)
+    {
+        return;
+    }
+
+    auto entry = SentVersion{ job.Version, std::nullopt, job.Kind == JobKind::Snapshot, isSent };
+    if (isFramed && mWebSocket.GetLastFrame().IsTracked)
+    {
+        entry.Frame = mWebSocket.GetLastFrame();
+    }
+
+    auto lock = std::lock_guard<std::mutex>(mVersionMutex);
+    mVersions.push_back(entry);
+    ResolveVersions();
+}
+
+auto PayloadSender::ResolveVersions() -> void
+{
+    // In send order, version of update counts only if server got every
+    // job before it. Snapshot closes any gap.
+    while (!mVersions.empty())
+    {
+        auto& entry = mVersions.front();
+        if (entry.Frame.has_value())
+        {
+            auto state = mWebSocket.GetAckState(entry.Frame.value());
+            if (state == AckState::Pending)
+            {
+                break;
+            }
+
+            entry.IsSent = state == AckState::Acked;
+        }
+
+        if (!entry.IsSent)
+        {
+            mIsGap = true;
+        }
+        else if (entry.IsSnapshot || !mIsGap)
+        {
+            mSyncedVersion = std::max(mSyncedVersion, entry.Version);
+            mIsGap         = false;
+        }
+
+        mVersions.pop_front();
+    }
+}
+
+auto PayloadSender::GetSyncedVersion() -> std::uint64_t
+{
+    auto lock = std::lock_guard<std::mutex>(mVersionMutex);
+    ResolveVersions();
+    return mSyncedVersion;
+}
+
+} // namespace foo_showplay
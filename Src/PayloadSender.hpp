@@ -0,0 +1,140 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "Constants.hpp"
+#include "Metrics.hpp"
+#include "Payload.hpp"
+#include "SharedPayload.hpp"
+#include "SpscQueue.hpp"
+#include "WebSocket.hpp"
+
+namespace foo_showplay {
+
+// Encodes and writes payloads on its own thread, so slow socket doesn't
+// block foobar2000 main thread. Main thread only captures payloads, the same
+// payload may be shared by senders of several endpoints.
+class PayloadSender
+{
+    using Clock = std::chrono::steady_clock;
+
+    enum class JobKind
+    {
+        Update,   // Changed sections.
+        Snapshot, // Replaces state known by server.
+        Reply,    // Answer to server request, sent as is.
+    };
+
+    struct SendJob
+    {
+        std::shared_ptr<const SharedPayload> Data;
+        JobKind                              Kind;
+        Clock::time_point                    EnqueuedAt;
+        std::uint64_t                        Version; // StateStore version server has after it, 0 for reply.
+    };
+
+    // Outcome of job that brings server to new version, in send order.
+    struct SentVersion
+    {
+        std::uint64_t          Version;
+        std::optional<FrameId> Frame;      // Waiting for ack, none if outcome is known.
+        bool                   IsSnapshot; // Whole state, not only changes since previous job.
+        bool                   IsSent;     // Lost job leaves gap until next snapshot.
+    };
+
+    WebSocketClient&                     mWebSocket;
+    Metrics&                             mMetrics;
+    SpscQueue<SendJob, SEND_QUEUE_SIZE>  mQueue;
+    Payload                              mLastSent;   // State known by server, used in delta mode.
+    std::deque<std::string>              mSentCovers; // Hashes of covers server has, most recent last.
+    unsigned                             mCoverEpoch; // Connection covers were sent on.
+
+    std::mutex                           mMutex;
+    std::condition_variable              mCondition;
+    bool                                 mIsSignaled;
+    bool                                 mIsStopping;
+    std::atomic<bool>                    mIsOverflowed; // Payload was lost, server needs snapshot.
+    std::atomic<std::int64_t>            mLastLatency;  // In microseconds.
+    std::atomic<std::int64_t>            mMaxLatency;   // In microseconds.
+
+    // Version server is known to have, what sync section of snapshot starts
+    // from. Advanced when frame got out, or when it's acked with Ack.
+    std::mutex                           mVersionMutex; // Guards members below, sender and main thread.
+    std::deque<SentVersion>              mVersions;     // Not resolved yet, oldest first.
+    std::uint64_t                        mSyncedVersion;
+    bool                                 mIsGap;        // Server missed changes after synced version.
+
+    std::function<void()>                mOnOverflowCallback;
+    std::thread                          mThread;
+
+    auto Run       ()                         -> void;
+    auto Process   (SendJob& job)             -> void;
+    auto Filter    (Payload& payload)         -> bool;
+    auto SendDelta (Payload payload, const SendJob& job) -> bool;
+    auto Push      (std::shared_ptr<const SharedPayload> payload, JobKind kind, std::uint64_t version) -> void;
+
+    auto RecordVersion   (const SendJob& job, bool isSent, bool isFramed) -> void;
+    auto ResolveVersions ()                                               -> void; // Version lock held.
+
+    // Whole sections that are present, how full frame is counted.
+    static auto GetSectionMasks (const Payload& payload) -> FieldMasks<Payload>;
+
+    // Hash of image payload carries, if any.
+    static auto GetImageHash (const Payload& payload) -> std::optional<std::string>;
+
+    auto IsCoverSent   (const std::string& hash) const -> bool;
+    auto MarkCoverSent (const std::string& hash)       -> void;
+
+public:
+    PayloadSender(WebSocketClient& webSocket, Metrics& metrics);
+    ~PayloadSender();
+
+    PayloadSender(const PayloadSender&)            = delete;
+    PayloadSender& operator=(const PayloadSender&) = delete;
+
+    // Invoked on sender thread after queue was full and is drained again.
+    auto SetOnOverflowCallback (std::function<void()> callback) -> void;
+
+    // Main thread only. Version is of StateStore once payload is applied.
+    auto Enqueue         (std::shared_ptr<const SharedPayload> payload, std::uint64_t version) -> void { Push(std::move(payload), JobKind::Update, version); }
+    auto EnqueueSnapshot (Payload payload, std::uint64_t version) -> void { Push(std::make_shared<const SharedPayload>(std::move(payload)), JobKind::Snapshot, version); }
+    auto EnqueueReply    (Payload payload) -> void { Push(std::make_shared<const SharedPayload>(std::move(payload)), JobKind::Reply, 0); }
+
+    // Last StateStore version server is known to have, 0 if none.
+    auto GetSyncedVersion () -> std::uint64_t;
+
+    auto GetQueueDepth  () const -> std::size_t               { return mQueue.Size(); }
+    auto GetLastLatency () const -> std::chrono::microseconds { return std::chrono::microseconds(mLastLatency.load()); }
+    auto GetMaxLatency  () const -> std::chrono::microseconds { return std::chrono::microseconds(mMaxLatency.load());  }
+};
+
+} // namespace foo_showplay
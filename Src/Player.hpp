@@ -0,0 +1,73 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+
+#include "FieldSchema.hpp"
+#include "Payload.hpp"
+
+namespace foo_showplay {
+
+// Player reported by session. Implemented by foobar2000 component and by
+// simulated player, so send pipeline doesn't depend on foobar2000. Called
+// on main thread only.
+class Player
+{
+public:
+    virtual ~Player() = default;
+
+    virtual auto GetName     () -> std::string = 0;
+    virtual auto HasTrack    () -> bool = 0;
+    virtual auto GetState    () -> PlaybackState = 0;
+    virtual auto GetPosition () -> double = 0; // In seconds.
+
+    // Of current track.
+    virtual auto GetSong     () -> std::optional<SongInfo> = 0;
+    virtual auto GetCover    () -> std::optional<BinaryData> = 0; // Album art as stored, if track has any.
+
+    // Fields of server schemas, evaluated for current track by GetFields.
+    virtual auto SetFieldSchema (const FieldSchema& schema) -> void = 0;
+    virtual auto GetFields      () -> std::optional<CustomFields> = 0;
+};
+
+// Environment session runs in.
+class Host
+{
+public:
+    virtual ~Host() = default;
+
+    // Runs task on main thread, callable from any thread.
+    virtual auto InMainThread (std::function<void()> task) -> void = 0;
+
+    // One shot timer firing on main thread, starting new one replaces old.
+    virtual auto StartTimer (std::chrono::milliseconds delay, std::function<void()> callback) -> void = 0;
+    virtual auto StopTimer  () -> void = 0;
+
+    virtual auto Log (const std::string& message) -> void = 0;
+
+    // Connection status or token changed.
+    virtual auto OnStatusChanged () -> void = 0;
+};
+
+} // namespace foo_showplay
@@ -0,0 +1,310 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "PortableImageCodec.hpp"
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include <jpeglib.h>
+#include <png.h>
+
+namespace foo_showplay {
+
+static constexpr std::uint8_t PNG_SIGNATURE[]  = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+static constexpr std::uint8_t JPEG_SIGNATURE[] = { 0xFF, 0xD8, 0xFF };
+
+// Covers larger than this are rejected instead of allocated.
+static constexpr std::uint32_t MAX_DIMENSION = 16384;
+
+// libjpeg reports errors by calling error_exit, which must not return.
+struct JpegError
+{
+    jpeg_error_mgr Manager;
+    std::jmp_buf   Jump;
+};
+
+static auto OnJpegError(j_common_ptr info) -> void
+{
+    auto error = reinterpret_cast<JpegError*>(info->err);
+    std::longjmp(error->Jump, 1);
+}
+
+static auto OnJpegMessage(j_common_ptr, int) -> void
+{
+    // Warnings of damaged but decodable covers are of no interest.
+}
+
+// Writes compressed data into vector owned by caller, so nothing is left to
+// free when libjpeg bails out.
+struct JpegDestination
+{
+    static constexpr auto BufferSize = std::size_t(16384);
+
+    jpeg_destination_mgr       Manager;
+    std::vector<std::uint8_t>& Output;
+    std::uint8_t               Buffer[BufferSize];
+
+    JpegDestination(std::vector<std::uint8_t>& output)
+        : Manager ()
+        , Output  (output)
+    {
+        Manager.init_destination    = Init;
+        Manager.empty_output_buffer = Empty;
+        Manager.term_destination    = Term;
+    }
+
+    static auto Get (j_compress_ptr info) -> JpegDestination& { return *reinterpret_cast<JpegDestination*>(info->dest); }
+
+    static auto Init(j_compress_ptr info) -> void
+    {
+        auto& destination = Get(info);
+        destination.Manager.next_output_byte = destination.Buffer;
+        destination.Manager.free_in_buffer   = BufferSize;
+    }
+
+    // Called when whole buffer is full, free_in_buffer isn't updated.
+    static auto Empty(j_compress_ptr info) -> boolean
+    {
+        auto& destination = Get(info);
+        destination.Output.insert(destination.Output.end(), destination.Buffer, destination.Buffer + BufferSize);
+        Init(info);
+        return TRUE;
+    }
+
+    static auto Term(j_compress_ptr info) -> void
+    {
+        auto& destination = Get(info);
+        auto  used        = BufferSize - destination.Manager.free_in_buffer;
+        destination.Output.insert(destination.Output.end(), destination.Buffer, destination.Buffer + used);
+    }
+};
+
+static auto SwapRedBlue(std::uint8_t* row, std::uint32_t width) -> void
+{
+    for (auto x = std::uint32_t(0); x < width; ++x)
+    {
+        std::swap(row[x * 3], row[x * 3 + 2]);
+    }
+}
+
+static auto HasSignature(const std::uint8_t* data, std::size_t size, const std::uint8_t* signature, std::size_t length) -> bool
+{
+    return size >= length && std::memcmp(data, signature, length) == 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+static auto DecodeJpeg(const std::uint8_t* data, std::size_t size) -> std::optional<DecodedImage>
+{
+    auto info  = jpeg_decompress_struct();
+    auto error = JpegError();
+    info.err = jpeg_std_error(&error.Manager);
+    error.Manager.error_exit   = OnJpegError;
+    error.Manager.emit_message = OnJpegMessage;
+
+    // Nothing with destructor may be created between setjmp and longjmp,
+    // image is declared before.
+    auto image = DecodedImage();
+    if (setjmp(error.Jump) != 0)
+    {
+        jpeg_destroy_decompress(&info);
+        return std::nullopt;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, data, static_cast<unsigned long>(size));
+    jpeg_read_header(&info, TRUE);
+
+    // Grayscale is expanded too. CMYK covers fail here and are sent as they
+    // are.
+    info.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&info);
+
+    if (info.output_components != 3 || info.output_width > MAX_DIMENSION || info.output_height > MAX_DIMENSION)
+    {
+        jpeg_destroy_decompress(&info);
+        return std::nullopt;
+    }
+
+    image = DecodedImage(info.output_width, info.output_height);
+    while (info.output_scanline < info.output_height)
+    {
+        auto row = image.Pixels.data() + static_cast<std::size_t>(info.output_scanline) * image.Stride;
+        jpeg_read_scanlines(&info, &row, 1);
+        SwapRedBlue(row, image.Width);
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+
+    return image;
+}
+
+static auto DecodePng(const std::uint8_t* data, std::size_t size) -> std::optional<DecodedImage>
+{
+    auto info    = png_image();
+    info.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_memory(&info, data, size))
+    {
+        return std::nullopt;
+    }
+
+    if (info.width == 0 || info.height == 0 || info.width > MAX_DIMENSION || info.height > MAX_DIMENSION)
+    {
+        png_image_free(&info);
+        return std::nullopt;
+    }
+
+    // Transparent parts end up white, like cover shown on white page.
+    auto background = png_color{ 255, 255, 255 };
+    auto image      = DecodedImage(info.width, info.height);
+    info.format = PNG_FORMAT_BGR;
+    if (!png_image_finish_read(&info, &background, image.Pixels.data(), static_cast<png_int_32>(image.Stride), nullptr))
+    {
+        png_image_free(&info);
+        return std::nullopt;
+    }
+
+    return image;
+}
+
+// -------------------------------------------------------------------------- //
+
+auto PortableImageCodec::Decode(const std::uint8_t* data, std::size_t size) -> std::optional<DecodedImage>
+{
+    if (data == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    if (HasSignature(data, size, JPEG_SIGNATURE, sizeof(JPEG_SIGNATURE)))
+    {
+        return DecodeJpeg(data, size);
+    }
+
+    if (HasSignature(data, size, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)))
+    {
+        return DecodePng(data, size);
+    }
+
+    return std::nullopt;
+}
+
+auto PortableImageCodec::Resize(const DecodedImage& image, std::uint32_t width, std::uint32_t height) -> std::optional<DecodedImage>
+{
+    if (image.Width == 0 || image.Height == 0 || width == 0 || height == 0)
+    {
+        return std::nullopt;
+    }
+
+    // Box filter, each pixel is average of source pixels it covers. Good
+    // quality when downscaling by large factors, like Fant of WIC.
+    auto resized = DecodedImage(width, height);
+    for (auto y = std::uint32_t(0); y < height; ++y)
+    {
+        auto top    = static_cast<std::uint32_t>(std::uint64_t(y) * image.Height / height);
+        auto bottom = std::max(top + 1, static_cast<std::uint32_t>(std::uint64_t(y + 1) * image.Height / height));
+
+        auto out = resized.Pixels.data() + static_cast<std::size_t>(y) * resized.Stride;
+        for (auto x = std::uint32_t(0); x < width; ++x)
+        {
+            auto left  = static_cast<std::uint32_t>(std::uint64_t(x) * image.Width / width);
+            auto right = std::max(left + 1, static_cast<std::uint32_t>(std::uint64_t(x + 1) * image.Width / width));
+
+            std::uint32_t sum[3] = {};
+            for (auto sy = top; sy < bottom; ++sy)
+            {
+                auto in = image.Pixels.data() + static_cast<std::size_t>(sy) * image.Stride + left * 3;
+                for (auto sx = left; sx < right; ++sx, in += 3)
+                {
+                    sum[0] += in[0];
+                    sum[1] += in[1];
+                    sum[2] += in[2];
+                }
+            }
+
+            auto count = (bottom - top) * (right - left);
+            for (auto c = 0; c < 3; ++c)
+            {
+                out[x * 3 + c] = static_cast<std::uint8_t>((sum[c] + count / 2) / count);
+            }
+        }
+    }
+
+    return resized;
+}
+
+auto PortableImageCodec::EncodeJpeg(const DecodedImage& image, int quality) -> std::optional<std::vector<std::uint8_t>>
+{
+    if (image.Width == 0 || image.Height == 0)
+    {
+        return std::nullopt;
+    }
+
+    auto info  = jpeg_compress_struct();
+    auto error = JpegError();
+    info.err = jpeg_std_error(&error.Manager);
+    error.Manager.error_exit   = OnJpegError;
+    error.Manager.emit_message = OnJpegMessage;
+
+    // Everything with destructor is created before setjmp, longjmp skips
+    // none of them.
+    auto encoded     = std::vector<std::uint8_t>();
+    auto destination = std::make_unique<JpegDestination>(encoded);
+    auto row         = std::vector<std::uint8_t>(static_cast<std::size_t>(image.Width) * 3);
+    if (setjmp(error.Jump) != 0)
+    {
+        jpeg_destroy_compress(&info);
+        return std::nullopt;
+    }
+
+    jpeg_create_compress(&info);
+    info.dest = &destination->Manager;
+
+    info.image_width      = image.Width;
+    info.image_height     = image.Height;
+    info.input_components = 3;
+    info.in_color_space   = JCS_RGB;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, quality, TRUE);
+    jpeg_start_compress(&info, TRUE);
+
+    while (info.next_scanline < info.image_height)
+    {
+        auto in = image.Pixels.data() + static_cast<std::size_t>(info.next_scanline) * image.Stride;
+        std::memcpy(row.data(), in, row.size());
+        SwapRedBlue(row.data(), image.Width);
+
+        auto rowPointer = row.data();
+        jpeg_write_scanlines(&info, &rowPointer, 1);
+    }
+
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+
+    return encoded;
+}
+
+} // namespace foo_showplay
@@ -21,25 +21,73 @@
 #include "Preferences.hpp"
 #include "Constants.hpp"
 #include "Main.hpp"
+#include "ReconnectPolicy.hpp"
 
 // These GUIDs identify the variables within our component's configuration file.
 static const auto GUID_CFG_SHOWPLAY_SERVER_URL = GUID{ 0x4d7dc091, 0x70cd, 0x4249, { 0xb9, 0x5f, 0xea, 0x9b, 0x99, 0x38, 0xb, 0x82 } };
-static auto cfgServerUrl = cfg_string(GUID_CFG_SHOWPLAY_SERVER_URL, foo_showplay::DEFAULT_SERVER_URL);
+static const auto GUID_CFG_SHOWPLAY_COVER_MAX_EDGE  = GUID{ 0x34582d42, 0xa512, 0x47b2, { 0x9a, 0xd2, 0x9b, 0xb8, 0x61, 0x46, 0x80, 0xe3 } };
+static const auto GUID_CFG_SHOWPLAY_MAX_SEND_RATE   = GUID{ 0x5b0e7c1d, 0x3f62, 0x4a8e, { 0x91, 0x2c, 0x6d, 0xe4, 0x07, 0xb3, 0x58, 0xf1 } };
+static const auto GUID_CFG_SHOWPLAY_COVER_MAX_BYTES = GUID{ 0x837c3298, 0x0091, 0x470a, { 0x8d, 0x5d, 0xb9, 0x24, 0x4c, 0x22, 0x98, 0xaa } };
+static const auto GUID_CFG_SHOWPLAY_RECONNECT_BASE_DELAY = GUID{ 0xfe2bc931, 0xcb01, 0x4067, { 0x85, 0xcb, 0x4f, 0x78, 0xb2, 0x52, 0xea, 0x02 } };
+static const auto GUID_CFG_SHOWPLAY_RECONNECT_MAX_DELAY  = GUID{ 0xa61785cf, 0xf57b, 0x4df3, { 0xa3, 0xdb, 0xa9, 0x5f, 0x3d, 0x90, 0x86, 0x00 } };
+static const auto GUID_CFG_SHOWPLAY_PING_INTERVAL        = GUID{ 0x5632b1cc, 0xc170, 0x46b9, { 0x80, 0xd9, 0xe7, 0x73, 0x08, 0xe7, 0xa7, 0x69 } };
+static const auto GUID_CFG_SHOWPLAY_DEAD_PEER_TIMEOUT    = GUID{ 0x3db87f00, 0x05af, 0x4c00, { 0xb9, 0x17, 0xfe, 0xba, 0x2a, 0xe4, 0xdb, 0xae } };
+static auto cfgServerUrl     = cfg_string(GUID_CFG_SHOWPLAY_SERVER_URL, foo_showplay::DEFAULT_SERVER_URL);
+static auto cfgCoverMaxEdge  = cfg_int(GUID_CFG_SHOWPLAY_COVER_MAX_EDGE, foo_showplay::DEFAULT_COVER_MAX_EDGE);
+static auto cfgCoverMaxBytes = cfg_int(GUID_CFG_SHOWPLAY_COVER_MAX_BYTES, foo_showplay::DEFAULT_COVER_MAX_BYTES);
+static auto cfgMaxSendRate   = cfg_int(GUID_CFG_SHOWPLAY_MAX_SEND_RATE, foo_showplay::DEFAULT_MAX_SEND_RATE);
+static auto cfgReconnectBaseDelay = cfg_int(GUID_CFG_SHOWPLAY_RECONNECT_BASE_DELAY, foo_showplay::DEFAULT_RECONNECT_BASE_DELAY);
+static auto cfgReconnectMaxDelay  = cfg_int(GUID_CFG_SHOWPLAY_RECONNECT_MAX_DELAY, foo_showplay::DEFAULT_RECONNECT_MAX_DELAY);
+static auto cfgPingInterval       = cfg_int(GUID_CFG_SHOWPLAY_PING_INTERVAL, foo_showplay::DEFAULT_PING_INTERVAL);
+static auto cfgDeadPeerTimeout    = cfg_int(GUID_CFG_SHOWPLAY_DEAD_PEER_TIMEOUT, foo_showplay::DEFAULT_DEAD_PEER_TIMEOUT);
 
 namespace foo_showplay {
-    cfg_string* gCfgServerUrl = &cfgServerUrl;
+    cfg_string* gCfgServerUrl     = &cfgServerUrl;
+    cfg_int*    gCfgCoverMaxEdge  = &cfgCoverMaxEdge;
+    cfg_int*    gCfgCoverMaxBytes = &cfgCoverMaxBytes;
+    cfg_int*    gCfgMaxSendRate   = &cfgMaxSendRate;
+    cfg_int*    gCfgReconnectBaseDelay = &cfgReconnectBaseDelay;
+    cfg_int*    gCfgReconnectMaxDelay  = &cfgReconnectMaxDelay;
+    cfg_int*    gCfgPingInterval       = &cfgPingInterval;
+    cfg_int*    gCfgDeadPeerTimeout    = &cfgDeadPeerTimeout;
 }
 
 namespace foo_showplay {
 
+// Metrics change with every frame, they are polled while page is open.
+static constexpr auto METRICS_TIMER_ID       = UINT_PTR(1);
+static constexpr auto METRICS_TIMER_INTERVAL = UINT(1000);
+
 auto ShowPlayPreferences::OnInitDialog(CWindow, LPARAM) -> BOOL
 {
     uSetDlgItemText(*this, IDC_SERVER_URL, gCfgServerUrl->c_str());
+    SetDlgItemInt(IDC_COVER_MAX_EDGE, static_cast<UINT>(*gCfgCoverMaxEdge), FALSE);
+    SetDlgItemInt(IDC_COVER_MAX_BYTES, static_cast<UINT>(*gCfgCoverMaxBytes), FALSE);
+    SetDlgItemInt(IDC_MAX_SEND_RATE, static_cast<UINT>(*gCfgMaxSendRate), FALSE);
+    SetDlgItemInt(IDC_RECONNECT_BASE_DELAY, static_cast<UINT>(*gCfgReconnectBaseDelay), FALSE);
+    SetDlgItemInt(IDC_RECONNECT_MAX_DELAY, static_cast<UINT>(*gCfgReconnectMaxDelay), FALSE);
+    SetDlgItemInt(IDC_PING_INTERVAL, static_cast<UINT>(*gCfgPingInterval), FALSE);
+    SetDlgItemInt(IDC_DEAD_PEER_TIMEOUT, static_cast<UINT>(*gCfgDeadPeerTimeout), FALSE);
     UpdateConnectionStatus();
+    UpdateMetrics();
+    SetTimer(METRICS_TIMER_ID, METRICS_TIMER_INTERVAL);
 
     return FALSE;
 }
 
+auto ShowPlayPreferences::OnDestroy() -> void
+{
+    KillTimer(METRICS_TIMER_ID);
+}
+
+auto ShowPlayPreferences::OnTimer(UINT_PTR id) -> void
+{
+    if (id == METRICS_TIMER_ID)
+    {
+        UpdateMetrics();
+    }
+}
+
 auto ShowPlayPreferences::OnEditChange(UINT, int, CWindow) -> void
 {
     OnChanged();
@@ -50,14 +98,23 @@ auto ShowPlayPreferences::UpdateConnectionStatus() -> void
     auto client = GetShowPlayClient();
     if (client)
     {
-        auto isConnected = client->IsConnected();
-        auto token = client->GetToken();
+        auto status = client->GetConnectionStatus();
+        auto token  = client->GetToken();
 
-        uSetDlgItemText(*this, IDC_STATUS, isConnected ? "Connected" : "Disconnected");
+        uSetDlgItemText(*this, IDC_STATUS, status.c_str());
         uSetDlgItemText(*this, IDC_TOKEN, token.has_value() ? token.value().c_str() : "");
     }
 }
 
+auto ShowPlayPreferences::UpdateMetrics() -> void
+{
+    auto client = GetShowPlayClient();
+    if (client)
+    {
+        uSetDlgItemText(*this, IDC_METRICS, client->GetSession().GetMetrics().Format().c_str());
+    }
+}
+
 auto ShowPlayPreferences::get_state() -> t_uint32
 {
     auto state = static_cast<t_uint32>(preferences_state::resettable);
@@ -72,6 +129,13 @@ auto ShowPlayPreferences::get_state() -> t_uint32
 auto ShowPlayPreferences::reset() -> void
 {
     uSetDlgItemText(*this, IDC_SERVER_URL, DEFAULT_SERVER_URL);
+    SetDlgItemInt(IDC_COVER_MAX_EDGE, DEFAULT_COVER_MAX_EDGE, FALSE);
+    SetDlgItemInt(IDC_COVER_MAX_BYTES, DEFAULT_COVER_MAX_BYTES, FALSE);
+    SetDlgItemInt(IDC_MAX_SEND_RATE, DEFAULT_MAX_SEND_RATE, FALSE);
+    SetDlgItemInt(IDC_RECONNECT_BASE_DELAY, DEFAULT_RECONNECT_BASE_DELAY, FALSE);
+    SetDlgItemInt(IDC_RECONNECT_MAX_DELAY, DEFAULT_RECONNECT_MAX_DELAY, FALSE);
+    SetDlgItemInt(IDC_PING_INTERVAL, DEFAULT_PING_INTERVAL, FALSE);
+    SetDlgItemInt(IDC_DEAD_PEER_TIMEOUT, DEFAULT_DEAD_PEER_TIMEOUT, FALSE);
     UpdateConnectionStatus();
     OnChanged();
 }
@@ -81,9 +145,39 @@ auto ShowPlayPreferences::apply() ->void
     auto str = uGetDlgItemText(*this, IDC_SERVER_URL);
     gCfgServerUrl->set_string(str.c_str());
 
+    auto maxEdge  = static_cast<int>(GetDlgItemInt(IDC_COVER_MAX_EDGE, nullptr, FALSE));
+    auto maxBytes = static_cast<int>(GetDlgItemInt(IDC_COVER_MAX_BYTES, nullptr, FALSE));
+    auto maxRate  = static_cast<int>(GetDlgItemInt(IDC_MAX_SEND_RATE, nullptr, FALSE));
+    auto isCoverChanged = maxEdge != *gCfgCoverMaxEdge || maxBytes != *gCfgCoverMaxBytes;
+    *gCfgCoverMaxEdge  = maxEdge;
+    *gCfgCoverMaxBytes = maxBytes;
+    *gCfgMaxSendRate   = maxRate;
+
+    *gCfgReconnectBaseDelay = static_cast<int>(GetDlgItemInt(IDC_RECONNECT_BASE_DELAY, nullptr, FALSE));
+    *gCfgReconnectMaxDelay  = static_cast<int>(GetDlgItemInt(IDC_RECONNECT_MAX_DELAY, nullptr, FALSE));
+    *gCfgPingInterval       = static_cast<int>(GetDlgItemInt(IDC_PING_INTERVAL, nullptr, FALSE));
+    *gCfgDeadPeerTimeout    = static_cast<int>(GetDlgItemInt(IDC_DEAD_PEER_TIMEOUT, nullptr, FALSE));
+
+    // Timeout shorter than two pings would drop healthy connection, dialog
+    // shows what is used. With pings off it's kept for when they're on.
+    if (*gCfgPingInterval > 0 && *gCfgDeadPeerTimeout > 0)
+    {
+        auto deadPeer = foo_showplay::ClampDeadPeerTimeout(std::chrono::seconds(*gCfgPingInterval), std::chrono::seconds(*gCfgDeadPeerTimeout));
+        *gCfgDeadPeerTimeout = static_cast<int>(deadPeer.count());
+        SetDlgItemInt(IDC_DEAD_PEER_TIMEOUT, static_cast<UINT>(*gCfgDeadPeerTimeout), FALSE);
+    }
+
     auto client = GetShowPlayClient();
     if (client)
     {
+        if (isCoverChanged)
+        {
+            client->ResetCovers();
+        }
+
+        client->SetMaxSendRate(maxRate);
+        client->UpdateReconnectSettings();
+
         client->Connect(str.c_str());
     }
 
@@ -92,8 +186,18 @@ auto ShowPlayPreferences::apply() ->void
 
 auto ShowPlayPreferences::HasChanged() -> bool
 {
-    auto str = uGetDlgItemText(*this, IDC_SERVER_URL);
-    return str != *gCfgServerUrl;
+    auto str      = uGetDlgItemText(*this, IDC_SERVER_URL);
+    auto maxEdge  = static_cast<int>(GetDlgItemInt(IDC_COVER_MAX_EDGE, nullptr, FALSE));
+    auto maxBytes = static_cast<int>(GetDlgItemInt(IDC_COVER_MAX_BYTES, nullptr, FALSE));
+    auto maxRate  = static_cast<int>(GetDlgItemInt(IDC_MAX_SEND_RATE, nullptr, FALSE));
+    auto baseDelay    = static_cast<int>(GetDlgItemInt(IDC_RECONNECT_BASE_DELAY, nullptr, FALSE));
+    auto maxDelay     = static_cast<int>(GetDlgItemInt(IDC_RECONNECT_MAX_DELAY, nullptr, FALSE));
+    auto pingInterval = static_cast<int>(GetDlgItemInt(IDC_PING_INTERVAL, nullptr, FALSE));
+    auto deadPeer     = static_cast<int>(GetDlgItemInt(IDC_DEAD_PEER_TIMEOUT, nullptr, FALSE));
+
+    return str != *gCfgServerUrl || maxEdge != *gCfgCoverMaxEdge || maxBytes != *gCfgCoverMaxBytes ||
+           maxRate != *gCfgMaxSendRate || baseDelay != *gCfgReconnectBaseDelay || maxDelay != *gCfgReconnectMaxDelay ||
+           pingInterval != *gCfgPingInterval || deadPeer != *gCfgDeadPeerTimeout;
 }
 
 auto ShowPlayPreferences::OnChanged() -> void
@@ -26,6 +26,13 @@
 namespace foo_showplay {
 
     extern cfg_string* gCfgServerUrl;
+    extern cfg_int*    gCfgCoverMaxEdge;
+    extern cfg_int*    gCfgCoverMaxBytes;
+    extern cfg_int*    gCfgMaxSendRate;
+    extern cfg_int*    gCfgReconnectBaseDelay;
+    extern cfg_int*    gCfgReconnectMaxDelay;
+    extern cfg_int*    gCfgPingInterval;
+    extern cfg_int*    gCfgDeadPeerTimeout;
 }
 
 namespace foo_showplay {
@@ -35,11 +42,14 @@ class ShowPlayPreferences : public CDialogImpl<ShowPlayPreferences>, public pref
     const preferences_page_callback::ptr m_callback;
     
     auto OnInitDialog    (CWindow, LPARAM)    -> BOOL;
+    auto OnDestroy       ()                   -> void;
+    auto OnTimer         (UINT_PTR)           -> void;
     auto OnEditChange    (UINT, int, CWindow) -> void;
     auto HasChanged () -> bool;
     auto OnChanged  () -> void;
 
     auto UpdateConnectionStatus () -> void;
+    auto UpdateMetrics          () -> void;
 
 public:
     // Constructor - invoked by preferences_page_impl helpers - don't do Create() in here,
@@ -53,9 +63,9 @@ public:
     // The host ensures that our dialog is destroyed first, then the last reference to
     // our preferences_page_instance object is released, causing our object to be deleted.
 
-    auto UpdateStatus (bool isConnected) -> void
+    auto UpdateStatus (const std::string& status) -> void
     {
-        uSetDlgItemText(*this, IDC_STATUS, isConnected ? "Connected" : "Disconnected");
+        uSetDlgItemText(*this, IDC_STATUS, status.c_str());
     }
 
     auto UpdateToken (std::optional<std::string> token) -> void
@@ -74,7 +84,16 @@ public:
     //WTL message map
     BEGIN_MSG_MAP_EX(ShowPlayPreferences)
         MSG_WM_INITDIALOG(OnInitDialog)
+        MSG_WM_DESTROY(OnDestroy)
+        MSG_WM_TIMER(OnTimer)
         COMMAND_HANDLER_EX(IDC_SERVER_URL, EN_CHANGE, OnEditChange)
+        COMMAND_HANDLER_EX(IDC_COVER_MAX_EDGE, EN_CHANGE, OnEditChange)
+        COMMAND_HANDLER_EX(IDC_COVER_MAX_BYTES, EN_CHANGE, OnEditChange)
+        COMMAND_HANDLER_EX(IDC_MAX_SEND_RATE, EN_CHANGE, OnEditChange)
+        COMMAND_HANDLER_EX(IDC_RECONNECT_BASE_DELAY, EN_CHANGE, OnEditChange)
+        COMMAND_HANDLER_EX(IDC_RECONNECT_MAX_DELAY, EN_CHANGE, OnEditChange)
+        COMMAND_HANDLER_EX(IDC_PING_INTERVAL, EN_CHANGE, OnEditChange)
+        COMMAND_HANDLER_EX(IDC_DEAD_PEER_TIMEOUT, EN_CHANGE, OnEditChange)
     END_MSG_MAP()
 };
 
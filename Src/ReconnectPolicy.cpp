@@ -0,0 +1,81 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "ReconnectPolicy.hpp"
+
+#include <algorithm>
+
+namespace foo_showplay {
+
+ReconnectPolicy::ReconnectPolicy(ReconnectSettings settings, std::uint64_t seed)
+    : mSettings (settings)
+    , mFailures (0)
+    , mState    (CircuitState::Closed)
+    , mRandom   (seed)
+{
+}
+
+auto ReconnectPolicy::Uniform(std::chrono::milliseconds low, std::chrono::milliseconds high) -> std::chrono::milliseconds
+{
+    auto distribution = std::uniform_int_distribution<std::int64_t>(low.count(), std::max(low, high).count());
+    return std::chrono::milliseconds(distribution(mRandom));
+}
+
+auto ReconnectPolicy::OnFailure() -> std::chrono::milliseconds
+{
+    mFailures += 1;
+
+    // Probe failed or server keeps failing, stop hammering it.
+    if (mState == CircuitState::HalfOpen || mFailures >= mSettings.FailureThreshold)
+    {
+        mState = CircuitState::Open;
+    }
+
+    // Cool down is at least the cap, jittered over another cap.
+    if (mState == CircuitState::Open)
+    {
+        return mSettings.MaxDelay + Uniform(std::chrono::milliseconds(0), mSettings.MaxDelay);
+    }
+
+    // Window doubles with every failure, up to the cap.
+    auto window = mSettings.BaseDelay;
+    for (auto i = 1; i < mFailures && window < mSettings.MaxDelay; ++i)
+    {
+        window *= 2;
+    }
+
+    return Uniform(std::chrono::milliseconds(0), std::min(window, mSettings.MaxDelay));
+}
+
+auto ReconnectPolicy::OnAttempt() -> void
+{
+    if (mState == CircuitState::Open)
+    {
+        mState = CircuitState::HalfOpen;
+    }
+}
+
+auto ReconnectPolicy::OnSuccess() -> void
+{
+    mFailures = 0;
+    mState    = CircuitState::Closed;
+}
+
+} // namespace foo_showplay
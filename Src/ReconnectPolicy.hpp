@@ -0,0 +1,99 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+namespace foo_showplay {
+
+// Dead peer is told by pongs that stop coming. Without pings silent server is
+// normal, so check is off. Timeout spans at least two pings, one pong late
+// doesn't drop connection.
+inline auto ClampDeadPeerTimeout(std::chrono::seconds pingInterval, std::chrono::seconds deadPeerTimeout) -> std::chrono::seconds
+{
+    if (pingInterval.count() <= 0 || deadPeerTimeout.count() <= 0)
+    {
+        return std::chrono::seconds(0);
+    }
+
+    return std::max(deadPeerTimeout, 2 * pingInterval);
+}
+
+struct ReconnectSettings
+{
+    std::chrono::milliseconds BaseDelay;       // Backoff window after first failure.
+    std::chrono::milliseconds MaxDelay;        // Backoff window cap, also circuit cool down.
+    std::chrono::seconds      PingInterval;    // 0 disables pings.
+    std::chrono::seconds      DeadPeerTimeout; // Silence after which connection is dropped, 0 disables. Needs pings.
+    int                       FailureThreshold; // Consecutive failures that open circuit.
+
+    ReconnectSettings(
+        std::chrono::milliseconds baseDelay,
+        std::chrono::milliseconds maxDelay,
+        std::chrono::seconds      pingInterval,
+        std::chrono::seconds      deadPeerTimeout,
+        int                       failureThreshold
+    )
+        : BaseDelay        (baseDelay)
+        , MaxDelay         (std::max(baseDelay, maxDelay))
+        , PingInterval     (pingInterval)
+        , DeadPeerTimeout  (ClampDeadPeerTimeout(pingInterval, deadPeerTimeout))
+        , FailureThreshold (failureThreshold)
+    {
+    }
+};
+
+enum class CircuitState
+{
+    Closed,   // Retrying with backoff.
+    Open,     // Server looks down, waiting out cool down.
+    HalfOpen, // Single probe attempt after cool down.
+};
+
+// Decides when to reconnect. Delay is drawn from whole backoff window (full
+// jitter), so clients that lost the same server don't come back in lockstep.
+class ReconnectPolicy
+{
+    ReconnectSettings mSettings;
+    int               mFailures; // Consecutive, reset by success.
+    CircuitState      mState;
+    std::mt19937_64   mRandom;
+
+    auto Uniform (std::chrono::milliseconds low, std::chrono::milliseconds high) -> std::chrono::milliseconds;
+
+public:
+    ReconnectPolicy(ReconnectSettings settings, std::uint64_t seed);
+
+    auto SetSettings (ReconnectSettings settings) -> void { mSettings = settings; }
+    auto GetSettings () const -> const ReconnectSettings& { return mSettings; }
+
+    // Attempt failed or connection was lost, returns delay before next one.
+    auto OnFailure () -> std::chrono::milliseconds;
+    auto OnAttempt () -> void;
+    auto OnSuccess () -> void;
+
+    auto GetState    () const -> CircuitState { return mState;    }
+    auto GetFailures () const -> int          { return mFailures; }
+};
+
+} // namespace foo_showplay
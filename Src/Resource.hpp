@@ -25,6 +25,14 @@
 #define IDC_SERVER_URL                  1001
 #define IDC_STATUS                      1002
 #define IDC_TOKEN                       1003
+#define IDC_COVER_MAX_EDGE              1004
+#define IDC_COVER_MAX_BYTES             1005
+#define IDC_MAX_SEND_RATE               1006
+#define IDC_RECONNECT_BASE_DELAY        1007
+#define IDC_RECONNECT_MAX_DELAY         1008
+#define IDC_PING_INTERVAL               1009
+#define IDC_DEAD_PEER_TIMEOUT           1010
+#define IDC_METRICS                     1011
 
 // Next default values for new objects
 // 
@@ -32,7 +40,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        101
 #define _APS_NEXT_COMMAND_VALUE         40001
-#define _APS_NEXT_CONTROL_VALUE         1004
+#define _APS_NEXT_CONTROL_VALUE         1012
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif
@@ -0,0 +1,284 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "Serializer.hpp"
+#include "Base64.hpp"
+
+#include <charconv>
+#include <cmath>
+
+namespace foo_showplay {
+
+auto BinaryData::EncodeBase64() -> void
+{
+    if (Base64 == nullptr)
+    {
+        auto encoded = std::string();
+        Base64Append(Data.get(), Size, encoded);
+
+        Base64 = std::make_shared<const std::string>(std::move(encoded));
+    }
+}
+
+auto to_json(nlohmann::json& json, const BinaryData& data) -> void
+{
+    if (data.Base64 != nullptr)
+    {
+        json = *data.Base64;
+    }
+    else
+    {
+        auto encoded = std::string();
+        Base64Append(data.Data.get(), data.Size, encoded);
+
+        json = std::move(encoded);
+    }
+}
+
+auto from_json(const nlohmann::json& json, BinaryData& data) -> void
+{
+    auto decoded = std::make_shared<std::string>(base64_decode(json.get<std::string>()));
+    auto bytes   = reinterpret_cast<const std::uint8_t*>(decoded->data());
+
+    data = BinaryData(std::shared_ptr<const std::uint8_t>(decoded, bytes), decoded->size());
+}
+
+// -------------------------------------------------------------------------- //
+
+// Shortest form that reads back the same, with ".0" for integers and the
+// same exponent thresholds as nlohmann::json. Only use of nlohmann internals
+// in writer, serializer test checks output against dump.
+static auto FormatNumber(char* first, char* last, double value) -> char*
+{
+    return nlohmann::detail::to_chars(first, last, value);
+}
+
+// Length of UTF-8 sequence starting with non-ASCII byte. Invalid sequence is
+// its lead byte and the continuation bytes that were valid, nlohmann::json
+// replaces it as a whole and decodes the offending byte again.
+static auto ScanUtf8(std::string_view text, bool& isValid) -> std::size_t
+{
+    auto lead   = static_cast<unsigned char>(text[0]);
+    auto length = std::size_t(0);
+    auto low    = 0x80; // Bounds of second byte, the rest are 80..BF.
+    auto high   = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF)
+    {
+        length = 2;
+    }
+    else if (lead >= 0xE0 && lead <= 0xEF)
+    {
+        length = 3;
+        low    = lead == 0xE0 ? 0xA0 : low;  // Overlong.
+        high   = lead == 0xED ? 0x9F : high; // Surrogates.
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4)
+    {
+        length = 4;
+        low    = lead == 0xF0 ? 0x90 : low;  // Overlong.
+        high   = lead == 0xF4 ? 0x8F : high; // Above U+10FFFF.
+    }
+    else
+    {
+        isValid = false;
+        return 1;
+    }
+
+    for (auto i = std::size_t(1); i < length; ++i)
+    {
+        auto c = i < text.size() ? static_cast<unsigned char>(text[i]) : 0;
+        if (c < (i == 1 ? low : 0x80) || c > (i == 1 ? high : 0xBF))
+        {
+            isValid = false;
+            return i;
+        }
+    }
+
+    isValid = true;
+    return length;
+}
+
+auto JsonWriter::Integer(std::int64_t value) -> void
+{
+    char buffer[24];
+    auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+    mBuffer.append(buffer, end);
+}
+
+auto JsonWriter::Number(double value) -> void
+{
+    // nlohmann::json dumps NaN and infinity as null.
+    if (!std::isfinite(value))
+    {
+        Null();
+        return;
+    }
+
+    char buffer[64];
+    auto end = FormatNumber(buffer, buffer + sizeof(buffer), value);
+
+    mBuffer.append(buffer, end);
+}
+
+auto JsonWriter::String(std::string_view value) -> void
+{
+    static constexpr char hex[] = "0123456789abcdef";
+
+    mBuffer.push_back('"');
+
+    // Copy runs of characters that don't need escaping at once.
+    auto runStart = std::size_t(0);
+    for (auto i = std::size_t(0); i < value.size(); ++i)
+    {
+        auto c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x80)
+        {
+            auto isValid = false;
+            auto length  = ScanUtf8(value.substr(i), isValid);
+            if (!isValid)
+            {
+                mBuffer.append(value.data() + runStart, i - runStart);
+                mBuffer.append("\xEF\xBF\xBD");
+                runStart = i + length;
+            }
+
+            i += length - 1;
+            continue;
+        }
+
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+
+        mBuffer.append(value.data() + runStart, i - runStart);
+        runStart = i + 1;
+
+        switch (c)
+        {
+        case '"':  mBuffer.append("\\\""); break;
+        case '\\': mBuffer.append("\\\\"); break;
+        case '\b': mBuffer.append("\\b");  break;
+        case '\f': mBuffer.append("\\f");  break;
+        case '\n': mBuffer.append("\\n");  break;
+        case '\r': mBuffer.append("\\r");  break;
+        case '\t': mBuffer.append("\\t");  break;
+        default:
+            mBuffer.append("\\u00");
+            mBuffer.push_back(hex[c >> 4]);
+            mBuffer.push_back(hex[c & 0xF]);
+            break;
+        }
+    }
+
+    mBuffer.append(value.data() + runStart, value.size() - runStart);
+    mBuffer.push_back('"');
+}
+
+auto JsonWriter::Binary(const BinaryData& value) -> void
+{
+    mBuffer.push_back('"');
+    if (value.Base64 != nullptr)
+    {
+        mBuffer.append(*value.Base64);
+    }
+    else
+    {
+        Base64Append(value.Data.get(), value.Size, mBuffer);
+    }
+    mBuffer.push_back('"');
+}
+
+// -------------------------------------------------------------------------- //
+
+auto CborWriter::Head(std::uint8_t majorType, std::uint64_t value) -> void
+{
+    // Shortest encoding of argument, big endian.
+    auto type = static_cast<std::uint8_t>(majorType << 5);
+    auto size = 0;
+    if (value < 24)
+    {
+        mBuffer.push_back(static_cast<char>(type | value));
+    }
+    else if (value <= 0xFF)
+    {
+        mBuffer.push_back(static_cast<char>(type | 24));
+        size = 1;
+    }
+    else if (value <= 0xFFFF)
+    {
+        mBuffer.push_back(static_cast<char>(type | 25));
+        size = 2;
+    }
+    else if (value <= 0xFFFFFFFF)
+    {
+        mBuffer.push_back(static_cast<char>(type | 26));
+        size = 4;
+    }
+    else
+    {
+        mBuffer.push_back(static_cast<char>(type | 27));
+        size = 8;
+    }
+
+    for (auto i = size - 1; i >= 0; --i)
+    {
+        mBuffer.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+auto CborWriter::Integer(std::int64_t value) -> void
+{
+    if (value >= 0)
+    {
+        Head(0, static_cast<std::uint64_t>(value));
+    }
+    else
+    {
+        Head(1, static_cast<std::uint64_t>(-(value + 1)));
+    }
+}
+
+auto CborWriter::Number(double value) -> void
+{
+    auto bits = std::uint64_t(0);
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    mBuffer.push_back(static_cast<char>(0xFB));
+    for (auto i = 7; i >= 0; --i)
+    {
+        mBuffer.push_back(static_cast<char>((bits >> (i * 8)) & 0xFF));
+    }
+}
+
+auto CborWriter::String(std::string_view value) -> void
+{
+    Head(3, value.size());
+    mBuffer.append(value.data(), value.size());
+}
+
+auto CborWriter::Binary(const BinaryData& value) -> void
+{
+    Head(2, value.Size);
+    mBuffer.append(reinterpret_cast<const char*>(value.Data.get()), value.Size);
+}
+
+} // namespace foo_showplay
@@ -0,0 +1,403 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Defines nlohmann to_json/from_json and compile-time field table from one
+// field list. Fields must be listed in alphabetical order, the same order
+// nlohmann::json uses when dumping objects.
+#define SHOWPLAY_FIELD_NAME(field) #field,
+#define SHOWPLAY_FIELD_VISIT(field) visitor(#field, &Self::field);
+
+#define SHOWPLAY_DEFINE_TYPE(Type, ...)                                                          \
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(Type, __VA_ARGS__)                                            \
+                                                                                                 \
+    static constexpr std::string_view FieldNames[] = {                                           \
+        NLOHMANN_JSON_EXPAND(NLOHMANN_JSON_PASTE(SHOWPLAY_FIELD_NAME, __VA_ARGS__))              \
+    };                                                                                           \
+    static constexpr auto FieldCount = std::size(FieldNames);                                    \
+                                                                                                 \
+    static_assert(::foo_showplay::IsSortedFieldTable(FieldNames), #Type " fields are not sorted"); \
+    static_assert(FieldCount <= 32, #Type " has too many fields for FieldMask");                 \
+                                                                                                 \
+    template <typename Visitor>                                                                  \
+    static constexpr auto VisitFields(Visitor&& visitor) -> void                                 \
+    {                                                                                            \
+        using Self = Type;                                                                       \
+        NLOHMANN_JSON_EXPAND(NLOHMANN_JSON_PASTE(SHOWPLAY_FIELD_VISIT, __VA_ARGS__))             \
+    }
+
+namespace foo_showplay {
+
+// -------------------------------------------------------------------------- //
+
+template <std::size_t N>
+constexpr auto IsSortedFieldTable(const std::string_view (&names)[N]) -> bool
+{
+    for (auto i = std::size_t(1); i < N; ++i)
+    {
+        if (!(names[i - 1] < names[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Index of field in field table, usable in constant expressions.
+template <std::size_t N>
+constexpr auto FieldIndex(const std::string_view (&names)[N], std::string_view name) -> std::size_t
+{
+    for (auto i = std::size_t(0); i < N; ++i)
+    {
+        if (names[i] == name)
+        {
+            return i;
+        }
+    }
+
+    return N;
+}
+
+template <typename T, typename = void>
+struct HasFieldTable : std::false_type {};
+
+template <typename T>
+struct HasFieldTable<T, std::void_t<decltype(T::FieldNames)>> : std::true_type {};
+
+// Raw bytes shared instead of copied, e.g. album art owned by foobar2000.
+// Written as base64 string in JSON and as byte string in CBOR.
+struct BinaryData
+{
+    std::shared_ptr<const std::uint8_t> Data;
+    std::size_t                         Size;
+    std::shared_ptr<const std::string>  Base64; // Optional, already encoded Data.
+
+    BinaryData()
+        : Data   (nullptr)
+        , Size   (0)
+        , Base64 (nullptr)
+    {
+    }
+
+    BinaryData(std::shared_ptr<const std::uint8_t> data, std::size_t size)
+        : Data   (std::move(data))
+        , Size   (size)
+        , Base64 (nullptr)
+    {
+    }
+
+    // Encodes Data once, copies of this BinaryData share the result.
+    auto EncodeBase64 () -> void;
+
+    auto operator== (const BinaryData& other) const -> bool
+    {
+        if (Size != other.Size)
+        {
+            return false;
+        }
+
+        return Data == other.Data || Size == 0 || std::memcmp(Data.get(), other.Data.get(), Size) == 0;
+    }
+};
+
+auto to_json   (nlohmann::json& json, const BinaryData& data) -> void;
+auto from_json (const nlohmann::json& json, BinaryData& data) -> void;
+
+// Bit per field, in field table order.
+using FieldMask = std::uint32_t;
+
+inline constexpr auto ALL_FIELDS = ~FieldMask(0);
+
+template <typename T>
+struct FieldMasks
+{
+    FieldMask Fields[T::FieldCount] = {};
+};
+
+// Returns mask of fields that differ between two versions of struct.
+template <typename T>
+auto DiffFields(const std::optional<T>& before, const std::optional<T>& after) -> FieldMask
+{
+    if (!before.has_value() && !after.has_value())
+    {
+        return 0;
+    }
+
+    if (!before.has_value() || !after.has_value())
+    {
+        return ALL_FIELDS;
+    }
+
+    auto mask  = FieldMask(0);
+    auto index = 0;
+    T::VisitFields([&](const char*, auto member)
+    {
+        if (!(before.value().*member == after.value().*member))
+        {
+            mask |= FieldMask(1) << index;
+        }
+        index += 1;
+    });
+
+    return mask;
+}
+
+// -------------------------------------------------------------------------- //
+
+enum class FrameFormat
+{
+    Json,
+    Cbor,
+};
+
+// Writes compact JSON into reused buffer, formatted the same way as
+// nlohmann::json::dump does. Invalid UTF-8, on which dump would throw, is
+// replaced with U+FFFD the way dump does with error_handler_t::replace.
+class JsonWriter
+{
+    std::string& mBuffer;
+    bool         mIsFirst;
+
+public:
+    static constexpr auto Format = FrameFormat::Json;
+
+    JsonWriter(std::string& buffer)
+        : mBuffer  (buffer)
+        , mIsFirst (true)
+    {
+    }
+
+    auto BeginObject () -> void { mBuffer.push_back('{'); mIsFirst = true;  }
+    auto EndObject   () -> void { mBuffer.push_back('}'); mIsFirst = false; }
+    auto BeginArray  () -> void { mBuffer.push_back('['); mIsFirst = true;  }
+    auto EndArray    () -> void { mBuffer.push_back(']'); mIsFirst = false; }
+
+    // Before every array element.
+    auto Element () -> void
+    {
+        if (!mIsFirst)
+        {
+            mBuffer.push_back(',');
+        }
+
+        mIsFirst = false;
+    }
+
+    auto Key (std::string_view key) -> void
+    {
+        if (!mIsFirst)
+        {
+            mBuffer.push_back(',');
+        }
+
+        mIsFirst = false;
+        String(key);
+        mBuffer.push_back(':');
+    }
+
+    auto Null    ()                         -> void { mBuffer.append("null"); }
+    auto Boolean (bool value)               -> void { mBuffer.append(value ? "true" : "false"); }
+    auto Integer (std::int64_t value)       -> void;
+    auto Number  (double value)             -> void;
+    auto String  (std::string_view value)   -> void;
+    auto Binary  (const BinaryData& value)  -> void;
+
+    // Value already written by JsonWriter.
+    auto Raw     (std::string_view value)   -> void { mBuffer.append(value.data(), value.size()); }
+};
+
+// Writes CBOR (RFC 8949) into reused buffer. Objects are indefinite-length
+// maps, so masked fields don't have to be counted upfront.
+class CborWriter
+{
+    std::string& mBuffer;
+
+    auto Head (std::uint8_t majorType, std::uint64_t value) -> void;
+
+public:
+    static constexpr auto Format = FrameFormat::Cbor;
+
+    CborWriter(std::string& buffer)
+        : mBuffer (buffer)
+    {
+    }
+
+    auto BeginObject () -> void { mBuffer.push_back(static_cast<char>(0xBF)); }
+    auto EndObject   () -> void { mBuffer.push_back(static_cast<char>(0xFF)); }
+    auto BeginArray  () -> void { mBuffer.push_back(static_cast<char>(0x9F)); }
+    auto EndArray    () -> void { mBuffer.push_back(static_cast<char>(0xFF)); }
+    auto Element     () -> void {}
+
+    auto Key     (std::string_view key)     -> void { String(key); }
+    auto Null    ()                         -> void { mBuffer.push_back(static_cast<char>(0xF6)); }
+    auto Boolean (bool value)               -> void { mBuffer.push_back(static_cast<char>(value ? 0xF5 : 0xF4)); }
+    auto Integer (std::int64_t value)       -> void;
+    auto Number  (double value)             -> void;
+    auto String  (std::string_view value)   -> void;
+    auto Binary  (const BinaryData& value)  -> void;
+
+    // Value already written by CborWriter.
+    auto Raw     (std::string_view value)   -> void { mBuffer.append(value.data(), value.size()); }
+};
+
+// -------------------------------------------------------------------------- //
+
+template <typename Writer, typename T>
+auto WriteObject (Writer& writer, const T& value, FieldMask mask = ALL_FIELDS) -> void;
+
+template <typename Writer, typename T>
+auto WriteValue(Writer& writer, const T& value) -> void
+{
+    if constexpr (HasFieldTable<T>::value)
+    {
+        WriteObject(writer, value);
+    }
+    else if constexpr (std::is_same_v<T, BinaryData>)
+    {
+        writer.Binary(value);
+    }
+    else if constexpr (std::is_enum_v<T>)
+    {
+        writer.Integer(static_cast<std::int64_t>(value));
+    }
+    else if constexpr (std::is_same_v<T, bool>)
+    {
+        writer.Boolean(value);
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+        writer.Integer(static_cast<std::int64_t>(value));
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+        writer.Number(static_cast<double>(value));
+    }
+    else
+    {
+        writer.String(value);
+    }
+}
+
+template <typename Writer, typename T>
+auto WriteValue(Writer& writer, const std::vector<T>& values) -> void
+{
+    writer.BeginArray();
+    for (const auto& value : values)
+    {
+        writer.Element();
+        WriteValue(writer, value);
+    }
+    writer.EndArray();
+}
+
+template <typename Writer, typename T>
+auto WriteValue(Writer& writer, const std::optional<T>& value) -> void
+{
+    if (value.has_value())
+    {
+        WriteValue(writer, value.value());
+    }
+    else
+    {
+        writer.Null();
+    }
+}
+
+// Writes fields selected by mask, whose names are in range [first, last).
+template <typename Writer, typename T>
+auto WriteFields(
+    Writer&          writer,
+    const T&         value,
+    FieldMask        mask,
+    std::string_view first,
+    std::string_view last
+) -> void
+{
+    auto index = 0;
+    T::VisitFields([&](const char* name, auto member)
+    {
+        auto isSelected = (mask & (FieldMask(1) << index)) != 0;
+        auto isInRange  = first <= name && (last.empty() || name < last);
+        if (isSelected && isInRange)
+        {
+            writer.Key(name);
+            WriteValue(writer, value.*member);
+        }
+        index += 1;
+    });
+}
+
+template <typename Writer, typename T>
+auto WriteObject(Writer& writer, const T& value, FieldMask mask) -> void
+{
+    writer.BeginObject();
+    WriteFields(writer, value, mask, "", "");
+    writer.EndObject();
+}
+
+// Same as WriteFields but for struct made of optional sections, writes only
+// sections with non-empty mask and only selected fields of each section.
+template <typename Writer, typename T>
+auto WriteSections(
+    Writer&              writer,
+    const T&             value,
+    const FieldMasks<T>& masks,
+    std::string_view     first,
+    std::string_view     last
+) -> void
+{
+    auto index = 0;
+    T::VisitFields([&](const char* name, auto member)
+    {
+        auto mask      = masks.Fields[index];
+        auto isInRange = first <= name && (last.empty() || name < last);
+        if (mask != 0 && isInRange)
+        {
+            const auto& section = value.*member;
+
+            writer.Key(name);
+            if (section.has_value())
+            {
+                WriteObject(writer, section.value(), mask);
+            }
+            else
+            {
+                writer.Null();
+            }
+        }
+        index += 1;
+    });
+}
+
+// -------------------------------------------------------------------------- //
+
+} // namespace foo_showplay
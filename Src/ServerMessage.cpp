@@ -0,0 +1,297 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "ServerMessage.hpp"
+#include "Constants.hpp"
+#include "WebSocket.hpp"
+
+#include <nlohmann/json.hpp>
+
+namespace foo_showplay {
+
+namespace {
+
+class ServerMessageSax
+{
+    using json = nlohmann::json;
+
+    enum class Key
+    {
+        Other,
+        Token,
+        Features,
+        Request,
+        Hash,
+        Schema,
+        Ack,
+        Time,
+        TimeUs,
+    };
+
+    enum class FieldKey
+    {
+        Other,
+        Name,
+        Expression,
+        Type,
+    };
+
+    ServerMessage& mMessage;
+    int            mDepth;
+    Key            mKey;            // Last key of top level object.
+    bool           mIsFeatureArray; // Inside Features array.
+    bool           mIsSchemaArray;  // Inside Schema array.
+    FieldKey       mFieldKey;       // Last key of schema field object.
+    SchemaField    mField;          // Schema field being parsed.
+    bool           mIsFieldValid;
+
+    auto Value () -> void
+    {
+        // Top level value other than string, e.g. Token: null.
+        if (mDepth == 1)
+        {
+            mKey = Key::Other;
+        }
+    }
+
+    auto Integer (std::int64_t value) -> void
+    {
+        if (mDepth == 1)
+        {
+            switch (mKey)
+            {
+            case Key::Ack:    mMessage.Ack    = static_cast<int>(value); break;
+            case Key::Time:   mMessage.Time   = value; break;
+            case Key::TimeUs: mMessage.TimeUs = value; break;
+            default: break;
+            }
+        }
+
+        Value();
+    }
+
+    static auto ParseFeature (std::string_view feature) -> unsigned
+    {
+        if (feature == FEATURE_DELTA)           return static_cast<unsigned>(ServerFeature::Delta);
+        if (feature == FEATURE_CBOR)            return static_cast<unsigned>(ServerFeature::Cbor);
+        if (feature == FEATURE_COVER_HASH)      return static_cast<unsigned>(ServerFeature::CoverHash);
+        if (feature == FEATURE_BINARY_COVER)    return static_cast<unsigned>(ServerFeature::BinaryCover);
+        if (feature == FEATURE_ANCHOR)          return static_cast<unsigned>(ServerFeature::Anchor);
+        if (feature == FEATURE_DEFLATE)         return static_cast<unsigned>(ServerFeature::Deflate);
+        if (feature == FEATURE_SONG_DICTIONARY) return static_cast<unsigned>(ServerFeature::SongDictionary);
+        if (feature == FEATURE_STATS)           return static_cast<unsigned>(ServerFeature::Stats);
+        if (feature == FEATURE_ACK)             return static_cast<unsigned>(ServerFeature::Ack);
+        if (feature == FEATURE_SYNC)            return static_cast<unsigned>(ServerFeature::Sync);
+
+        // Unknown features are ignored.
+        return 0;
+    }
+
+public:
+    ServerMessageSax(ServerMessage& message)
+        : mMessage        (message)
+        , mDepth          (0)
+        , mKey            (Key::Other)
+        , mIsFeatureArray (false)
+        , mIsSchemaArray  (false)
+        , mFieldKey       (FieldKey::Other)
+        , mIsFieldValid   (false)
+    {
+    }
+
+    auto null            ()                                    -> bool { Value(); return true; }
+    auto boolean         (bool)                                -> bool { Value(); return true; }
+    auto number_integer  (json::number_integer_t value)        -> bool { Integer(value); return true; }
+    auto number_unsigned (json::number_unsigned_t value)       -> bool { Integer(static_cast<std::int64_t>(value)); return true; }
+    auto number_float    (json::number_float_t, const json::string_t&) -> bool { Value(); return true; }
+    auto binary          (json::binary_t&)                     -> bool { Value(); return true; }
+
+    auto string (json::string_t& value) -> bool
+    {
+        if (mDepth == 1)
+        {
+            switch (mKey)
+            {
+            case Key::Token:
+                // Server may compare token byte for byte, so it's echoed as
+                // sent and parsed only to validate it.
+                mMessage.Token = ParseUuid(value);
+                if (mMessage.Token.has_value())
+                {
+                    mMessage.TokenText = std::move(value);
+                }
+                break;
+            case Key::Request: mMessage.Request = std::move(value); break;
+            case Key::Hash:    mMessage.Hash    = std::move(value); break;
+            default: break;
+            }
+
+            mKey = Key::Other;
+        }
+        else if (mDepth == 2 && mIsFeatureArray)
+        {
+            mMessage.Features |= ParseFeature(value);
+        }
+        else if (mDepth == 3 && mIsSchemaArray)
+        {
+            switch (mFieldKey)
+            {
+            case FieldKey::Name:       mField.Name       = std::move(value); break;
+            case FieldKey::Expression: mField.Expression = std::move(value); break;
+            case FieldKey::Type:
+            {
+                auto type = ParseFieldType(value);
+                mField.Type   = type.value_or(FieldType::String);
+                mIsFieldValid = mIsFieldValid && type.has_value();
+                break;
+            }
+            default: break;
+            }
+        }
+
+        return true;
+    }
+
+    auto key (json::string_t& value) -> bool
+    {
+        if (mDepth == 3 && mIsSchemaArray)
+        {
+            if      (value == "Name")       mFieldKey = FieldKey::Name;
+            else if (value == "Expression") mFieldKey = FieldKey::Expression;
+            else if (value == "Type")       mFieldKey = FieldKey::Type;
+            else                            mFieldKey = FieldKey::Other;
+        }
+
+        if (mDepth != 1)
+        {
+            return true;
+        }
+
+        if      (value == "Token")    mKey = Key::Token;
+        else if (value == "Features") mKey = Key::Features;
+        else if (value == "Request")  mKey = Key::Request;
+        else if (value == "Hash")     mKey = Key::Hash;
+        else if (value == "Schema")   mKey = Key::Schema;
+        else if (value == "Ack")      mKey = Key::Ack;
+        else if (value == "Time")     mKey = Key::Time;
+        else if (value == "TimeUs")   mKey = Key::TimeUs;
+        else                          mKey = Key::Other;
+
+        if (mKey == Key::Token)
+        {
+            mMessage.HasToken = true;
+        }
+
+        return true;
+    }
+
+    auto start_object (std::size_t) -> bool
+    {
+        // Only object is valid message.
+        if (mDepth == 0)
+        {
+            mMessage.IsObject = true;
+        }
+
+        // New schema field.
+        if (mDepth == 2 && mIsSchemaArray)
+        {
+            mField        = SchemaField();
+            mFieldKey     = FieldKey::Other;
+            mIsFieldValid = true;
+        }
+
+        Value();
+        mDepth += 1;
+        return true;
+    }
+
+    auto end_object () -> bool
+    {
+        mDepth -= 1;
+
+        // Each field has bit in FieldMask, the rest is ignored.
+        if (mDepth == 2 && mIsSchemaArray)
+        {
+            auto& schema = mMessage.Schema.value();
+            if (mIsFieldValid && !mField.Name.empty() && !mField.Expression.empty() && schema.size() < SCHEMA_SIZE)
+            {
+                schema.push_back(std::move(mField));
+            }
+        }
+        return true;
+    }
+
+    auto start_array (std::size_t) -> bool
+    {
+        if (mDepth == 1)
+        {
+            mIsFeatureArray = mKey == Key::Features;
+            mIsSchemaArray  = mKey == Key::Schema;
+            if (mIsSchemaArray)
+            {
+                mMessage.Schema = FieldSchema();
+            }
+        }
+
+        Value();
+        mDepth += 1;
+        return true;
+    }
+
+    auto end_array () -> bool
+    {
+        mDepth -= 1;
+        if (mDepth == 1)
+        {
+            mIsFeatureArray = false;
+            mIsSchemaArray  = false;
+        }
+        return true;
+    }
+
+    auto parse_error (std::size_t, const std::string&, const nlohmann::detail::exception&) -> bool
+    {
+        return false;
+    }
+};
+
+} // namespace
+
+auto ParseServerMessage(std::string_view text) -> ServerMessage
+{
+    auto message = ServerMessage();
+    auto sax     = ServerMessageSax(message);
+
+    // Malformed message is ignored as whole.
+    if (!nlohmann::json::sax_parse(text.data(), text.data() + text.size(), &sax))
+    {
+        return ServerMessage();
+    }
+
+    if (message.Schema.has_value())
+    {
+        message.Schema = NormalizeSchema(std::move(message.Schema.value()));
+    }
+
+    return message;
+}
+
+} // namespace foo_showplay
@@ -0,0 +1,67 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "FieldSchema.hpp"
+#include "Uuid.hpp"
+
+namespace foo_showplay {
+
+// Fields of message received from server that client cares about.
+struct ServerMessage
+{
+    bool                        IsObject; // Valid JSON object.
+    bool                        HasToken; // Token key is present, even if invalid.
+    std::optional<Uuid>         Token;
+    std::optional<std::string>  TokenText; // Token exactly as sent, set only if it parsed.
+    unsigned                    Features; // ServerFeature bits.
+    std::optional<std::string>  Request;
+    std::optional<std::string>  Hash;
+    std::optional<FieldSchema>  Schema; // Fields with unknown type are skipped.
+    std::optional<int>          Ack;    // Frame server acknowledges.
+    std::optional<std::int64_t> Time;   // Unix milliseconds when server received acknowledged frame.
+    std::optional<std::int64_t> TimeUs; // Same in microseconds, sent by newer servers.
+
+    ServerMessage()
+        : IsObject  (false)
+        , HasToken  (false)
+        , Token     (std::nullopt)
+        , TokenText (std::nullopt)
+        , Features  (0)
+        , Request   (std::nullopt)
+        , Hash      (std::nullopt)
+        , Schema    (std::nullopt)
+        , Ack       (std::nullopt)
+        , Time      (std::nullopt)
+        , TimeUs    (std::nullopt)
+    {
+    }
+};
+
+// Extracts known keys with SAX parser, without building JSON document.
+// Unknown keys and nested values are skipped.
+auto ParseServerMessage (std::string_view text) -> ServerMessage;
+
+} // namespace foo_showplay
@@ -0,0 +1,734 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "Session.hpp"
+#include "Constants.hpp"
+#include "Hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace foo_showplay {
+
+// Splits ';' separated list, empty entries and whitespace are skipped.
+static auto SplitServerUrls(std::string_view urls) -> std::vector<std::string>
+{
+    static constexpr auto whitespace = std::string_view(" \t\r\n");
+
+    auto result = std::vector<std::string>();
+    while (!urls.empty())
+    {
+        auto end = std::min(urls.find(';'), urls.size());
+        auto url = urls.substr(0, end);
+        urls.remove_prefix(std::min(end + 1, urls.size()));
+
+        auto first = url.find_first_not_of(whitespace);
+        if (first == std::string_view::npos)
+        {
+            continue;
+        }
+
+        auto last = url.find_last_not_of(whitespace);
+        result.emplace_back(url.substr(first, last - first + 1));
+    }
+
+    return result;
+}
+
+ShowPlaySession::ShowPlaySession(
+    Player&                       player,
+    Host&                         host,
+    CoverTranscoder::CodecFactory codecFactory,
+    ReconnectSettings             reconnectSettings
+)
+    : mPlayer              (player)
+    , mHost                (host)
+    , mIsFlushTimerStarted (false)
+    , mCoverCache          (COVER_CACHE_SIZE)
+    , mCoverTranscoder     (std::move(codecFactory))
+    , mReconnectSettings   (reconnectSettings)
+    , mPendingCover        (std::nullopt)
+    , mIsCoverCached       (false)
+    , mAnchor              (std::nullopt)
+    , mNextStats           ()
+{
+    // Register callbacks.
+    mCoverTranscoder.SetOnTranscodedCallback([this](std::uint64_t hash, BinaryData image) { InMainThreadOnCoverTranscoded (hash, std::move(image)); });
+}
+
+ShowPlaySession::~ShowPlaySession()
+{
+    StopFlushTimer();
+}
+
+auto ShowPlaySession::OnNewTrack(std::optional<SongInfo> song, std::optional<CustomFields> fields) -> void
+{
+    // New track, remembered for servers that miss it.
+    if (song.has_value())
+    {
+        mStore.RecordTrack(song.value());
+    }
+
+    auto payload   = Payload(std::nullopt, std::nullopt, std::move(song), std::nullopt);
+    payload.Fields = std::move(fields);
+
+    SendPayload(std::move(payload));
+    SendPlaybackInfo();
+}
+
+auto ShowPlaySession::OnSongChanged() -> void
+{
+    SendSongInfo();
+}
+
+auto ShowPlaySession::OnStop() -> void
+{
+    SendPlaybackInfo(PlaybackState::Nothing, std::nullopt);
+}
+
+auto ShowPlaySession::OnSeek(double time) -> void
+{
+    // Anchor is whole state, position alone can't be extrapolated.
+    if (AnyEndpointHas(ServerFeature::Anchor))
+    {
+        SendPlaybackInfo();
+        return;
+    }
+
+    SendPlaybackInfo(time);
+}
+
+auto ShowPlaySession::OnPause(bool isPaused) -> void
+{
+    if (isPaused)
+    {
+        SendPlaybackInfo(PlaybackState::Paused, std::nullopt);
+    }
+    else
+    {
+        SendPlaybackInfo(PlaybackState::Playing, std::nullopt);
+    }
+}
+
+auto ShowPlaySession::OnTime(double time) -> void
+{
+    // Server extrapolates position from anchor, only drift is corrected.
+    if (AnyEndpointHas(ServerFeature::Anchor) && IsAnchorDrifted())
+    {
+        SendPlaybackInfo();
+        return;
+    }
+
+    // Per second updates for other servers, anchor ones drop them.
+    if (!AllEndpointsHave(ServerFeature::Anchor))
+    {
+        SendPlaybackInfo(time);
+    }
+
+    SendStats();
+}
+
+auto ShowPlaySession::OnAlbumArt() -> void
+{
+    SendCoverInfo();
+}
+
+auto ShowPlaySession::OnConnected(Endpoint&) -> void
+{
+    mHost.OnStatusChanged();
+}
+
+auto ShowPlaySession::OnDisconnected(Endpoint&) -> void
+{
+    mHost.OnStatusChanged();
+    UpdateSchema();
+}
+
+auto ShowPlaySession::OnActivated(Endpoint& endpoint) -> void
+{
+    mHost.OnStatusChanged();
+
+    // Connection phases, to tell slow DNS from slow server.
+    auto timings = endpoint.GetWebSocket().GetConnectTimings();
+    mHost.Log("ShowPlay: connected to " + endpoint.GetWebSocket().GetServerUrl() +
+              " (dns "        + std::to_string(timings.Dns.count() / 1000) +
+              " ms, connect " + std::to_string(timings.Connect.count() / 1000) +
+              " ms, activation " + std::to_string(timings.Activation.count() / 1000) + " ms)");
+
+    // Server doesn't know anything yet, other endpoints are already up to
+    // date and don't need the same state again.
+    SendSnapshot(endpoint);
+}
+
+auto ShowPlaySession::OnDeactivated(Endpoint&) -> void
+{
+    mHost.OnStatusChanged();
+    UpdateSchema();
+}
+
+auto ShowPlaySession::OnSnapshotRequest(Endpoint& endpoint) -> void
+{
+    SendSnapshot(endpoint);
+}
+
+auto ShowPlaySession::OnCoverRequest(Endpoint& endpoint, std::string hash) -> void
+{
+    // If endpoint is not active then skip sending.
+    if (!endpoint.GetWebSocket().IsActive())
+    {
+        return;
+    }
+
+    // Server doesn't have cover we referenced, send the bytes.
+    auto hashValue = HashFromString(hash);
+    auto cached    = hashValue.has_value() ? mCoverCache.Find(hashValue.value()) : nullptr;
+    if (cached == nullptr)
+    {
+        mHost.Log("ShowPlay: requested cover is no longer cached");
+        return;
+    }
+
+    if (endpoint.GetWebSocket().IsCoverBase64())
+    {
+        EncodeCover(cached->Image);
+    }
+
+    auto cover  = CoverInfo();
+    cover.Hash  = hash;
+    cover.Image = cached->Image;
+
+    // Only server that asked for it.
+    endpoint.GetSender().EnqueueReply(Payload(std::nullopt, std::nullopt, std::nullopt, cover));
+}
+
+auto ShowPlaySession::OnSchema(Endpoint&) -> void
+{
+    // Fields of the new schema weren't evaluated yet.
+    UpdateSchema();
+    SendFields();
+}
+
+auto ShowPlaySession::OnSenderOverflow(Endpoint& endpoint) -> void
+{
+    // Some payloads were dropped, server state is unknown.
+    SendSnapshot(endpoint);
+}
+
+auto ShowPlaySession::OnCoverTranscoded(std::uint64_t hash, BinaryData image) -> void
+{
+    mCoverCache.Insert(hash, std::move(image));
+
+    // Send it if it's still current cover.
+    if (mPendingCover == hash)
+    {
+        SendCoverInfo();
+    }
+}
+
+auto ShowPlaySession::GetPlayerInfo() -> std::optional<PlayerInfo>
+{
+    auto player = PlayerInfo();
+    player.Name = mPlayer.GetName();
+    return player;
+}
+
+auto ShowPlaySession::GetPlaybackInfo() -> std::optional<PlaybackInfo>
+{
+    auto playback  = PlaybackInfo();
+    playback.State = mPlayer.GetState();
+    if (playback.State != PlaybackState::Nothing)
+    {
+        playback.Elapsed = mPlayer.GetPosition();
+    }
+    else
+    {
+        playback.Elapsed = std::nullopt;
+    }
+
+    SetAnchor(playback);
+    return playback;
+}
+
+auto ShowPlaySession::GetCoverInfo() -> std::optional<CoverInfo>
+{
+    mPendingCover  = std::nullopt;
+    mIsCoverCached = false;
+
+    if (!mPlayer.HasTrack())
+    {
+        return std::nullopt;
+    }
+
+    auto cover = CoverInfo();
+    auto art   = mPlayer.GetCover();
+    if (art.has_value() && art->Data != nullptr)
+    {
+        auto hash   = Hash64(art->Data.get(), art->Size);
+        auto cached = mCoverCache.Find(hash);
+        mIsCoverCached = cached != nullptr;
+        if (cached == nullptr)
+        {
+            // Too large covers are downsampled on transcoder thread, cover
+            // is sent when it's done.
+            if (mCoverLimits.IsEnabled())
+            {
+                mCoverTranscoder.Submit(hash, std::move(art.value()), mCoverLimits);
+                mPendingCover = hash;
+                return std::nullopt;
+            }
+
+            cached = &mCoverCache.Insert(hash, std::move(art.value()));
+        }
+
+        // Encoded once per cover, not once per send.
+        if (AnyCoverBase64())
+        {
+            EncodeCover(cached->Image);
+        }
+
+        // Senders of servers that already have this cover send hash only.
+        cover.Hash  = HashToString(hash);
+        cover.Image = cached->Image;
+    }
+
+    return cover;
+}
+
+auto ShowPlaySession::EncodeCover(BinaryData& image) -> void
+{
+    if (image.Base64 != nullptr)
+    {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    image.EncodeBase64();
+    mMetrics.Base64Time.Record(std::chrono::steady_clock::now() - start);
+}
+
+auto ShowPlaySession::SetAnchor(PlaybackInfo& playback) -> void
+{
+    if (!AnyEndpointHas(ServerFeature::Anchor))
+    {
+        return;
+    }
+
+    // Players have no playback speed, song either plays or doesn't.
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+
+    playback.Rate      = playback.State == PlaybackState::Playing ? 1.0 : 0.0;
+    playback.Timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+
+    mAnchor = playback;
+}
+
+auto ShowPlaySession::IsAnchorDrifted() -> bool
+{
+    if (!mAnchor.has_value() || mPlayer.GetState() == PlaybackState::Nothing)
+    {
+        return false;
+    }
+
+    const auto& anchor = mAnchor.value();
+    if (!anchor.Elapsed.has_value() || !anchor.Rate.has_value() || !anchor.Timestamp.has_value())
+    {
+        return true;
+    }
+
+    // Where server thinks we are.
+    auto now       = std::chrono::steady_clock::now().time_since_epoch();
+    auto nowMs     = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+    auto predicted = anchor.Elapsed.value() + anchor.Rate.value() * (nowMs - anchor.Timestamp.value()) / 1000.0;
+    auto actual    = mPlayer.GetPosition();
+
+    return std::abs(actual - predicted) > ANCHOR_DRIFT_THRESHOLD;
+}
+
+auto ShowPlaySession::SendPlaybackInfo() -> void
+{
+    auto playback = GetPlaybackInfo();
+    SendPayload(Payload(std::nullopt, playback, std::nullopt, std::nullopt));
+}
+
+auto ShowPlaySession::SendSongInfo() -> void
+{
+    auto payload   = Payload(std::nullopt, std::nullopt, mPlayer.GetSong(), std::nullopt);
+    payload.Fields = mPlayer.GetFields();
+
+    SendPayload(std::move(payload));
+}
+
+auto ShowPlaySession::SendCoverInfo() -> void
+{
+    auto cover = GetCoverInfo();
+
+    // Transcoder sends cover when it's ready, until then there is none.
+    if (mPendingCover.has_value())
+    {
+        mStore.Update(Payload(std::nullopt, std::nullopt, std::nullopt, CoverInfo()));
+        return;
+    }
+
+    SendPayload(Payload(std::nullopt, std::nullopt, std::nullopt, cover));
+}
+
+auto ShowPlaySession::SendFields() -> void
+{
+    auto payload   = Payload();
+    payload.Fields = mPlayer.GetFields();
+
+    if (payload.Fields.has_value())
+    {
+        SendPayload(std::move(payload));
+    }
+}
+
+auto ShowPlaySession::SendStats() -> void
+{
+    auto now = PayloadScheduler::Clock::now();
+    if (now < mNextStats || !AnyEndpointHas(ServerFeature::Stats))
+    {
+        return;
+    }
+
+    mNextStats = now + STATS_INTERVAL;
+
+    // Metrics aren't player state, they bypass state store and snapshots.
+    auto payload  = Payload();
+    payload.Stats = mMetrics.GetStats();
+
+    SchedulePayload(std::move(payload));
+}
+
+auto ShowPlaySession::SendPlaybackInfo(double elapsed) -> void
+{
+    auto playback    = PlaybackInfo();
+    playback.State   = std::nullopt;
+    playback.Elapsed = elapsed;
+
+    SendPayload(Payload(std::nullopt, playback, std::nullopt, std::nullopt));
+}
+
+auto ShowPlaySession::SendPlaybackInfo(PlaybackState state, std::optional<double> elapsed) -> void
+{
+    // Create PlaybackInfo.
+    auto playback    = PlaybackInfo();
+    playback.State   = state;
+    playback.Elapsed = elapsed;
+
+    // Anchor needs position even if event doesn't carry it.
+    if (AnyEndpointHas(ServerFeature::Anchor))
+    {
+        if (!playback.Elapsed.has_value() && state != PlaybackState::Nothing)
+        {
+            playback.Elapsed = mPlayer.GetPosition();
+        }
+
+        SetAnchor(playback);
+    }
+
+    SendPayload(Payload(std::nullopt, playback, std::nullopt, std::nullopt));
+}
+
+auto ShowPlaySession::SendSnapshot(Endpoint& endpoint) -> void
+{
+    // If endpoint is not active then skip sending.
+    if (!endpoint.GetWebSocket().IsActive())
+    {
+        return;
+    }
+
+    // Pending sections still go to other endpoints, snapshot follows them.
+    FlushPayload();
+
+    // Nothing happened since start, player is asked once.
+    if (mStore.IsEmpty())
+    {
+        auto payload   = Payload(GetPlayerInfo(), GetPlaybackInfo(), mPlayer.GetSong(), GetCoverInfo());
+        payload.Fields = mPlayer.GetFields();
+
+        mStore.Update(payload);
+    }
+
+    // Full frame, everything in one payload. Only position is read from
+    // player, the rest was captured when it changed.
+    const auto& state = mStore.GetState();
+    auto snapshot = Payload(GetPlayerInfo(), GetPlaybackInfo(), state.Song, state.Cover, mStore.GetSync(endpoint.GetSyncedVersion()));
+    snapshot.Fields = state.Fields;
+
+    endpoint.GetSender().EnqueueSnapshot(std::move(snapshot), mStore.GetVersion());
+}
+
+auto ShowPlaySession::SendPayload(Payload payload) -> void
+{
+    // State is kept even if nobody listens, reconnecting server gets it as
+    // snapshot.
+    mStore.Update(payload);
+    if (!IsAnyActive())
+    {
+        return;
+    }
+
+    SchedulePayload(std::move(payload));
+}
+
+auto ShowPlaySession::SchedulePayload(Payload payload) -> void
+{
+    // Bursts of events are coalesced and sent at most at max send rate.
+    auto now = PayloadScheduler::Clock::now();
+    if (mScheduler.Schedule(std::move(payload), now))
+    {
+        FlushPayload();
+        return;
+    }
+
+    StartFlushTimer(mScheduler.GetFlushTime() - now);
+}
+
+auto ShowPlaySession::FlushPayload() -> void
+{
+    StopFlushTimer();
+
+    if (!mScheduler.HasPending())
+    {
+        return;
+    }
+
+    // Captured once, encoded on sender threads and shared between them.
+    auto payload = std::make_shared<const SharedPayload>(mScheduler.Take(PayloadScheduler::Clock::now()));
+    for (auto& endpoint : mEndpoints)
+    {
+        if (endpoint->GetWebSocket().IsActive())
+        {
+            endpoint->GetSender().Enqueue(payload, mStore.GetVersion());
+        }
+    }
+}
+
+auto ShowPlaySession::StartFlushTimer(PayloadScheduler::Clock::duration delay) -> void
+{
+    // Already waiting for flush.
+    if (mIsFlushTimerStarted)
+    {
+        return;
+    }
+
+    auto delayMs = std::chrono::ceil<std::chrono::milliseconds>(delay);
+    mIsFlushTimerStarted = true;
+    mHost.StartTimer(std::max(delayMs, std::chrono::milliseconds(1)), [this]()
+    {
+        mIsFlushTimerStarted = false;
+        FlushPayload();
+    });
+}
+
+auto ShowPlaySession::StopFlushTimer() -> void
+{
+    if (mIsFlushTimerStarted)
+    {
+        mHost.StopTimer();
+        mIsFlushTimerStarted = false;
+    }
+}
+
+auto ShowPlaySession::CreateEndpoint() -> std::shared_ptr<Endpoint>
+{
+    auto endpoint = std::make_shared<Endpoint>(mReconnectSettings, mMetrics);
+    auto weak     = std::weak_ptr<Endpoint>(endpoint);
+
+    // Register callbacks.
+    auto& webSocket = endpoint->GetWebSocket();
+    webSocket.SetOnConnectedCallback    ([this, weak]() { InMainThreadOnConnected    (weak); });
+    webSocket.SetOnDisconnectedCallback ([this, weak]() { InMainThreadOnDisconnected (weak); });
+    webSocket.SetOnActivatedCallback    ([this, weak]() { InMainThreadOnActivated    (weak); });
+    webSocket.SetOnDeactivatedCallback  ([this, weak]() { InMainThreadOnDeactivated  (weak); });
+    webSocket.SetOnSnapshotRequestCallback ([this, weak]() { InMainThreadOnSnapshotRequest (weak); });
+    webSocket.SetOnCoverRequestCallback    ([this, weak](std::string hash) { InMainThreadOnCoverRequest (weak, hash); });
+    webSocket.SetOnSchemaCallback          ([this, weak]() { InMainThreadOnSchema (weak); });
+
+    endpoint->GetSender().SetOnOverflowCallback ([this, weak]() { InMainThreadOnSenderOverflow (weak); });
+
+    return endpoint;
+}
+
+auto ShowPlaySession::Connect(std::string urls) -> void
+{
+    auto endpoints = std::vector<std::shared_ptr<Endpoint>>();
+    for (const auto& url : SplitServerUrls(urls))
+    {
+        // Reuse endpoint of the same server, it keeps connection and state
+        // known by server.
+        auto it = std::find_if(mEndpoints.begin(), mEndpoints.end(), [&url](const std::shared_ptr<Endpoint>& endpoint)
+        {
+            return endpoint != nullptr && endpoint->GetWebSocket().GetServerUrl() == url;
+        });
+
+        auto endpoint = it != mEndpoints.end() ? std::move(*it) : CreateEndpoint();
+        endpoint->GetWebSocket().TryConnect(url);
+        endpoints.push_back(std::move(endpoint));
+    }
+
+    // Removed endpoints disconnect when destroyed.
+    mEndpoints = std::move(endpoints);
+    mHost.OnStatusChanged();
+    UpdateSchema();
+}
+
+auto ShowPlaySession::Disconnect() -> void
+{
+    for (auto& endpoint : mEndpoints)
+    {
+        endpoint->GetWebSocket().Disconnect();
+    }
+}
+
+auto ShowPlaySession::SetReconnectSettings(ReconnectSettings settings) -> void
+{
+    mReconnectSettings = settings;
+    for (auto& endpoint : mEndpoints)
+    {
+        endpoint->GetWebSocket().SetReconnectSettings(settings);
+    }
+}
+
+auto ShowPlaySession::SetCoverLimits(CoverLimits limits) -> void
+{
+    // Cached covers were made with old cover limits.
+    mCoverLimits = limits;
+    mCoverCache.Clear();
+}
+
+auto ShowPlaySession::UpdateSchema() -> void
+{
+    auto schemas = std::vector<std::shared_ptr<const FieldSchema>>();
+    for (const auto& endpoint : mEndpoints)
+    {
+        schemas.push_back(endpoint->GetWebSocket().GetSchema());
+    }
+
+    // Every definition is evaluated, servers still get only their own.
+    auto merged = MergeSchemas(schemas);
+    for (const auto& name : FindConflicts(merged))
+    {
+        mHost.Log("ShowPlay: servers define field " + name + " differently, each gets its own");
+    }
+
+    mPlayer.SetFieldSchema(merged);
+}
+
+auto ShowPlaySession::IsAnyActive() const -> bool
+{
+    return std::any_of(mEndpoints.begin(), mEndpoints.end(), [](const std::shared_ptr<Endpoint>& endpoint)
+    {
+        return endpoint->GetWebSocket().IsActive();
+    });
+}
+
+auto ShowPlaySession::AnyEndpointHas(ServerFeature feature) const -> bool
+{
+    return std::any_of(mEndpoints.begin(), mEndpoints.end(), [feature](const std::shared_ptr<Endpoint>& endpoint)
+    {
+        const auto& webSocket = endpoint->GetWebSocket();
+        return webSocket.IsActive() && webSocket.HasFeature(feature);
+    });
+}
+
+auto ShowPlaySession::AllEndpointsHave(ServerFeature feature) const -> bool
+{
+    return std::all_of(mEndpoints.begin(), mEndpoints.end(), [feature](const std::shared_ptr<Endpoint>& endpoint)
+    {
+        const auto& webSocket = endpoint->GetWebSocket();
+        return !webSocket.IsActive() || webSocket.HasFeature(feature);
+    });
+}
+
+auto ShowPlaySession::AnyCoverBase64() const -> bool
+{
+    return std::any_of(mEndpoints.begin(), mEndpoints.end(), [](const std::shared_ptr<Endpoint>& endpoint)
+    {
+        const auto& webSocket = endpoint->GetWebSocket();
+        return webSocket.IsActive() && webSocket.IsCoverBase64();
+    });
+}
+
+auto ShowPlaySession::GetConnectionStatus() const -> std::string
+{
+    auto connected = std::count_if(mEndpoints.begin(), mEndpoints.end(), [](const std::shared_ptr<Endpoint>& endpoint)
+    {
+        return endpoint->GetWebSocket().IsConnected();
+    });
+
+    if (connected == 0)
+    {
+        return "Disconnected";
+    }
+
+    if (static_cast<std::size_t>(connected) == mEndpoints.size())
+    {
+        return "Connected";
+    }
+
+    return "Connected " + std::to_string(connected) + "/" + std::to_string(mEndpoints.size());
+}
+
+auto ShowPlaySession::GetToken() const -> std::optional<std::string>
+{
+    if (mEndpoints.empty())
+    {
+        return std::nullopt;
+    }
+
+    return mEndpoints.front()->GetWebSocket().GetToken();
+}
+
+auto ShowPlaySession::GetSendQueueDepth() const -> std::size_t
+{
+    auto depth = std::size_t(0);
+    for (const auto& endpoint : mEndpoints)
+    {
+        depth += endpoint->GetSender().GetQueueDepth();
+    }
+
+    return depth;
+}
+
+auto ShowPlaySession::GetSendLatency() const -> std::chrono::microseconds
+{
+    auto latency = std::chrono::microseconds(0);
+    for (const auto& endpoint : mEndpoints)
+    {
+        latency = std::max(latency, endpoint->GetSender().GetLastLatency());
+    }
+
+    return latency;
+}
+
+auto ShowPlaySession::GetMaxSendLatency() const -> std::chrono::microseconds
+{
+    auto latency = std::chrono::microseconds(0);
+    for (const auto& endpoint : mEndpoints)
+    {
+        latency = std::max(latency, endpoint->GetSender().GetMaxLatency());
+    }
+
+    return latency;
+}
+
+} // namespace foo_showplay
@@ -0,0 +1,182 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "CoverCache.hpp"
+#include "CoverTranscoder.hpp"
+#include "Endpoint.hpp"
+#include "Metrics.hpp"
+#include "Payload.hpp"
+#include "PayloadScheduler.hpp"
+#include "Player.hpp"
+#include "StateStore.hpp"
+
+namespace foo_showplay {
+
+// Everything between player events and servers: endpoints, state store,
+// send scheduling and covers. Knows the player only through Player and
+// Host, all methods are called on main thread.
+class ShowPlaySession
+{
+    Player& mPlayer;
+    Host&   mHost;
+
+    Metrics mMetrics; // Before endpoints, their threads write to it.
+    std::vector<std::shared_ptr<Endpoint>> mEndpoints;
+    PayloadScheduler  mScheduler;
+    StateStore        mStore;
+    bool              mIsFlushTimerStarted;
+    CoverCache        mCoverCache;
+    CoverTranscoder   mCoverTranscoder;
+    CoverLimits       mCoverLimits;
+    ReconnectSettings mReconnectSettings;
+    std::optional<std::uint64_t> mPendingCover; // Waiting for transcoder, not sent yet.
+    bool                         mIsCoverCached; // Current cover was found in cache.
+    std::optional<PlaybackInfo>  mAnchor;       // Last anchor sent, in anchor mode.
+    PayloadScheduler::Clock::time_point mNextStats;
+
+    // Endpoint may be removed before main thread gets to its callback.
+    template <typename Handler>
+    auto InMainThread (std::weak_ptr<Endpoint> endpoint, Handler handler) -> void
+    {
+        mHost.InMainThread([endpoint, handler]()
+        {
+            if (auto locked = endpoint.lock())
+            {
+                handler(*locked);
+            }
+        });
+    }
+
+    // WebSocket Client callbacks.
+    auto OnConnected    (Endpoint& endpoint) -> void;
+    auto OnDisconnected (Endpoint& endpoint) -> void;
+    auto OnActivated    (Endpoint& endpoint) -> void;
+    auto OnDeactivated  (Endpoint& endpoint) -> void;
+    auto OnSnapshotRequest (Endpoint& endpoint) -> void;
+    auto OnCoverRequest    (Endpoint& endpoint, std::string hash) -> void;
+    auto OnSchema          (Endpoint& endpoint) -> void;
+
+    auto InMainThreadOnConnected    (std::weak_ptr<Endpoint> endpoint) -> void { InMainThread(endpoint, [this](Endpoint& e) { OnConnected    (e); }); }
+    auto InMainThreadOnDisconnected (std::weak_ptr<Endpoint> endpoint) -> void { InMainThread(endpoint, [this](Endpoint& e) { OnDisconnected (e); }); }
+    auto InMainThreadOnActivated    (std::weak_ptr<Endpoint> endpoint) -> void { InMainThread(endpoint, [this](Endpoint& e) { OnActivated    (e); }); }
+    auto InMainThreadOnDeactivated  (std::weak_ptr<Endpoint> endpoint) -> void { InMainThread(endpoint, [this](Endpoint& e) { OnDeactivated  (e); }); }
+    auto InMainThreadOnSnapshotRequest (std::weak_ptr<Endpoint> endpoint) -> void { InMainThread(endpoint, [this](Endpoint& e) { OnSnapshotRequest (e); }); }
+    auto InMainThreadOnCoverRequest    (std::weak_ptr<Endpoint> endpoint, std::string hash) -> void { InMainThread(endpoint, [this, hash](Endpoint& e) { OnCoverRequest (e, hash); }); }
+    auto InMainThreadOnSchema          (std::weak_ptr<Endpoint> endpoint) -> void { InMainThread(endpoint, [this](Endpoint& e) { OnSchema (e); }); }
+
+    // Payload Sender callbacks.
+    auto OnSenderOverflow (Endpoint& endpoint) -> void;
+
+    auto InMainThreadOnSenderOverflow (std::weak_ptr<Endpoint> endpoint) -> void { InMainThread(endpoint, [this](Endpoint& e) { OnSenderOverflow (e); }); }
+
+    // Cover Transcoder callbacks.
+    auto OnCoverTranscoded (std::uint64_t hash, BinaryData image) -> void;
+
+    auto InMainThreadOnCoverTranscoded (std::uint64_t hash, BinaryData image) -> void { mHost.InMainThread([this, hash, image]() { OnCoverTranscoded (hash, image); }); }
+
+    auto GetPlayerInfo   () -> std::optional<PlayerInfo>;
+    auto GetPlaybackInfo () -> std::optional<PlaybackInfo>;
+    auto GetCoverInfo    () -> std::optional<CoverInfo>;
+
+    auto EncodeCover     (BinaryData& image) -> void;
+    auto SetAnchor       (PlaybackInfo& playback) -> void;
+    auto IsAnchorDrifted () -> bool;
+
+    auto CreateEndpoint  () -> std::shared_ptr<Endpoint>;
+    auto UpdateSchema    () -> void;
+
+    // Only active endpoints count.
+    auto IsAnyActive     () const                        -> bool;
+    auto AnyEndpointHas  (ServerFeature feature) const   -> bool;
+    auto AllEndpointsHave (ServerFeature feature) const  -> bool;
+
+    auto SendPlaybackInfo () -> void;
+    auto SendSongInfo     () -> void;
+    auto SendCoverInfo    () -> void;
+    auto SendFields       () -> void;
+    auto SendStats        () -> void;
+    auto SendPlaybackInfo (double elapsed) -> void;
+    auto SendPlaybackInfo (PlaybackState state, std::optional<double> elapsed) -> void;
+    auto SendSnapshot     (Endpoint& endpoint) -> void;
+
+    auto SendPayload     (Payload payload) -> void;
+    auto SchedulePayload (Payload payload) -> void;
+    auto FlushPayload    () -> void;
+
+    auto StartFlushTimer (PayloadScheduler::Clock::duration delay) -> void;
+    auto StopFlushTimer  () -> void;
+
+public:
+    ShowPlaySession(Player& player, Host& host, CoverTranscoder::CodecFactory codecFactory, ReconnectSettings reconnectSettings);
+    ~ShowPlaySession();
+
+    ShowPlaySession(const ShowPlaySession&) = delete;
+    auto operator= (const ShowPlaySession&) -> ShowPlaySession& = delete;
+
+    // List of server urls separated by ';'. Endpoints of urls that stay in
+    // the list keep their connection.
+    auto Connect    (std::string urls) -> void;
+    auto Disconnect () -> void;
+
+    // Player events. Song of new track is passed in, player may not report
+    // it as current yet.
+    auto OnNewTrack    (std::optional<SongInfo> song, std::optional<CustomFields> fields) -> void;
+    auto OnSongChanged () -> void; // Tags of current track edited.
+    auto OnStop        () -> void;
+    auto OnSeek        (double time) -> void;
+    auto OnPause       (bool isPaused) -> void;
+    auto OnTime        (double time) -> void;
+    auto OnAlbumArt    () -> void;
+
+    auto SetMaxSendRate       (int framesPerSecond) -> void { mScheduler.SetMaxRate(framesPerSecond); }
+    auto SetReconnectSettings (ReconnectSettings settings) -> void; // Used from next connection attempt.
+    auto SetCoverLimits       (CoverLimits limits) -> void;        // Cached covers are dropped, resend with OnAlbumArt.
+
+    // Cover prepared ahead, e.g. of next track.
+    auto AddCover (std::uint64_t hash, BinaryData image) -> void { mCoverCache.Insert(hash, std::move(image)); }
+
+    // Whether cover of last album art was taken from cache, instead of being
+    // transcoded and encoded then.
+    auto IsCoverCached () const -> bool { return mIsCoverCached; }
+
+    auto GetCoverLimits () const -> CoverLimits { return mCoverLimits; }
+    auto AnyCoverBase64 () const -> bool;
+
+    auto GetConnectionStatus () const -> std::string;
+    auto GetToken            () const -> std::optional<std::string>; // Of first endpoint.
+
+    // Summed or worst over endpoints.
+    auto GetSendQueueDepth () const -> std::size_t;
+    auto GetSendLatency    () const -> std::chrono::microseconds;
+    auto GetMaxSendLatency () const -> std::chrono::microseconds;
+    auto GetMergedCount    () const -> std::uint64_t             { return mScheduler.GetMergedCount();  }
+    auto GetDroppedCount   () const -> std::uint64_t             { return mScheduler.GetDroppedCount(); }
+
+    auto GetMetrics () const -> const Metrics& { return mMetrics; }
+};
+
+} // namespace foo_showplay
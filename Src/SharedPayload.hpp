@@ -0,0 +1,123 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "Payload.hpp"
+#include "Serializer.hpp"
+
+namespace foo_showplay {
+
+// Payload captured once and sent to every endpoint. Sections are encoded on
+// first use, endpoints that need the same bytes reuse them.
+class SharedPayload
+{
+    struct EncodedSection
+    {
+        FrameFormat Format;
+        std::size_t Index;
+        FieldMask   Mask;
+        std::string Bytes;
+    };
+
+    Payload                            mPayload;
+    mutable std::mutex                 mMutex;
+    mutable std::deque<EncodedSection> mSections; // Deque keeps returned references valid.
+
+public:
+    SharedPayload(Payload payload)
+        : mPayload (std::move(payload))
+    {
+    }
+
+    auto Get () const -> const Payload& { return mPayload; }
+
+    // Returns section encoded with given fields, encoder is called only if
+    // no endpoint did encode it yet.
+    template <typename Encoder>
+    auto GetSection (FrameFormat format, std::size_t index, FieldMask mask, Encoder&& encode) const -> std::string_view
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        for (const auto& section : mSections)
+        {
+            if (section.Format == format && section.Index == index && section.Mask == mask)
+            {
+                return section.Bytes;
+            }
+        }
+
+        auto& section = mSections.emplace_back(EncodedSection{ format, index, mask, std::string() });
+        encode(section.Bytes);
+
+        return section.Bytes;
+    }
+};
+
+// Same as WriteSections, but sections equal to shared ones are copied from
+// shared payload instead of encoded again. Endpoint may send modified copy,
+// e.g. without cover known by its server, such sections are written as usual.
+template <typename Writer>
+auto WriteSharedSections(
+    Writer&                    writer,
+    const Payload&             payload,
+    const SharedPayload&       shared,
+    const FieldMasks<Payload>& masks,
+    std::string_view           first,
+    std::string_view           last
+) -> void
+{
+    auto index = std::size_t(0);
+    Payload::VisitFields([&](const char* name, auto member)
+    {
+        auto mask      = masks.Fields[index];
+        auto isInRange = first <= name && (last.empty() || name < last);
+        if (mask != 0 && isInRange)
+        {
+            const auto& section       = payload.*member;
+            const auto& sharedSection = shared.Get().*member;
+
+            writer.Key(name);
+            if (!section.has_value())
+            {
+                writer.Null();
+            }
+            else if ((DiffFields(section, sharedSection) & mask) == 0)
+            {
+                writer.Raw(shared.GetSection(Writer::Format, index, mask, [&](std::string& buffer)
+                {
+                    auto sectionWriter = Writer(buffer);
+                    WriteObject(sectionWriter, section.value(), mask);
+                }));
+            }
+            else
+            {
+                WriteObject(writer, section.value(), mask);
+            }
+        }
+        index += 1;
+    });
+}
+
+} // namespace foo_showplay
@@ -0,0 +1,79 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "SongInfoCache.hpp"
+
+namespace foo_showplay {
+
+auto SongInfoCache::Insert(metadb_handle_ptr track, SongInfo song) -> const SongInfo&
+{
+    auto key = track.get_ptr();
+
+    // Formatted again, replace old entry.
+    auto indexIt = mIndex.find(key);
+    if (indexIt != mIndex.end())
+    {
+        mEntries.erase(indexIt->second);
+    }
+
+    mEntries.emplace_front(std::move(track), std::move(song));
+    mIndex[key] = mEntries.begin();
+
+    // Drop least recently used.
+    while (mEntries.size() > mCapacity)
+    {
+        mIndex.erase(mEntries.back().Track.get_ptr());
+        mEntries.pop_back();
+    }
+
+    return mEntries.front().Song;
+}
+
+auto SongInfoCache::Find(const metadb_handle_ptr& track) -> const SongInfo*
+{
+    auto indexIt = mIndex.find(track.get_ptr());
+    if (indexIt == mIndex.end())
+    {
+        mMisses += 1;
+        return nullptr;
+    }
+
+    mHits += 1;
+    mEntries.splice(mEntries.begin(), mEntries, indexIt->second);
+    return &mEntries.front().Song;
+}
+
+auto SongInfoCache::Erase(const metadb_handle_ptr& track) -> void
+{
+    auto indexIt = mIndex.find(track.get_ptr());
+    if (indexIt != mIndex.end())
+    {
+        mEntries.erase(indexIt->second);
+        mIndex.erase(indexIt);
+    }
+}
+
+auto SongInfoCache::Clear() -> void
+{
+    mIndex.clear();
+    mEntries.clear();
+}
+
+} // namespace foo_showplay
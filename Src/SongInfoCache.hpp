@@ -0,0 +1,73 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <foobar2000.h>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+#include "Payload.hpp"
+
+namespace foo_showplay {
+
+struct CachedSongInfo
+{
+    metadb_handle_ptr Track; // Keeps handle alive, so its address isn't reused.
+    SongInfo          Song;
+
+    CachedSongInfo(metadb_handle_ptr track, SongInfo song)
+        : Track (std::move(track))
+        , Song  (std::move(song))
+    {
+    }
+};
+
+// LRU of formatted songs keyed by track, so reconnects and repeated tracks
+// don't run titleformat again. Entries are erased when track info changes.
+class SongInfoCache
+{
+    using EntryList = std::list<CachedSongInfo>;
+
+    EntryList                                                     mEntries; // Most recently used first.
+    std::unordered_map<const metadb_handle*, EntryList::iterator> mIndex;
+    std::size_t                                                   mCapacity;
+    std::uint64_t                                                 mHits;
+    std::uint64_t                                                 mMisses;
+
+public:
+    SongInfoCache(std::size_t capacity)
+        : mCapacity (capacity)
+        , mHits     (0)
+        , mMisses   (0)
+    {
+    }
+
+    auto Insert (metadb_handle_ptr track, SongInfo song) -> const SongInfo&;
+    auto Find   (const metadb_handle_ptr& track)         -> const SongInfo*;
+    auto Erase  (const metadb_handle_ptr& track)         -> void;
+
+    auto Clear  () -> void;
+
+    auto GetHits   () const -> std::uint64_t { return mHits;   }
+    auto GetMisses () const -> std::uint64_t { return mMisses; }
+};
+
+} // namespace foo_showplay
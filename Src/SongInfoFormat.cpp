@@ -0,0 +1,120 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "SongInfoFormat.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+namespace foo_showplay {
+
+// Order of fields in script.
+enum SongInfoField
+{
+    Title,
+    Artist,
+    Album,
+    Date,
+    Year,
+    TrackNumber,
+    Length,
+    Path,
+    FieldCount,
+};
+
+static constexpr const char* SONG_INFO_FIELDS[FieldCount] = {
+    "%title%",
+    "%artist%",
+    "%album%",
+    "%date%",
+    "%year%",
+    "%track number%",
+    "%length_seconds_fp%",
+    "%path%",
+};
+
+// Missing field is formatted as "?".
+static auto ToString(std::string_view value) -> std::optional<std::string>
+{
+    if (value == "?")
+    {
+        return std::nullopt;
+    }
+
+    return std::string(value);
+}
+
+template <typename T>
+static auto ToNumber(std::string_view value) -> std::optional<T>
+{
+    auto number = T();
+    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (error != std::errc())
+    {
+        return std::nullopt;
+    }
+
+    return number;
+}
+
+auto GetSongInfoScript() -> std::string
+{
+    auto script = std::string();
+    for (auto i = 0; i < FieldCount; ++i)
+    {
+        if (i > 0)
+        {
+            script.push_back(SONG_INFO_SEPARATOR);
+        }
+
+        script.append("$replace(");
+        script.append(SONG_INFO_FIELDS[i]);
+        script.push_back(',');
+        script.push_back(SONG_INFO_SEPARATOR);
+        script.append(",)");
+    }
+
+    return script;
+}
+
+auto ParseSongInfo(std::string_view formatted) -> SongInfo
+{
+    std::string_view fields[FieldCount];
+    for (auto i = 0; i < FieldCount; ++i)
+    {
+        auto end  = std::min(formatted.find(SONG_INFO_SEPARATOR), formatted.size());
+        fields[i] = formatted.substr(0, end);
+        formatted.remove_prefix(std::min(end + 1, formatted.size()));
+    }
+
+    auto song        = SongInfo();
+    song.Title       = ToString(fields[Title]);
+    song.Artist      = ToString(fields[Artist]);
+    song.Album       = ToString(fields[Album]);
+    song.Date        = ToString(fields[Date]);
+    song.Year        = ToString(fields[Year]);
+    song.TrackNumber = ToNumber<int>(fields[TrackNumber]);
+    song.Length      = ToNumber<double>(fields[Length]);
+    song.Path        = ToString(fields[Path]);
+
+    return song;
+}
+
+} // namespace foo_showplay
@@ -0,0 +1,39 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include "Payload.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace foo_showplay {
+
+// Fields in combined script are separated by ASCII unit separator. It is
+// removed from field values, so splitting is unambiguous.
+inline constexpr auto SONG_INFO_SEPARATOR = '\x1F';
+
+// Titleformat script that formats all SongInfo fields in one pass.
+auto GetSongInfoScript () -> std::string;
+
+// Parses output of GetSongInfoScript without intermediate strings.
+auto ParseSongInfo (std::string_view formatted) -> SongInfo;
+
+} // namespace foo_showplay
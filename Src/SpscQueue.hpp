@@ -0,0 +1,90 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace foo_showplay {
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be power of two");
+
+    // Indices only grow, slot is index modulo capacity. Kept on separate
+    // cache lines so producer and consumer don't fight over them.
+    alignas(64) std::atomic<std::size_t> mHead; // Next slot to pop, written by consumer.
+    alignas(64) std::atomic<std::size_t> mTail; // Next slot to push, written by producer.
+    alignas(64) std::array<T, Capacity>  mSlots;
+
+public:
+    SpscQueue()
+        : mHead (0)
+        , mTail (0)
+    {
+    }
+
+    SpscQueue(const SpscQueue&)            = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer only. Returns false if queue is full.
+    auto TryPush (T&& value) -> bool
+    {
+        auto tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+
+        mSlots[tail & (Capacity - 1)] = std::move(value);
+        mTail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer only. Returns false if queue is empty.
+    auto TryPop (T& value) -> bool
+    {
+        auto head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        value = std::move(mSlots[head & (Capacity - 1)]);
+        mHead.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Approximate when called while other thread is working with queue.
+    auto Size () const -> std::size_t
+    {
+        auto head = mHead.load(std::memory_order_acquire);
+        auto tail = mTail.load(std::memory_order_acquire);
+
+        return tail - head;
+    }
+};
+
+} // namespace foo_showplay
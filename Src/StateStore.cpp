@@ -0,0 +1,105 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "StateStore.hpp"
+
+#include <chrono>
+
+namespace foo_showplay {
+
+auto StateStore::Update(const Payload& payload) -> void
+{
+    auto update = payload;
+
+    // Playback without State carries only Elapsed.
+    if (update.Playback.has_value() && mState.Playback.has_value())
+    {
+        if (!update.Playback.value().State.has_value())
+        {
+            update.Playback.value().State = mState.Playback.value().State;
+        }
+    }
+
+    auto index = 0;
+    Payload::VisitFields([&](const char*, auto member)
+    {
+        auto& stored  = mState.*member;
+        auto& section = update.*member;
+        if (section.has_value() && DiffFields(stored, section) != 0)
+        {
+            mVersion += 1;
+            mSectionVersions[index] = mVersion;
+            stored = std::move(section);
+        }
+        index += 1;
+    });
+}
+
+auto StateStore::RecordTrack(const SongInfo& song) -> void
+{
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+
+    auto track     = TrackRecord();
+    track.Title    = song.Title;
+    track.Artist   = song.Artist;
+    track.Album    = song.Album;
+    track.Path     = song.Path;
+    track.PlayedAt = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+
+    mVersion += 1;
+    mHistory.push_back(HistoryEntry{ mVersion, std::move(track) });
+    if (mHistory.size() > TRACK_HISTORY_SIZE)
+    {
+        mHistory.pop_front();
+    }
+}
+
+auto StateStore::GetSync(std::uint64_t since) const -> SyncInfo
+{
+    auto changed = std::vector<std::string>();
+    auto index   = 0;
+    Payload::VisitFields([&](const char* name, auto)
+    {
+        if (mSectionVersions[index] > since)
+        {
+            changed.emplace_back(name);
+        }
+        index += 1;
+    });
+
+    auto history = std::vector<TrackRecord>();
+    for (const auto& entry : mHistory)
+    {
+        if (entry.Version > since)
+        {
+            history.push_back(entry.Track);
+        }
+    }
+
+    auto sync    = SyncInfo();
+    sync.Changed = std::move(changed);
+    sync.History = std::move(history);
+    sync.Since   = since;
+    sync.Version = mVersion;
+
+    return sync;
+}
+
+} // namespace foo_showplay
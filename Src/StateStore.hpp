@@ -0,0 +1,64 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "Constants.hpp"
+#include "Payload.hpp"
+
+namespace foo_showplay {
+
+// Latest version of every section, kept up to date even while no server is
+// connected. Reconnecting server gets one snapshot built from it, instead of
+// every frame it missed. Main thread only.
+class StateStore
+{
+    struct HistoryEntry
+    {
+        std::uint64_t Version;
+        TrackRecord   Track;
+    };
+
+    Payload                  mState;
+    std::uint64_t            mVersion; // Incremented on every change.
+    std::uint64_t            mSectionVersions[Payload::FieldCount] = {};
+    std::deque<HistoryEntry> mHistory; // Oldest first.
+
+public:
+    StateStore()
+        : mVersion (0)
+    {
+    }
+
+    // Merges sections present in payload.
+    auto Update      (const Payload& payload) -> void;
+    auto RecordTrack (const SongInfo& song)   -> void;
+
+    auto IsEmpty    () const -> bool           { return mVersion == 0; }
+    auto GetVersion () const -> std::uint64_t  { return mVersion; }
+    auto GetState   () const -> const Payload& { return mState;   }
+
+    // What changed after given version. History older than store holds is lost.
+    auto GetSync (std::uint64_t since) const -> SyncInfo;
+};
+
+} // namespace foo_showplay
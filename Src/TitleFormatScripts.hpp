@@ -19,63 +19,112 @@
 
 #pragma once
 
+#include "FieldSchema.hpp"
+#include "SongInfoFormat.hpp"
+
 #include <foobar2000.h>
 #include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace foo_showplay {
 
-class TitleFormatScript
+// Formats all SongInfo fields with one compiled script, per track cost is
+// one titleformat pass into reused buffer.
+class SongInfoScript
 {
     titleformat_object::ptr mScript;
+    pfc::string8            mBuffer;
 
 public:
-    TitleFormatScript(const char* p_spec)
+    SongInfoScript()
     {
         auto compiler = static_api_ptr_t<titleformat_compiler>();
-        compiler->compile_safe_ex(mScript, p_spec);
+        compiler->compile_safe_ex(mScript, GetSongInfoScript().c_str());
     }
 
-    std::optional<std::string> GetInfo(metadb_handle_ptr p_track)
+    // Used from one thread only, buffer is shared between calls.
+    auto GetInfo (metadb_handle_ptr p_track) -> std::optional<SongInfo>
     {
-        auto sf = fb2k::formatTrackTitle(p_track, mScript);
-        auto info = std::string(sf.toString());
-        
-        return info != "?" ? info : std::optional<std::string>(std::nullopt);
+        if (p_track.is_empty())
+        {
+            return std::nullopt;
+        }
+
+        p_track->format_title(nullptr, mBuffer, mScript, nullptr);
+
+        return ParseSongInfo(std::string_view(mBuffer.get_ptr(), mBuffer.length()));
     }
 };
 
-class FormatScripts
+// Scripts of fields requested by server schemas. Each expression is compiled
+// once and kept while some schema uses it, fields not in schema aren't
+// evaluated at all.
+class FieldScripts
 {
-    TitleFormatScript mTitleScript;
-    TitleFormatScript mArtistScript;
-    TitleFormatScript mAlbumScript;
-    TitleFormatScript mDateScript;
-    TitleFormatScript mTrackNumberScript;
-    TitleFormatScript mLengthScript;
-    TitleFormatScript mPathScript;
-    TitleFormatScript mYearScript;
+    struct CompiledField
+    {
+        SchemaField             Field;
+        titleformat_object::ptr Script;
+    };
+
+    std::unordered_map<std::string, titleformat_object::ptr> mCompiled; // By expression text.
+    std::vector<CompiledField>                               mFields;   // Sorted by name.
+    pfc::string8                                             mBuffer;
 
 public:
-    FormatScripts()
-        : mTitleScript        ("%title%")
-        , mArtistScript       ("%artist%")
-        , mAlbumScript        ("%album%")
-        , mDateScript         ("%date%")
-        , mTrackNumberScript  ("%track number%")
-        , mLengthScript       ("%length_seconds_fp%")
-        , mPathScript         ("%path%")
-        , mYearScript         ("%year%")
+    auto SetSchema (const FieldSchema& schema) -> void
     {
+        auto compiled = std::unordered_map<std::string, titleformat_object::ptr>();
+
+        mFields.clear();
+        for (const auto& field : schema)
+        {
+            auto& script = compiled[field.Expression];
+            if (script.is_empty())
+            {
+                auto it = mCompiled.find(field.Expression);
+                if (it != mCompiled.end())
+                {
+                    script = it->second;
+                }
+                else
+                {
+                    auto compiler = static_api_ptr_t<titleformat_compiler>();
+                    compiler->compile_safe_ex(script, field.Expression.c_str());
+                }
+            }
+
+            mFields.push_back(CompiledField{ field, script });
+        }
+
+        mCompiled = std::move(compiled);
     }
 
-    inline auto GetTitle       (metadb_handle_ptr p_track) -> std::optional<std::string> { return mTitleScript      .GetInfo(p_track); }
-    inline auto GetAlbum       (metadb_handle_ptr p_track) -> std::optional<std::string> { return mArtistScript     .GetInfo(p_track); }
-    inline auto GetArtist      (metadb_handle_ptr p_track) -> std::optional<std::string> { return mAlbumScript      .GetInfo(p_track); }
-    inline auto GetDate        (metadb_handle_ptr p_track) -> std::optional<std::string> { return mDateScript       .GetInfo(p_track); }
-    inline auto GetTrackNumber (metadb_handle_ptr p_track) -> std::optional<std::string> { return mTrackNumberScript.GetInfo(p_track); }
-    inline auto GetLength      (metadb_handle_ptr p_track) -> std::optional<std::string> { return mLengthScript     .GetInfo(p_track); }
-    inline auto GetPath        (metadb_handle_ptr p_track) -> std::optional<std::string> { return mPathScript       .GetInfo(p_track); }
-    inline auto GetYear        (metadb_handle_ptr p_track) -> std::optional<std::string> { return mYearScript       .GetInfo(p_track); }
+    auto IsEmpty () const -> bool { return mFields.empty(); }
+
+    // Main thread only, buffer is shared between calls.
+    auto GetInfo (metadb_handle_ptr p_track) -> std::optional<CustomFields>
+    {
+        if (p_track.is_empty() || mFields.empty())
+        {
+            return std::nullopt;
+        }
+
+        auto fields = CustomFields();
+        fields.Values.reserve(mFields.size());
+        for (const auto& compiled : mFields)
+        {
+            p_track->format_title(nullptr, mBuffer, compiled.Script, nullptr);
+
+            auto formatted = std::string_view(mBuffer.get_ptr(), mBuffer.length());
+            const auto& field = compiled.Field;
+            fields.Values.push_back(CustomField{ field.Name, ParseFieldValue(formatted, field.Type), field.Expression, field.Type });
+        }
+
+        return fields;
+    }
 };
 
 } // namespace foo_showplay
@@ -0,0 +1,156 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "TrackPrefetcher.hpp"
+#include "Hash.hpp"
+
+namespace foo_showplay {
+
+TrackPrefetcher::TrackPrefetcher(CoverTranscoder::CodecFactory codecFactory)
+    : mCodecFactory (std::move(codecFactory))
+    , mPendingJob   (std::nullopt)
+    , mIsStopping   (false)
+{
+    mThread = std::thread([this]() { Run(); });
+}
+
+TrackPrefetcher::~TrackPrefetcher()
+{
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        mIsStopping = true;
+    }
+
+    mAbort.abort();
+    mCondition.notify_one();
+    mThread.join();
+}
+
+auto TrackPrefetcher::SetOnPrefetchedCallback(OnPrefetchedCallback callback) -> void
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    mOnPrefetchedCallback = std::move(callback);
+}
+
+auto TrackPrefetcher::Submit(metadb_handle_ptr track, CoverLimits limits, bool isBase64) -> void
+{
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        mPendingJob = Job{ std::move(track), limits, isBase64 };
+    }
+
+    mCondition.notify_one();
+}
+
+auto TrackPrefetcher::Run() -> void
+{
+    // Codec is created here, it may need thread specific setup.
+    auto codec = mCodecFactory();
+
+    for (;;)
+    {
+        auto job      = Job();
+        auto callback = OnPrefetchedCallback();
+        {
+            auto lock = std::unique_lock<std::mutex>(mMutex);
+            mCondition.wait(lock, [this]() { return mIsStopping || mPendingJob.has_value(); });
+
+            if (mIsStopping)
+            {
+                return;
+            }
+
+            job      = std::move(mPendingJob.value());
+            callback = mOnPrefetchedCallback;
+            mPendingJob.reset();
+        }
+
+        try
+        {
+            auto prefetched = Prepare(job, codec.get());
+            if (callback)
+            {
+                callback(std::move(prefetched));
+            }
+        }
+        catch (const exception_aborted&)
+        {
+            return;
+        }
+    }
+}
+
+auto TrackPrefetcher::Prepare(const Job& job, ImageCodec* codec) -> PrefetchedTrack
+{
+    auto prefetched  = PrefetchedTrack();
+    prefetched.Track = job.Track;
+    prefetched.Song  = mSongInfoScript.GetInfo(job.Track);
+
+    // Same art now playing notify would give, front cover.
+    auto art = album_art_data::ptr();
+    try
+    {
+        auto artManager = static_api_ptr_t<album_art_manager_v2>();
+        auto extractor  = artManager->open(
+            pfc::list_single_ref_t<metadb_handle_ptr>(job.Track),
+            pfc::list_single_ref_t<GUID>(album_art_ids::cover_front),
+            mAbort
+        );
+
+        art = extractor->query(album_art_ids::cover_front, mAbort);
+    }
+    catch (const exception_aborted&)
+    {
+        throw;
+    }
+    catch (const std::exception&)
+    {
+        // Track has no cover.
+        return prefetched;
+    }
+
+    if (art.is_empty())
+    {
+        return prefetched;
+    }
+
+    auto data = static_cast<const std::uint8_t*>(art->get_ptr());
+    auto size = static_cast<std::size_t>(art->get_size());
+
+    // Share image with foobar2000 instead of copying it.
+    auto ptr   = std::shared_ptr<const std::uint8_t>(data, [art](const std::uint8_t*) {});
+    auto image = BinaryData(std::move(ptr), size);
+    if (codec != nullptr && job.Limits.IsEnabled())
+    {
+        image = CoverTranscoder::Transcode(*codec, image, job.Limits);
+    }
+
+    if (job.IsBase64)
+    {
+        image.EncodeBase64();
+    }
+
+    prefetched.CoverHash = Hash64(data, size);
+    prefetched.Cover     = std::move(image);
+
+    return prefetched;
+}
+
+} // namespace foo_showplay
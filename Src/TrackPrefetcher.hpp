@@ -0,0 +1,94 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <foobar2000.h>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "CoverTranscoder.hpp"
+#include "Payload.hpp"
+#include "TitleFormatScripts.hpp"
+
+namespace foo_showplay {
+
+// Track expected to play next, formatted and with cover ready to send.
+struct PrefetchedTrack
+{
+    metadb_handle_ptr            Track;
+    std::optional<SongInfo>      Song;
+    std::optional<std::uint64_t> CoverHash; // Of original art, as now playing art is hashed.
+    BinaryData                   Cover;     // Transcoded and encoded, valid if CoverHash is.
+
+    PrefetchedTrack()
+        : Song      (std::nullopt)
+        , CoverHash (std::nullopt)
+    {
+    }
+};
+
+// Prepares next track on worker thread while current one plays, so track
+// change frame doesn't wait for titleformat, art extraction, transcoding
+// and base64. Results are meant to fill SongInfoCache and CoverCache.
+class TrackPrefetcher
+{
+public:
+    using OnPrefetchedCallback = std::function<void(PrefetchedTrack track)>;
+
+private:
+    struct Job
+    {
+        metadb_handle_ptr Track;
+        CoverLimits       Limits;
+        bool              IsBase64; // Some server gets cover inside JSON.
+    };
+
+    CoverTranscoder::CodecFactory mCodecFactory;
+    SongInfoScript                mSongInfoScript; // Used only on prefetch thread.
+    OnPrefetchedCallback          mOnPrefetchedCallback;
+    abort_callback_impl           mAbort;          // Cancels art extraction on stop.
+
+    std::mutex                    mMutex;
+    std::condition_variable       mCondition;
+    std::optional<Job>            mPendingJob; // Only latest prediction matters, older are replaced.
+    bool                          mIsStopping;
+    std::thread                   mThread;
+
+    auto Run     ()                                   -> void;
+    auto Prepare (const Job& job, ImageCodec* codec)  -> PrefetchedTrack;
+
+public:
+    TrackPrefetcher(CoverTranscoder::CodecFactory codecFactory);
+    ~TrackPrefetcher();
+
+    TrackPrefetcher(const TrackPrefetcher&)            = delete;
+    TrackPrefetcher& operator=(const TrackPrefetcher&) = delete;
+
+    // Callback is invoked on prefetch thread.
+    auto SetOnPrefetchedCallback (OnPrefetchedCallback callback) -> void;
+
+    auto Submit (metadb_handle_ptr track, CoverLimits limits, bool isBase64) -> void;
+};
+
+} // namespace foo_showplay
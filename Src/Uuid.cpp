@@ -0,0 +1,51 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "Uuid.hpp"
+
+namespace foo_showplay {
+
+static_assert(ParseUuid("0123abcd-4567-89ef-ABCD-0123456789ef").value() == Uuid{ 0x0123abcd456789efu, 0xabcd0123456789efu });
+static_assert(!ParseUuid("0123abcd-4567-89ef-abcd-0123456789eg").has_value());
+static_assert(!ParseUuid("0123abcd-4567-89ef-abcd+0123456789ef").has_value());
+
+auto FormatUuid(const Uuid& uuid) -> std::string
+{
+    static constexpr char hex[] = "0123456789abcdef";
+
+    auto str = std::string(36, '-');
+    auto pos = std::size_t(0);
+    for (auto i = 0; i < 32; ++i)
+    {
+        if (pos == 8 || pos == 13 || pos == 18 || pos == 23)
+        {
+            pos += 1;
+        }
+
+        auto half  = i < 16 ? uuid.High : uuid.Low;
+        auto shift = (15 - (i % 16)) * 4;
+        str[pos] = hex[(half >> shift) & 0xF];
+        pos += 1;
+    }
+
+    return str;
+}
+
+} // namespace foo_showplay
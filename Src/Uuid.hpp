@@ -0,0 +1,107 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace foo_showplay {
+
+// 128-bit UUID, e.g. token assigned by server.
+struct Uuid
+{
+    std::uint64_t High;
+    std::uint64_t Low;
+
+    constexpr auto operator== (const Uuid& other) const -> bool { return High == other.High && Low == other.Low; }
+    constexpr auto operator!= (const Uuid& other) const -> bool { return !(*this == other); }
+};
+
+namespace detail {
+
+// Hex digit value for every byte, -1 for anything else. Unlike std::isxdigit
+// doesn't depend on locale.
+inline constexpr auto HEX_DIGITS = []()
+{
+    auto table = std::array<std::int8_t, 256>();
+    for (auto& value : table)
+    {
+        value = -1;
+    }
+
+    for (auto c = 0; c < 10; ++c)
+    {
+        table['0' + c] = static_cast<std::int8_t>(c);
+    }
+
+    for (auto c = 0; c < 6; ++c)
+    {
+        table['a' + c] = static_cast<std::int8_t>(10 + c);
+        table['A' + c] = static_cast<std::int8_t>(10 + c);
+    }
+
+    return table;
+}();
+
+} // namespace detail
+
+// Parses canonical 8-4-4-4-12 form, hex digits in either case.
+constexpr auto ParseUuid(std::string_view str) -> std::optional<Uuid>
+{
+    if (str.size() != 36)
+    {
+        return std::nullopt;
+    }
+
+    auto uuid   = Uuid{ 0, 0 };
+    auto digits = 0;
+    for (auto i = std::size_t(0); i < str.size(); ++i)
+    {
+        auto c = static_cast<unsigned char>(str[i]);
+        if (i == 8 || i == 13 || i == 18 || i == 23)
+        {
+            if (c != '-')
+            {
+                return std::nullopt;
+            }
+            continue;
+        }
+
+        auto value = detail::HEX_DIGITS[c];
+        if (value < 0)
+        {
+            return std::nullopt;
+        }
+
+        auto& half = digits < 16 ? uuid.High : uuid.Low;
+        half = (half << 4) | static_cast<std::uint64_t>(value);
+        digits += 1;
+    }
+
+    return uuid;
+}
+
+// Formats as 36 characters, lowercase.
+auto FormatUuid (const Uuid& uuid) -> std::string;
+
+} // namespace foo_showplay
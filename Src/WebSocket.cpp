@@ -19,180 +19,779 @@
 
 #include "PCH.hpp"
 #include "WebSocket.hpp"
+#include "Constants.hpp"
+
+#include <ixwebsocket/IXUrlParser.h>
+#include <random>
 
 namespace foo_showplay {
 
 auto WebSocketClient::OnReceiveCallback(const ix::WebSocketMessagePtr& message) -> void
 {
+    auto now = Clock::now();
+    mLastReceive.store(now.time_since_epoch().count());
+
     switch (message->type)
     {
     case ix::WebSocketMessageType::Open:
         Reset();
+        {
+            auto lock = std::lock_guard<std::mutex>(mMutex);
+            mOpenedAt        = now;
+            mTimings.Connect = std::chrono::duration_cast<std::chrono::microseconds>(now - mAttemptStart) - mTimings.Dns;
+        }
+
+        // Wake supervisor, dead peer check runs while connected.
+        mCondition.notify_one();
         std::invoke(mOnConnectedCallback);
         break;
 
     case ix::WebSocketMessageType::Close:
         Reset();
+        ScheduleReconnect();
         std::invoke(mOnDisconnectedCallback);
         break;
 
+    case ix::WebSocketMessageType::Error:
+        // Attempt failed before connection was open.
+        ScheduleReconnect();
+        break;
+
     case ix::WebSocketMessageType::Message:
+    {
+        auto parsed = ParseServerMessage(message->str);
+
+        // Requests don't carry token and don't change activation state.
+        if (HandleAck(parsed) || HandleRequest(parsed) || HandleSchema(parsed))
+        {
+            break;
+        }
+
+        // State is published by IXWebSocket thread, and by supervisor in
+        // Attempt only after mContext.stop() joined this thread. Writers never
+        // overlap, so old state can be used as base. It's copied, writer
+        // holding a reader would keep replaced states from being freed.
+        auto oldState = *GetState();
+        auto newState = oldState;
+        if (parsed.TokenText != oldState.TokenText)
+        {
+            newState.Token     = parsed.Token;
+            newState.TokenText = std::move(parsed.TokenText);
+        }
+
         // Call callback only if state changes.
-        mToken = ParseToken(message->str);
-        if (mToken.has_value() && !mIsActive)
+        auto features = parsed.Features;
+        if (newState.Token.has_value() && !oldState.IsActive)
         {
-            mIsActive = true;
+            {
+                auto lock = std::lock_guard<std::mutex>(mMutex);
+                mTimings.Activation = std::chrono::duration_cast<std::chrono::microseconds>(now - mOpenedAt);
+                mPolicy.OnSuccess();
+                mMetrics.ActivationTime.Record(mTimings.Activation);
+            }
+
+            newState.Features = features;
+            newState.IsActive = true;
+            PublishState(std::move(newState));
             std::invoke(mOnActivatedCallback);
         }
-        else if (!mToken.has_value() && mIsActive)
+        else if (!newState.Token.has_value() && oldState.IsActive)
         {
-            mIsActive = false;
+            newState.Features = 0;
+            newState.IsActive = false;
+            newState.Schema   = nullptr;
+            PublishState(std::move(newState));
             std::invoke(mOnDeactivatedCallback);
         }
+        else if (oldState.IsActive && oldState.Features != features)
+        {
+            // Server switched protocol features, resend everything.
+            newState.Features = features;
+            PublishState(std::move(newState));
+            std::invoke(mOnActivatedCallback);
+        }
+        else if (newState.TokenText != oldState.TokenText)
+        {
+            PublishState(std::move(newState));
+        }
+        break;
+    }
+
+    default:
         break;
     }
 }
 
-auto WebSocketClient::Reset() -> void
+auto WebSocketClient::Supervise() -> void
 {
-    mToken    = std::nullopt;
-    mIsActive = false;
-    mFrame    = 0;
+    auto lock = std::unique_lock<std::mutex>(mMutex);
+    while (!mIsStopping)
+    {
+        // Dead peer check polls only while connected.
+        auto isWatching = IsConnected() && mPolicy.GetSettings().DeadPeerTimeout.count() > 0;
+        if (mNextAttempt.has_value())
+        {
+            mCondition.wait_until(lock, mNextAttempt.value());
+        }
+        else if (isWatching)
+        {
+            mCondition.wait_for(lock, DEAD_PEER_CHECK_INTERVAL);
+        }
+        else
+        {
+            mCondition.wait(lock);
+        }
+
+        if (mIsStopping)
+        {
+            return;
+        }
+
+        auto now = Clock::now();
+        if (mNextAttempt.has_value() && now >= mNextAttempt.value())
+        {
+            mNextAttempt.reset();
+
+            lock.unlock();
+            Attempt();
+            lock.lock();
+        }
+        else if (IsDeadPeer(now))
+        {
+            // Close is reported by callback, which schedules reconnect.
+            mLastReceive.store(now.time_since_epoch().count());
+
+            lock.unlock();
+            {
+                auto controlLock = std::lock_guard<std::mutex>(mControlMutex);
+                mContext.close();
+            }
+            lock.lock();
+        }
+    }
 }
 
-auto WebSocketClient::ParseToken(std::string message) const -> std::optional<std::string>
+auto WebSocketClient::Attempt() -> void
 {
-    // Try to deserialize json. And parse token.
-    auto json = nlohmann::json::parse(message, nullptr, false);
-    if (!json.is_discarded())
+    auto url = std::string();
+    auto pingInterval = std::chrono::seconds(0);
     {
-        auto tokenIt = json.find<std::string>("Token");
-        if (tokenIt != json.end())
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        if (!mIsWanted)
         {
-            if (tokenIt.value().is_string())
-            {
-                auto tokenStr = std::string();
-                tokenIt.value().get_to<std::string>(tokenStr);
+            return;
+        }
 
-                if (ValidateToken(tokenStr))
-                {
-                    return tokenStr;
-                }
-            }
+        url          = mUrl;
+        pingInterval = mPolicy.GetSettings().PingInterval;
+        mPolicy.OnAttempt();
+    }
+
+    // Resolved separately so lookup time is known, IXWebSocket's own lookup
+    // then hits system cache.
+    auto start      = Clock::now();
+    auto isResolved = ResolveHost(url);
+    auto dns        = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+
+    auto controlLock = std::lock_guard<std::mutex>(mControlMutex);
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+
+        // Disconnected or reconnected elsewhere during lookup.
+        if (!mIsWanted || mUrl != url)
+        {
+            return;
         }
+
+        mTimings      = ConnectTimings();
+        mTimings.Dns  = dns;
+        mAttemptStart = start;
+
+        if (!isResolved)
+        {
+            mNextAttempt = Clock::now() + mPolicy.OnFailure();
+            return;
+        }
+    }
+
+    // Thread of previous attempt ended with its connection. Reset relies on
+    // it, that thread publishes state too.
+    mContext.stop();
+    Reset();
+
+    {
+        // Stopping live connection reports close, which isn't a failure.
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        mNextAttempt.reset();
     }
 
-    return std::nullopt;
+    mContext.setUrl(url);
+    mContext.setPingInterval(static_cast<int>(pingInterval.count()));
+    mContext.start();
 }
 
-auto WebSocketClient::ValidateToken(std::string token) const -> bool
+auto WebSocketClient::ScheduleReconnect() -> void
 {
-    auto validTokenLength = 36;
-    if (token.length() != validTokenLength)
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        if (!mIsWanted || mNextAttempt.has_value())
+        {
+            return;
+        }
+
+        mNextAttempt = Clock::now() + mPolicy.OnFailure();
+    }
+
+    mMetrics.Reconnects.Add();
+    mCondition.notify_one();
+}
+
+auto WebSocketClient::IsDeadPeer(Clock::time_point now) const -> bool
+{
+    auto timeout = mPolicy.GetSettings().DeadPeerTimeout;
+    if (timeout.count() <= 0 || !IsConnected())
+    {
+        return false;
+    }
+
+    auto lastReceive = Clock::time_point(Clock::duration(mLastReceive.load()));
+    return now - lastReceive > timeout;
+}
+
+auto WebSocketClient::ResolveHost(const std::string& url) -> bool
+{
+    auto protocol = std::string();
+    auto host     = std::string();
+    auto path     = std::string();
+    auto query    = std::string();
+    auto port     = 0;
+    if (!ix::UrlParser::parse(url, protocol, host, path, query, port))
+    {
+        return false;
+    }
+
+    auto hints = addrinfo();
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    auto result = static_cast<addrinfo*>(nullptr);
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0)
+    {
+        return false;
+    }
+
+    freeaddrinfo(result);
+    return true;
+}
+
+auto WebSocketClient::Reset() -> void
+{
+    // Called on IXWebSocket thread and from supervisor's Attempt. The latter
+    // runs after mContext.stop() joined IXWebSocket thread and before
+    // start() spawns new one, so state has one writer at a time.
+
+    // New connection, frames prepared for old one are dropped.
+    auto state  = ConnectionState();
+    state.Epoch = GetState()->Epoch + 1;
+
+    mFrame.store(0);
+    mBase.store(-1);
+    mAcks.Reset(state.Epoch);
+    PublishState(std::move(state));
+}
+
+auto WebSocketClient::HandleRequest(const ServerMessage& message) -> bool
+{
+    if (!message.IsObject || message.HasToken || !message.Request.has_value())
     {
         return false;
     }
 
-    auto i = 0;
-    for (auto c : token)
+    // Ignore requests until activated, they will be answered by activation.
+    if (!GetState()->IsActive)
+    {
+        return true;
+    }
+
+    const auto& request = message.Request.value();
+    if (request == REQUEST_SNAPSHOT)
+    {
+        std::invoke(mOnSnapshotRequestCallback);
+    }
+    else if (request == REQUEST_COVER)
     {
-        if (i == 8 || i == 13 || i == 18 || i == 23)
+        if (message.Hash.has_value())
         {
-            if (c != '-')
-            {
-                return false;
-            }
+            std::invoke(mOnCoverRequestCallback, message.Hash.value());
+        }
+    }
+
+    return true;
+}
+
+auto WebSocketClient::HandleSchema(const ServerMessage& message) -> bool
+{
+    if (!message.IsObject || message.HasToken || !message.Schema.has_value())
+    {
+        return false;
+    }
+
+    // Schema belongs to activated connection, server sends it after token.
+    auto newState = *GetState();
+    if (!newState.IsActive)
+    {
+        return true;
+    }
+
+    newState.Schema = std::make_shared<const FieldSchema>(message.Schema.value());
+    PublishState(std::move(newState));
+    std::invoke(mOnSchemaCallback);
+
+    return true;
+}
+
+auto WebSocketClient::HandleAck(const ServerMessage& message) -> bool
+{
+    if (!message.IsObject || message.HasToken || !message.Ack.has_value())
+    {
+        return false;
+    }
+
+    // Without receive time only round trip would be known, such ack is
+    // ignored rather than half measured. Millisecond time of older servers
+    // still works, with uplink delay as coarse as that.
+    if (message.TimeUs.has_value())
+    {
+        mAcks.OnAck(message.Ack.value(), message.TimeUs.value());
+    }
+    else if (message.Time.has_value())
+    {
+        mAcks.OnAck(message.Ack.value(), message.Time.value() * 1000);
+    }
+
+    return true;
+}
+
+auto GetNegotiatedFields(const ConnectionState& state) -> FieldMasks<Payload>
+{
+    static constexpr auto playbackIndex   = FieldIndex(Payload::FieldNames, "Playback");
+    static constexpr auto coverIndex      = FieldIndex(Payload::FieldNames, "Cover");
+    static constexpr auto syncIndex       = FieldIndex(Payload::FieldNames, "Sync");
+    static constexpr auto fieldsIndex     = FieldIndex(Payload::FieldNames, "Fields");
+    static constexpr auto statsIndex      = FieldIndex(Payload::FieldNames, "Stats");
+    static constexpr auto rateIndex       = FieldIndex(PlaybackInfo::FieldNames, "Rate");
+    static constexpr auto timestampIndex  = FieldIndex(PlaybackInfo::FieldNames, "Timestamp");
+    static constexpr auto attachmentIndex = FieldIndex(CoverInfo::FieldNames, "Attachment");
+    static constexpr auto hashIndex       = FieldIndex(CoverInfo::FieldNames, "Hash");
+
+    auto masks = FieldMasks<Payload>();
+    for (auto& mask : masks.Fields)
+    {
+        mask = ALL_FIELDS;
+    }
+
+    if (!state.HasFeature(ServerFeature::Anchor))
+    {
+        masks.Fields[playbackIndex] &= ~((FieldMask(1) << rateIndex) | (FieldMask(1) << timestampIndex));
+    }
+
+    if (!state.HasFeature(ServerFeature::CoverHash))
+    {
+        masks.Fields[coverIndex] &= ~(FieldMask(1) << hashIndex);
+    }
+
+    if (!state.HasFeature(ServerFeature::BinaryCover))
+    {
+        masks.Fields[coverIndex] &= ~(FieldMask(1) << attachmentIndex);
+    }
+
+    if (!state.HasFeature(ServerFeature::Sync))
+    {
+        masks.Fields[syncIndex] = 0;
+    }
+
+    if (!state.HasFeature(ServerFeature::Stats))
+    {
+        masks.Fields[statsIndex] = 0;
+    }
+
+    if (state.Schema == nullptr)
+    {
+        masks.Fields[fieldsIndex] = 0;
+    }
+
+    return masks;
+}
+
+template <typename Writer>
+auto WebSocketClient::WriteFrame(
+    Writer&                    writer,
+    const ConnectionState&     state,
+    int                        frame,
+    const Payload&             payload,
+    const FieldMasks<Payload>& masks,
+    const SharedPayload*       shared,
+    bool                       isDelta
+) const -> void
+{
+    static_assert(Payload::FieldNames[0] > "Base", "Base must be first field of frame");
+
+    auto negotiated = GetNegotiatedFields(state);
+    for (auto i = std::size_t(0); i < Payload::FieldCount; ++i)
+    {
+        negotiated.Fields[i] &= masks.Fields[i];
+    }
+
+    auto writeSections = [&](std::string_view first, std::string_view last)
+    {
+        if (shared != nullptr)
+        {
+            WriteSharedSections(writer, payload, *shared, negotiated, first, last);
         }
         else
         {
-            if (std::isalnum(c) == 0)
-            {
-                return false;
-            }
+            WriteSections(writer, payload, negotiated, first, last);
         }
+    };
 
-        i += 1;
+    // Keys are written in the same order as nlohmann::json would dump them:
+    // Base, sections up to Frame, Frame, sections up to Token, Token, rest.
+    writer.BeginObject();
+
+    // Delta frame is relative to last state frame that got out, not to
+    // previous number. Failed frames and cover attachments have numbers too.
+    // Server requests snapshot if it didn't receive Base frame.
+    if (isDelta)
+    {
+        writer.Key("Base");
+        writer.Integer(mBase.load());
     }
 
+    writeSections("", "Frame");
+
+    writer.Key("Frame");
+    writer.Integer(frame);
+
+    writeSections("Frame", "Token");
+
+    writer.Key("Token");
+    if (state.TokenText.has_value())
+    {
+        writer.String(state.TokenText.value());
+    }
+    else
+    {
+        writer.Null();
+    }
+
+    writeSections("Token", "");
+
+    writer.EndObject();
+}
+
+auto WebSocketClient::PreparePayload(
+    const ConnectionState&     state,
+    int                        frame,
+    const Payload&             payload,
+    const FieldMasks<Payload>& masks,
+    const SharedPayload*       shared,
+    bool                       isDelta
+) -> const std::string&
+{
+    auto start = Clock::now();
+    mBuffer.clear();
+
+    if (state.HasFeature(ServerFeature::Cbor))
+    {
+        auto writer = CborWriter(mBuffer);
+        WriteFrame(writer, state, frame, payload, masks, shared, isDelta);
+    }
+    else
+    {
+        auto writer = JsonWriter(mBuffer);
+        WriteFrame(writer, state, frame, payload, masks, shared, isDelta);
+    }
+
+    mMetrics.SerializeTime.Record(Clock::now() - start);
+    return mBuffer;
+}
+
+auto WebSocketClient::SendPayload(
+    const Payload&             payload,
+    const FieldMasks<Payload>& masks,
+    const SharedPayload*       shared,
+    bool                       isDelta
+) -> bool
+{
+    // Send image out of band if it's sent at all.
+    static constexpr auto imageIndex = FieldIndex(CoverInfo::FieldNames, "Image");
+    static constexpr auto coverIndex = FieldIndex(Payload::FieldNames, "Cover");
+
+    auto state = GetState();
+
+    auto coverMask = masks.Fields[coverIndex];
+    auto hasImage  = payload.Cover.has_value() && payload.Cover.value().Image.has_value();
+    if (state->HasFeature(ServerFeature::BinaryCover) && !state->HasFeature(ServerFeature::Cbor) &&
+        hasImage && (coverMask & (FieldMask(1) << imageIndex)) != 0)
+    {
+        return SendWithAttachment(*state, payload, masks, shared, isDelta);
+    }
+
+    auto frame = mFrame.fetch_add(1);
+    const auto& data = PreparePayload(*state, frame, payload, masks, shared, isDelta);
+
+    // Connection changed while frame was written, it belongs to old one.
+    if (GetState()->Epoch != state->Epoch)
+    {
+        return false;
+    }
+
+    if (!SendTracked(*state, frame, data, state->HasFeature(ServerFeature::Cbor)))
+    {
+        return false;
+    }
+
+    mBase.store(frame);
+    mLastFrame = FrameId(state->Epoch, frame, state->HasFeature(ServerFeature::Ack));
     return true;
 }
 
-auto WebSocketClient::PreparePayload(nlohmann::json json) const -> std::string
+auto WebSocketClient::SendFrame(const ConnectionState& state, const std::string& data, bool isBinary) -> bool
 {
-    json["Token"] = mToken.has_value() ? mToken.value() : nullptr;
-    json["Frame"] = mFrame;
+    // Small frames go raw, compressing them costs more than it saves.
+    if (state.HasFeature(ServerFeature::Deflate) && data.size() >= COMPRESSION_THRESHOLD)
+    {
+        auto dictionary = state.HasFeature(ServerFeature::SongDictionary) ? CompressionDictionary::Song
+                                                                           : CompressionDictionary::None;
+        auto compressed = mCompressor.Compress(data, dictionary);
+        if (compressed != nullptr)
+        {
+            auto start = Clock::now();
+            return RecordSend(start, mContext.sendBinary(*compressed));
+        }
+    }
 
-    return json.dump(4);
+    auto start = Clock::now();
+    if (isBinary)
+    {
+        return RecordSend(start, mContext.sendBinary(data));
+    }
+
+    return RecordSend(start, mContext.sendText(data));
+}
+
+auto WebSocketClient::SendTracked(const ConnectionState& state, int frame, const std::string& data, bool isBinary) -> bool
+{
+    if (!state.HasFeature(ServerFeature::Ack))
+    {
+        return SendFrame(state, data, isBinary);
+    }
+
+    // Tracked before send, ack may arrive before send call returns. Frame
+    // number taken before reconnect is ignored by its epoch.
+    mAcks.OnSent(frame, state.Epoch);
+    if (!SendFrame(state, data, isBinary))
+    {
+        mAcks.OnFailed(frame, state.Epoch);
+        return false;
+    }
+
+    return true;
+}
+
+auto WebSocketClient::RecordSend(Clock::time_point start, const ix::WebSocketSendInfo& sendInfo) -> bool
+{
+    mMetrics.SendTime.Record(Clock::now() - start);
+    mMetrics.BytesSent.Add(sendInfo.wireSize);
+
+    return sendInfo.success;
+}
+
+auto WebSocketClient::SendWithAttachment(
+    const ConnectionState&     state,
+    const Payload&             payload,
+    const FieldMasks<Payload>& masks,
+    const SharedPayload*       shared,
+    bool                       isDelta
+) -> bool
+{
+    static constexpr auto attachmentIndex = FieldIndex(CoverInfo::FieldNames, "Attachment");
+    static constexpr auto coverIndex      = FieldIndex(Payload::FieldNames, "Cover");
+
+    // Both frame numbers are reserved at once, image must directly follow.
+    auto frame = mFrame.fetch_add(2);
+
+    // Metadata frame first, image bytes follow as next frame. Copy is cheap,
+    // image itself is shared.
+    auto image    = payload.Cover.value().Image.value();
+    auto metadata = payload;
+    metadata.Cover.value().Image      = std::nullopt;
+    metadata.Cover.value().Attachment = frame + 1;
+
+    auto metadataMasks = masks;
+    metadataMasks.Fields[coverIndex] |= FieldMask(1) << attachmentIndex;
+
+    const auto& text = PreparePayload(state, frame, metadata, metadataMasks, shared, isDelta);
+    if (GetState()->Epoch != state.Epoch || !SendTracked(state, frame, text, false))
+    {
+        return false;
+    }
+
+    // Straight from album_art_data, without copying.
+    auto data  = reinterpret_cast<const char*>(image.Data.get());
+    auto start = Clock::now();
+    if (!RecordSend(start, mContext.sendBinary(ix::IXWebSocketSendData(data, image.Size))))
+    {
+        return false;
+    }
+
+    // State is complete with image only, metadata frame becomes base. Image
+    // itself isn't acknowledged, metadata frame stands for both.
+    mBase.store(frame);
+    mLastFrame = FrameId(state.Epoch, frame, state.HasFeature(ServerFeature::Ack));
+    return true;
 }
 
-WebSocketClient::WebSocketClient()
-    : mToken    (std::nullopt)
-    , mIsActive (false)
-    , mFrame    (0)
+WebSocketClient::WebSocketClient(ReconnectSettings settings, Metrics& metrics)
+    : mState       (ConnectionState())
+    , mFrame       (0)
+    , mBase        (-1)
+    , mCompressor  (COMPRESSION_LEVEL)
+    , mMetrics     (metrics)
+    , mAcks        (metrics)
+    , mPolicy      (settings, std::random_device()() ^ Clock::now().time_since_epoch().count())
+    , mIsWanted    (false)
+    , mIsStopping  (false)
+    , mNextAttempt (std::nullopt)
+    , mLastReceive (0)
     , mOnConnectedCallback    ([]{})
     , mOnDisconnectedCallback ([]{})
     , mOnActivatedCallback    ([]{})
     , mOnDeactivatedCallback  ([]{})
+    , mOnSnapshotRequestCallback ([]{})
+    , mOnCoverRequestCallback    ([](std::string){})
+    , mOnSchemaCallback          ([]{})
 {
-    // Enabled by default.
+    // Enabled by default. It would compress every frame, including tiny
+    // playback ones and JPEG covers, large frames are compressed by us.
     mContext.disablePerMessageDeflate();
 
+    // Its fixed backoff brings every client back at the same moment.
+    mContext.disableAutomaticReconnection();
+
     mContext.setOnMessageCallback(
         [this](const ix::WebSocketMessagePtr& message)
         {
             OnReceiveCallback(message);
         }
     );
+
+    mSupervisor = std::thread([this]() { Supervise(); });
 }
 
 WebSocketClient::~WebSocketClient()
 {
     Disconnect();
+
+    {
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        mIsStopping = true;
+    }
+
+    mCondition.notify_one();
+    mSupervisor.join();
 }
 
 auto WebSocketClient::TryConnect(std::string url) -> bool
 {
-    // Address changed. Disconnect and connect to new server.
-    if (mContext.getUrl() != url)
     {
-        Disconnect();
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+
+        // Already connecting/connected, lost connection is retried anyway.
+        if (mIsWanted && mUrl == url)
+        {
+            return false;
+        }
+
+        // Explicit request, connect now. Address change replaces connection.
+        mIsWanted    = true;
+        mUrl         = url;
+        mNextAttempt = Clock::now();
+        mPolicy.OnSuccess();
     }
 
-    // Don't try to connect if connecting/connected/closing.
-    if (mContext.getReadyState() != ix::ReadyState::Closed)
+    mCondition.notify_one();
+    return true;
+}
+
+auto WebSocketClient::Send(const Payload& payload, const SharedPayload* shared) -> bool
+{
+    if (!IsConnected())
     {
         return false;
     }
 
-    Reset();
+    // Full frame, every section even if null.
+    auto masks = FieldMasks<Payload>();
+    for (auto& mask : masks.Fields)
+    {
+        mask = ALL_FIELDS;
+    }
 
-    // Connect.
-    mContext.setUrl(url);
-    mContext.start();
-    
-    return true;
+    return SendPayload(payload, masks, shared, false);
 }
 
-auto WebSocketClient::Send(const nlohmann::json json) -> void
+auto WebSocketClient::SendDelta(const Payload& payload, const FieldMasks<Payload>& masks, const SharedPayload* shared) -> bool
 {
     if (!IsConnected())
     {
-        return;
+        return false;
+    }
+
+    // Delta without state frame server has makes no sense.
+    if (mBase.load() < 0)
+    {
+        return false;
     }
 
-    auto payload = PreparePayload(json);
-    auto sendInfo = mContext.sendText(payload);
-    mFrame += 1;
+    return SendPayload(payload, masks, shared, true);
 }
 
 auto WebSocketClient::Disconnect() -> void
 {
-    if (!IsConnected())
     {
-        return;
+        auto lock = std::lock_guard<std::mutex>(mMutex);
+        mIsWanted = false;
+        mNextAttempt.reset();
     }
 
+    // Stops socket that is still connecting too.
+    auto controlLock = std::lock_guard<std::mutex>(mControlMutex);
     mContext.stop();
 }
 
+auto WebSocketClient::SetReconnectSettings(ReconnectSettings settings) -> void
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    mPolicy.SetSettings(settings);
+}
+
+auto WebSocketClient::GetServerUrl() const -> std::string
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    return mUrl;
+}
+
+auto WebSocketClient::GetConnectTimings() const -> ConnectTimings
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    return mTimings;
+}
+
+auto WebSocketClient::GetCircuitState() const -> CircuitState
+{
+    auto lock = std::lock_guard<std::mutex>(mMutex);
+    return mPolicy.GetState();
+}
+
 } // namespace foo_showplay
@@ -20,50 +20,221 @@
 #pragma once
 
 #include <ixwebsocket/IXWebSocket.h>
-#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <optional>
+#include <thread>
+
+#include "AckTracker.hpp"
+#include "AtomicSnapshot.hpp"
+#include "FieldSchema.hpp"
+#include "FrameCompressor.hpp"
+#include "Metrics.hpp"
+#include "Payload.hpp"
+#include "ReconnectPolicy.hpp"
+#include "ServerMessage.hpp"
+#include "SharedPayload.hpp"
+#include "Uuid.hpp"
 
 namespace foo_showplay {
 
+// Optional protocol features advertised by server alongside the token.
+enum class ServerFeature : unsigned
+{
+    None           = 0,
+    Delta          = 1 << 0, // Frames carry only changed fields, relative to Base frame.
+    Cbor           = 1 << 1, // Frames are sent as binary CBOR instead of JSON text.
+    CoverHash      = 1 << 2, // Server caches covers, known ones are sent as Hash only.
+    BinaryCover    = 1 << 3, // Cover image is sent as separate binary message.
+    Anchor         = 1 << 4, // Server extrapolates Elapsed from anchors, no per second updates.
+    Deflate        = 1 << 5, // Large frames are sent compressed, see FrameCompressor.
+    SongDictionary = 1 << 6, // Server has Song preset dictionary for compressed frames.
+    Stats          = 1 << 7, // Server wants periodic Stats section with client metrics.
+    Ack            = 1 << 8, // Server acknowledges every frame with time it received it.
+    Sync           = 1 << 9, // Snapshot after reconnect tells what server missed, see SyncInfo.
+};
+
+// Connection state is never modified, new one is published instead. Reader
+// on any thread gets token, features and epoch that belong together.
+struct ConnectionState
+{
+    std::optional<Uuid>                Token;
+    std::optional<std::string>         TokenText; // Token as server sent it, written to every frame.
+    bool                               IsActive;
+    unsigned                           Features;
+    unsigned                           Epoch;     // Changes on every connect and disconnect.
+    std::shared_ptr<const FieldSchema> Schema;    // Sent by server after activation, null if none.
+
+    ConnectionState()
+        : Token     (std::nullopt)
+        , TokenText (std::nullopt)
+        , IsActive  (false)
+        , Features  (0)
+        , Epoch     (0)
+        , Schema    (nullptr)
+    {
+    }
+
+    auto HasFeature (ServerFeature feature) const -> bool { return (Features & static_cast<unsigned>(feature)) != 0; }
+};
+
+// Fields server may get, by section. Sections and fields of features server
+// didn't negotiate are never written, server without any gets the same keys
+// as before features existed.
+auto GetNegotiatedFields (const ConnectionState& state) -> FieldMasks<Payload>;
+
+// Frame as numbered on its connection, numbers start over with each one.
+struct FrameId
+{
+    unsigned Epoch;
+    int      Frame;     // -1 if none.
+    bool     IsTracked; // Server acknowledges it, Ack feature was negotiated.
+
+    FrameId()
+        : Epoch     (0)
+        , Frame     (-1)
+        , IsTracked (false)
+    {
+    }
+
+    FrameId(unsigned epoch, int frame, bool isTracked)
+        : Epoch     (epoch)
+        , Frame     (frame)
+        , IsTracked (isTracked)
+    {
+    }
+};
+
+// Duration of connection phases of last attempt.
+struct ConnectTimings
+{
+    std::chrono::microseconds Dns;        // Host name lookup.
+    std::chrono::microseconds Connect;    // TCP, TLS and upgrade, IXWebSocket doesn't report them apart.
+    std::chrono::microseconds Activation; // From open until server sent token.
+
+    ConnectTimings()
+        : Dns        (0)
+        , Connect    (0)
+        , Activation (0)
+    {
+    }
+};
+
 class WebSocketClient
 {
-    ix::WebSocket              mContext;
-    std::optional<std::string> mToken;
-    bool                       mIsActive;
-    int                        mFrame;
+    using Clock = std::chrono::steady_clock;
 
-    std::function<void()> mOnConnectedCallback;
-    std::function<void()> mOnDisconnectedCallback;
-    std::function<void()> mOnActivatedCallback;
-    std::function<void()> mOnDeactivatedCallback;
+    ix::WebSocket                          mContext;
+    AtomicSnapshot<ConnectionState>        mState;
+    std::atomic<int>                       mFrame;  // Next frame number.
+    std::atomic<int>                       mBase;   // Last state frame sent whole, -1 if none. Base of next delta.
+    FrameId                                mLastFrame; // Last frame that got out, sender thread only.
+    std::string                            mBuffer; // Reused for every frame.
+    FrameCompressor                        mCompressor;
+    Metrics&                               mMetrics; // Owned by session, shared by its endpoints.
+    AckTracker                             mAcks;    // Used only with Ack feature.
+
+    // Reconnection is driven by supervisor thread, not by IXWebSocket.
+    mutable std::mutex               mMutex;        // Guards members below.
+    std::mutex                       mControlMutex; // Serializes start and stop of mContext.
+    std::condition_variable          mCondition;
+    ReconnectPolicy                  mPolicy;
+    std::string                      mUrl;
+    bool                             mIsWanted;     // Connection requested, lost one is retried.
+    bool                             mIsStopping;
+    std::optional<Clock::time_point> mNextAttempt;
+    Clock::time_point                mAttemptStart;
+    Clock::time_point                mOpenedAt;
+    ConnectTimings                   mTimings;
+    std::atomic<Clock::rep>          mLastReceive;  // Any message or pong, for dead peer check.
+    std::thread                      mSupervisor;
+
+    std::function<void()>            mOnConnectedCallback;
+    std::function<void()>            mOnDisconnectedCallback;
+    std::function<void()>            mOnActivatedCallback;
+    std::function<void()>            mOnDeactivatedCallback;
+    std::function<void()>            mOnSnapshotRequestCallback;
+    std::function<void(std::string)> mOnCoverRequestCallback;
+    std::function<void()>            mOnSchemaCallback;
 
     auto OnReceiveCallback (const ix::WebSocketMessagePtr& message) -> void;
     auto Reset () -> void;
 
-    auto ParseToken     (std::string message) const -> std::optional<std::string>;
-    auto ValidateToken  (std::string token)   const -> bool;
-    auto PreparePayload (nlohmann::json json) const -> std::string;
+    auto Supervise         () -> void;
+    auto Attempt           () -> void;
+    auto ScheduleReconnect () -> void;
+    auto IsDeadPeer        (Clock::time_point now) const -> bool;
+
+    static auto ResolveHost (const std::string& url) -> bool;
+
+    // Never blocks, send path reads state once per frame.
+    auto GetState     () const -> AtomicSnapshot<ConnectionState>::Reader { return mState.Read(); }
+    auto PublishState (ConnectionState state) -> void { mState.Publish(std::move(state)); }
+
+    auto HandleRequest     (const ServerMessage& message) -> bool;
+    auto HandleSchema      (const ServerMessage& message) -> bool;
+    auto HandleAck         (const ServerMessage& message) -> bool;
+    auto SendFrame         (const ConnectionState& state, const std::string& data, bool isBinary) -> bool;
+    auto SendTracked       (const ConnectionState& state, int frame, const std::string& data, bool isBinary) -> bool;
+    auto SendPayload       (const Payload& payload, const FieldMasks<Payload>& masks, const SharedPayload* shared, bool isDelta) -> bool;
+    auto RecordSend        (Clock::time_point start, const ix::WebSocketSendInfo& sendInfo) -> bool;
+
+    // Frame is written with one state, even if connection changes meanwhile.
+    auto PreparePayload     (const ConnectionState& state, int frame, const Payload& payload, const FieldMasks<Payload>& masks, const SharedPayload* shared, bool isDelta) -> const std::string&;
+    auto SendWithAttachment (const ConnectionState& state, const Payload& payload, const FieldMasks<Payload>& masks, const SharedPayload* shared, bool isDelta) -> bool;
+
+    template <typename Writer>
+    auto WriteFrame (Writer& writer, const ConnectionState& state, int frame, const Payload& payload, const FieldMasks<Payload>& masks, const SharedPayload* shared, bool isDelta) const -> void;
 
 public:
-    WebSocketClient();
+    WebSocketClient(ReconnectSettings settings, Metrics& metrics);
     ~WebSocketClient();
 
     auto SetOnConnectedCallback    (std::function<void()> callback) { mOnConnectedCallback    = callback; }
     auto SetOnDisconnectedCallback (std::function<void()> callback) { mOnDisconnectedCallback = callback; }
     auto SetOnActivatedCallback    (std::function<void()> callback) { mOnActivatedCallback    = callback; }
     auto SetOnDeactivatedCallback  (std::function<void()> callback) { mOnDeactivatedCallback  = callback; }
+    auto SetOnSnapshotRequestCallback (std::function<void()> callback) { mOnSnapshotRequestCallback = callback; }
+    auto SetOnCoverRequestCallback    (std::function<void(std::string)> callback) { mOnCoverRequestCallback = callback; }
+    auto SetOnSchemaCallback          (std::function<void()> callback) { mOnSchemaCallback = callback; }
     
     auto TryConnect (const std::string addr)    -> bool;
-    auto Send       (const nlohmann::json json) -> void;
+    // Shared payload, if given, is the one payload was copied from. Its
+    // already encoded sections are reused by every endpoint. Return false if
+    // frame was dropped.
+    auto Send       (const Payload& payload, const SharedPayload* shared = nullptr) -> bool;
+    auto SendDelta  (const Payload& payload, const FieldMasks<Payload>& masks, const SharedPayload* shared = nullptr) -> bool;
     auto Disconnect ()                          -> void;
 
+    // Frame last successful Send or SendDelta got out as. Sender thread only.
+    auto GetLastFrame () const -> FrameId { return mLastFrame; }
+    auto GetAckState  (const FrameId& frame) -> AckState { return mAcks.GetAckState(frame.Frame, frame.Epoch); }
+
+    // Applies from next attempt.
+    auto SetReconnectSettings (ReconnectSettings settings) -> void;
+
     auto IsConnected  () const -> bool { return mContext.getReadyState() == ix::ReadyState::Open; }
-    auto IsActive     () const -> bool { return mIsActive && IsConnected(); }
+    auto IsActive     () const -> bool { return GetState()->IsActive && IsConnected(); }
+    auto HasFeature   (ServerFeature feature) const -> bool { return GetState()->HasFeature(feature); }
+    auto GetEpoch     () const -> unsigned { return GetState()->Epoch; }
+
+    // Whether cover image ends up as base64 string inside JSON frame.
+    auto IsCoverBase64 () const -> bool
+    {
+        auto state = GetState();
+        return !state->HasFeature(ServerFeature::Cbor) && !state->HasFeature(ServerFeature::BinaryCover);
+    }
 
-    auto GetToken     () const -> std::optional<std::string> { return mToken;            }
-    auto GetServerUrl () const -> std::string                { return mContext.getUrl(); }
+    auto GetToken     () const -> std::optional<std::string> { return GetState()->TokenText; }
+    auto GetSchema    () const -> std::shared_ptr<const FieldSchema> { return GetState()->Schema; }
+    auto GetServerUrl      () const -> std::string;
+    auto GetConnectTimings () const -> ConnectTimings;
+    auto GetCircuitState   () const -> CircuitState;
 };
 
 } // namespace foo_showplay
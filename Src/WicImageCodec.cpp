@@ -0,0 +1,221 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#include "PCH.hpp"
+#include "WicImageCodec.hpp"
+
+namespace foo_showplay {
+
+static const auto WIC_PIXEL_FORMAT = GUID_WICPixelFormat24bppBGR;
+
+WicImageCodec::WicImageCodec()
+    : mFactory          (nullptr)
+    , mIsComInitialized (false)
+{
+    // Codec lives on its own thread, which needs COM initialized.
+    mIsComInitialized = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+
+    auto hr = CoCreateInstance(
+        CLSID_WICImagingFactory,
+        nullptr,
+        CLSCTX_INPROC_SERVER,
+        IID_PPV_ARGS(&mFactory)
+    );
+    if (FAILED(hr))
+    {
+        mFactory = nullptr;
+    }
+}
+
+WicImageCodec::~WicImageCodec()
+{
+    mFactory = nullptr;
+
+    if (mIsComInitialized)
+    {
+        CoUninitialize();
+    }
+}
+
+auto WicImageCodec::CopyPixels(IWICBitmapSource* source) -> std::optional<DecodedImage>
+{
+    auto width  = UINT(0);
+    auto height = UINT(0);
+    if (FAILED(source->GetSize(&width, &height)) || width == 0 || height == 0)
+    {
+        return std::nullopt;
+    }
+
+    auto image = DecodedImage(width, height);
+    auto hr    = source->CopyPixels(
+        nullptr,
+        image.Stride,
+        static_cast<UINT>(image.Pixels.size()),
+        image.Pixels.data()
+    );
+    if (FAILED(hr))
+    {
+        return std::nullopt;
+    }
+
+    return image;
+}
+
+auto WicImageCodec::Decode(const std::uint8_t* data, std::size_t size) -> std::optional<DecodedImage>
+{
+    if (mFactory == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    // Read straight from album art memory.
+    auto stream = CComPtr<IWICStream>();
+    if (FAILED(mFactory->CreateStream(&stream)) ||
+        FAILED(stream->InitializeFromMemory(const_cast<BYTE*>(data), static_cast<DWORD>(size))))
+    {
+        return std::nullopt;
+    }
+
+    auto decoder = CComPtr<IWICBitmapDecoder>();
+    auto frame   = CComPtr<IWICBitmapFrameDecode>();
+    if (FAILED(mFactory->CreateDecoderFromStream(stream, nullptr, WICDecodeMetadataCacheOnDemand, &decoder)) ||
+        FAILED(decoder->GetFrame(0, &frame)))
+    {
+        return std::nullopt;
+    }
+
+    // Convert whatever format cover is in to BGR, JPEG has no alpha anyway.
+    auto converter = CComPtr<IWICFormatConverter>();
+    if (FAILED(mFactory->CreateFormatConverter(&converter)) ||
+        FAILED(converter->Initialize(frame, WIC_PIXEL_FORMAT, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom)))
+    {
+        return std::nullopt;
+    }
+
+    return CopyPixels(converter);
+}
+
+auto WicImageCodec::Resize(const DecodedImage& image, std::uint32_t width, std::uint32_t height) -> std::optional<DecodedImage>
+{
+    if (mFactory == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    auto bitmap = CComPtr<IWICBitmap>();
+    auto hr     = mFactory->CreateBitmapFromMemory(
+        image.Width,
+        image.Height,
+        WIC_PIXEL_FORMAT,
+        image.Stride,
+        static_cast<UINT>(image.Pixels.size()),
+        const_cast<BYTE*>(image.Pixels.data()),
+        &bitmap
+    );
+    if (FAILED(hr))
+    {
+        return std::nullopt;
+    }
+
+    // Fant gives good quality when downscaling by large factors.
+    auto scaler = CComPtr<IWICBitmapScaler>();
+    if (FAILED(mFactory->CreateBitmapScaler(&scaler)) ||
+        FAILED(scaler->Initialize(bitmap, width, height, WICBitmapInterpolationModeFant)))
+    {
+        return std::nullopt;
+    }
+
+    return CopyPixels(scaler);
+}
+
+auto WicImageCodec::EncodeJpeg(const DecodedImage& image, int quality) -> std::optional<std::vector<std::uint8_t>>
+{
+    if (mFactory == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    auto stream  = CComPtr<IStream>();
+    auto encoder = CComPtr<IWICBitmapEncoder>();
+    if (FAILED(CreateStreamOnHGlobal(nullptr, TRUE, &stream)) ||
+        FAILED(mFactory->CreateEncoder(GUID_ContainerFormatJpeg, nullptr, &encoder)) ||
+        FAILED(encoder->Initialize(stream, WICBitmapEncoderNoCache)))
+    {
+        return std::nullopt;
+    }
+
+    auto frame      = CComPtr<IWICBitmapFrameEncode>();
+    auto properties = CComPtr<IPropertyBag2>();
+    if (FAILED(encoder->CreateNewFrame(&frame, &properties)))
+    {
+        return std::nullopt;
+    }
+
+    // Set quality.
+    auto option     = PROPBAG2();
+    option.pstrName = const_cast<LPOLESTR>(L"ImageQuality");
+
+    auto value   = VARIANT();
+    VariantInit(&value);
+    value.vt     = VT_R4;
+    value.fltVal = static_cast<float>(quality) / 100.0f;
+
+    auto format = WIC_PIXEL_FORMAT;
+    if (FAILED(properties->Write(1, &option, &value)) ||
+        FAILED(frame->Initialize(properties)) ||
+        FAILED(frame->SetSize(image.Width, image.Height)) ||
+        FAILED(frame->SetPixelFormat(&format)) ||
+        format != WIC_PIXEL_FORMAT)
+    {
+        return std::nullopt;
+    }
+
+    auto hr = frame->WritePixels(
+        image.Height,
+        image.Stride,
+        static_cast<UINT>(image.Pixels.size()),
+        const_cast<BYTE*>(image.Pixels.data())
+    );
+    if (FAILED(hr) || FAILED(frame->Commit()) || FAILED(encoder->Commit()))
+    {
+        return std::nullopt;
+    }
+
+    // Copy encoded bytes out of stream memory.
+    auto global = HGLOBAL(nullptr);
+    auto stat   = STATSTG();
+    if (FAILED(GetHGlobalFromStream(stream, &global)) || FAILED(stream->Stat(&stat, STATFLAG_NONAME)))
+    {
+        return std::nullopt;
+    }
+
+    auto size = static_cast<std::size_t>(stat.cbSize.QuadPart);
+    auto data = static_cast<const std::uint8_t*>(GlobalLock(global));
+    if (data == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    auto encoded = std::vector<std::uint8_t>(data, data + size);
+    GlobalUnlock(global);
+
+    return encoded;
+}
+
+} // namespace foo_showplay
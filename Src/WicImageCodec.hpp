@@ -0,0 +1,47 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include "ImageCodec.hpp"
+
+#include <wincodec.h>
+
+namespace foo_showplay {
+
+// ImageCodec using Windows Imaging Component.
+class WicImageCodec : public ImageCodec
+{
+    CComPtr<IWICImagingFactory> mFactory;
+    bool                        mIsComInitialized;
+
+    auto CopyPixels (IWICBitmapSource* source) -> std::optional<DecodedImage>;
+
+public:
+    WicImageCodec();
+    ~WicImageCodec();
+
+    auto IsValid () const -> bool { return mFactory != nullptr; }
+
+    auto Decode     (const std::uint8_t* data, std::size_t size) -> std::optional<DecodedImage> override;
+    auto Resize     (const DecodedImage& image, std::uint32_t width, std::uint32_t height) -> std::optional<DecodedImage> override;
+    auto EncodeJpeg (const DecodedImage& image, int quality) -> std::optional<std::vector<std::uint8_t>> override;
+};
+
+} // namespace foo_showplay
@@ -0,0 +1,211 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+
+// Frames numbered before reconnect must not be taken for frames of new
+// connection. Clock offset and uplink delay are checked to the microsecond
+// with given send and receive times, no wall clock is involved.
+
+#include "Check.hpp"
+#include "AckTracker.hpp"
+
+#include <chrono>
+
+using namespace foo_showplay;
+
+namespace {
+
+using Clock        = AckTracker::Clock;
+using Microseconds = std::chrono::microseconds;
+
+// Server clock is this far ahead of client.
+constexpr auto SERVER_OFFSET = std::int64_t(5000000);
+
+// One frame with its ack, both ways taking given time.
+class Link
+{
+    AckTracker&       mAcks;
+    Clock::time_point mStart;
+    unsigned          mEpoch;
+
+public:
+    Link(AckTracker& acks, unsigned epoch)
+        : mAcks  (acks)
+        , mStart (Clock::time_point())
+        , mEpoch (epoch)
+    {
+        mAcks.Reset(epoch);
+    }
+
+    auto Send(int frame, std::int64_t sentAtUs, unsigned epoch) -> void
+    {
+        mAcks.OnSent(frame, epoch, mStart + Microseconds(sentAtUs), sentAtUs);
+    }
+
+    auto Ack(int frame, std::int64_t sentAtUs, std::int64_t uplinkUs, std::int64_t downlinkUs) -> void
+    {
+        mAcks.OnAck(frame, sentAtUs + SERVER_OFFSET + uplinkUs, mStart + Microseconds(sentAtUs + uplinkUs + downlinkUs));
+    }
+
+    auto Exchange(int frame, std::int64_t sentAtUs, std::int64_t uplinkUs, std::int64_t downlinkUs) -> void
+    {
+        Send(frame, sentAtUs, mEpoch);
+        Ack(frame, sentAtUs, uplinkUs, downlinkUs);
+    }
+};
+
+auto TestStaleEpoch() -> void
+{
+    auto metrics = Metrics();
+    auto acks    = AckTracker(metrics);
+    auto link    = Link(acks, 1);
+
+    // Sender took frame 3 from old connection, reconnect happened before it
+    // got to OnSent.
+    link.Send(3, 0, 0);
+
+    for (auto frame = 0; frame < 5; ++frame)
+    {
+        link.Exchange(frame, 1000 * (frame + 1), 100, 100);
+    }
+
+    SHOWPLAY_CHECK(metrics.FramesLost.Get() == 0);
+    SHOWPLAY_CHECK(metrics.RoundTripTime.GetCount() == 5);
+}
+
+auto TestStaleFailure() -> void
+{
+    auto metrics = Metrics();
+    auto acks    = AckTracker(metrics);
+    auto link    = Link(acks, 2);
+
+    // Failed send of old connection leaves frame of new one tracked.
+    link.Send(0, 1000, 2);
+    acks.OnFailed(0, 1);
+    link.Ack(0, 1000, 100, 100);
+
+    SHOWPLAY_CHECK(metrics.RoundTripTime.GetCount() == 1);
+}
+
+auto TestMicroseconds() -> void
+{
+    auto metrics = Metrics();
+    auto acks    = AckTracker(metrics);
+    auto link    = Link(acks, 1);
+
+    // Symmetric paths, faster round trip later gives the same offset.
+    link.Exchange(0, 1000, 100, 100);
+    link.Exchange(1, 2000, 300, 300);
+    link.Exchange(2, 3000,  50,  50);
+
+    SHOWPLAY_CHECK(acks.GetClockOffset() == Microseconds(SERVER_OFFSET));
+    SHOWPLAY_CHECK(metrics.UplinkDelay.GetCount() == 3);
+    SHOWPLAY_CHECK(metrics.UplinkDelay.GetMax() == Microseconds(300));
+    SHOWPLAY_CHECK(metrics.UplinkDelay.GetMean() == Microseconds(150));
+    SHOWPLAY_CHECK(metrics.UplinkNegative.Get() == 0);
+}
+
+auto TestNegativeUplink() -> void
+{
+    auto metrics = Metrics();
+    auto acks    = AckTracker(metrics);
+    auto link    = Link(acks, 1);
+
+    // Fastest round trip is asymmetric, offset comes out 30 us too high and
+    // uplink of 10 us is estimated as -20 us.
+    link.Exchange(0, 1000, 80,  20);
+    link.Exchange(1, 2000, 10, 200);
+
+    SHOWPLAY_CHECK(acks.GetClockOffset() == Microseconds(SERVER_OFFSET + 30));
+    SHOWPLAY_CHECK(metrics.UplinkDelay.GetCount() == 1);
+    SHOWPLAY_CHECK(metrics.UplinkDelay.GetMax() == Microseconds(50));
+    SHOWPLAY_CHECK(metrics.UplinkNegative.Get() == 1);
+}
+
+auto TestOffsetWindow() -> void
+{
+    auto metrics = Metrics();
+    auto acks    = AckTracker(metrics);
+    auto link    = Link(acks, 1);
+
+    // Skewed fastest sample is forgotten once window moved past it.
+    link.Exchange(0, 1000, 80, 20);
+    for (auto frame = 1; frame < static_cast<int>(ACK_OFFSET_WINDOW); ++frame)
+    {
+        link.Exchange(frame, 1000 * (frame + 1), 100, 100);
+    }
+
+    SHOWPLAY_CHECK(acks.GetClockOffset() == Microseconds(SERVER_OFFSET + 30));
+
+    link.Exchange(static_cast<int>(ACK_OFFSET_WINDOW), 1000 * (ACK_OFFSET_WINDOW + 1), 100, 100);
+    SHOWPLAY_CHECK(acks.GetClockOffset() == Microseconds(SERVER_OFFSET));
+
+    // And offset is measured again on new connection.
+    acks.Reset(2);
+    SHOWPLAY_CHECK(!acks.GetClockOffset().has_value());
+}
+
+auto TestAckState() -> void
+{
+    auto metrics = Metrics();
+    auto acks    = AckTracker(metrics);
+    auto link    = Link(acks, 1);
+
+    // Frame 1 is skipped by server, frame 3 fails to send.
+    for (auto frame = 0; frame < 4; ++frame)
+    {
+        link.Send(frame, 1000 * (frame + 1), 1);
+    }
+
+    link.Ack(0, 1000, 100, 100);
+    link.Ack(2, 3000, 100, 100);
+    acks.OnFailed(3, 1);
+
+    SHOWPLAY_CHECK(acks.GetAckState(0, 1) == AckState::Acked);
+    SHOWPLAY_CHECK(acks.GetAckState(1, 1) == AckState::Lost);
+    SHOWPLAY_CHECK(acks.GetAckState(2, 1) == AckState::Acked);
+    SHOWPLAY_CHECK(acks.GetAckState(3, 1) == AckState::Lost);
+
+    link.Send(4, 5000, 1);
+    SHOWPLAY_CHECK(acks.GetAckState(4, 1) == AckState::Pending);
+
+    // Repeated ack is counted once, acked frame isn't lost when slot is reused.
+    link.Ack(2, 3000, 100, 100);
+    link.Send(2 + static_cast<int>(ACK_WINDOW_SIZE), 6000, 1);
+    SHOWPLAY_CHECK(metrics.RoundTripTime.GetCount() == 2);
+    SHOWPLAY_CHECK(metrics.FramesLost.Get() == 1);
+
+    // Same number on new connection is another frame.
+    acks.Reset(2);
+    SHOWPLAY_CHECK(acks.GetAckState(0, 1) == AckState::Lost);
+}
+
+} // namespace
+
+auto main() -> int
+{
+    TestStaleEpoch();
+    TestStaleFailure();
+    TestMicroseconds();
+    TestNegativeUplink();
+    TestOffsetWindow();
+    TestAckState();
+
+    return SHOWPLAY_TEST_RESULT();
+}
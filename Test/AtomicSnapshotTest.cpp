@@ -0,0 +1,128 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+// AtomicSnapshot under concurrent readers and writer: readers always see a
+// whole value, values are freed once no reader holds them.
+
+#include "AtomicSnapshot.hpp"
+#include "Check.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace foo_showplay;
+
+namespace {
+
+std::atomic<int> gAlive(0);
+
+// Both halves are written together, reader seeing them differ saw a torn or
+// freed value.
+struct Value
+{
+    int First;
+    int Second;
+
+    Value(int value)
+        : First  (value)
+        , Second (value)
+    {
+        gAlive.fetch_add(1);
+    }
+
+    Value(const Value& other)
+        : First  (other.First)
+        , Second (other.Second)
+    {
+        gAlive.fetch_add(1);
+    }
+
+    ~Value()
+    {
+        First  = -1;
+        Second = -2;
+        gAlive.fetch_sub(1);
+    }
+};
+
+constexpr auto PUBLISH_COUNT = 100000;
+constexpr auto READER_COUNT  = 3;
+
+} // namespace
+
+auto main() -> int
+{
+    {
+        auto snapshot = AtomicSnapshot<Value>(Value(0));
+        auto isDone   = std::atomic<bool>(false);
+        auto isTorn   = std::atomic<bool>(false);
+        auto isOlder  = std::atomic<bool>(false);
+
+        auto readers = std::vector<std::thread>();
+        for (auto i = 0; i < READER_COUNT; ++i)
+        {
+            readers.emplace_back([&]()
+            {
+                auto last = 0;
+                while (!isDone.load())
+                {
+                    auto value = snapshot.Read();
+                    isTorn  = isTorn  || value->First != value->Second;
+                    isOlder = isOlder || value->First < last;
+                    last    = value->First;
+                }
+            });
+        }
+
+        for (auto i = 1; i <= PUBLISH_COUNT; ++i)
+        {
+            snapshot.Publish(Value(i));
+        }
+
+        isDone = true;
+        for (auto& reader : readers)
+        {
+            reader.join();
+        }
+
+        SHOWPLAY_CHECK(!isTorn);
+        SHOWPLAY_CHECK(!isOlder);
+        SHOWPLAY_CHECK(snapshot.Read()->First == PUBLISH_COUNT);
+
+        // No reader left, next publish frees everything but current value.
+        snapshot.Publish(Value(PUBLISH_COUNT + 1));
+        SHOWPLAY_CHECK(gAlive.load() == 1);
+
+        // Value held by reader outlives publishes and is freed after.
+        {
+            auto held = snapshot.Read();
+            snapshot.Publish(Value(PUBLISH_COUNT + 2));
+            snapshot.Publish(Value(PUBLISH_COUNT + 3));
+            SHOWPLAY_CHECK(held->First == PUBLISH_COUNT + 1);
+            SHOWPLAY_CHECK(gAlive.load() == 3);
+        }
+
+        snapshot.Publish(Value(PUBLISH_COUNT + 4));
+        SHOWPLAY_CHECK(gAlive.load() == 1);
+    }
+
+    SHOWPLAY_CHECK(gAlive.load() == 0);
+    return SHOWPLAY_TEST_RESULT();
+}
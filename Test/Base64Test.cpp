@@ -0,0 +1,95 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+// Every Base64 implementation the CPU supports, forced in turn, against
+// cpp-base64 on all input lengths up to 2000 bytes. Covers every tail length
+// of the SIMD loops and the bytes right past the output.
+
+#include "Base64.hpp"
+#include "Check.hpp"
+
+#include <base64.h>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace foo_showplay;
+
+namespace {
+
+constexpr auto MAX_SIZE = std::size_t(2000);
+constexpr auto GUARD    = '#'; // Never in Base64 output.
+
+auto CheckImplementation(const Base64Implementation& implementation, const std::vector<std::uint8_t>& data) -> void
+{
+    auto failures = test::gFailures;
+    for (auto size = std::size_t(0); size <= MAX_SIZE && failures == test::gFailures; ++size)
+    {
+        auto expected = base64_encode(data.data(), static_cast<unsigned int>(size));
+        SHOWPLAY_CHECK(expected.size() == Base64EncodedSize(size));
+
+        // Guard bytes catch writes past the encoded size.
+        auto encoded = std::string(Base64EncodedSize(size) + 32, GUARD);
+        implementation.Encode(data.data(), size, encoded.data());
+
+        SHOWPLAY_CHECK(encoded.compare(0, expected.size(), expected) == 0);
+        SHOWPLAY_CHECK(encoded.find_first_not_of(GUARD, expected.size()) == std::string::npos);
+
+        if (failures != test::gFailures)
+        {
+            std::fprintf(stderr, "%s: mismatch at size %zu\n", implementation.Name, size);
+        }
+    }
+}
+
+} // namespace
+
+auto main() -> int
+{
+    auto random = std::mt19937(7);
+    auto data   = std::vector<std::uint8_t>(MAX_SIZE);
+    for (auto& byte : data)
+    {
+        byte = static_cast<std::uint8_t>(random());
+    }
+
+    // All byte values at the start, random bytes after.
+    for (auto i = std::size_t(0); i < 256; ++i)
+    {
+        data[i] = static_cast<std::uint8_t>(i);
+    }
+
+    auto implementations = Base64Implementations();
+    SHOWPLAY_CHECK(!implementations.empty());
+    SHOWPLAY_CHECK(std::string(implementations.front().Name) == Base64ImplementationName());
+
+    for (const auto& implementation : implementations)
+    {
+        std::printf("%s\n", implementation.Name);
+        CheckImplementation(implementation, data);
+    }
+
+    // Append goes through picked implementation and keeps existing content.
+    auto appended = std::string("prefix");
+    Base64Append(data.data(), 100, appended);
+    SHOWPLAY_CHECK(appended == "prefix" + base64_encode(data.data(), 100));
+
+    return SHOWPLAY_TEST_RESULT();
+}
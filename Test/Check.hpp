@@ -0,0 +1,42 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for test executables, failures are printed and counted,
+// main returns non-zero if any failed so CTest reports the test as failed.
+namespace foo_showplay::test {
+
+inline int gFailures = 0;
+
+} // namespace foo_showplay::test
+
+#define SHOWPLAY_CHECK(condition)                                                      \
+    do                                                                                 \
+    {                                                                                  \
+        if (!(condition))                                                              \
+        {                                                                              \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            foo_showplay::test::gFailures += 1;                                        \
+        }                                                                              \
+    } while (false)
+
+#define SHOWPLAY_TEST_RESULT() (foo_showplay::test::gFailures == 0 ? 0 : 1)
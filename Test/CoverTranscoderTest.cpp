@@ -0,0 +1,231 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+// CoverTranscoder::Transcode with PortableImageCodec on covers in Test/Data:
+// cover.png is 600x400, cover.jpg is 480x640 and about 90 KiB.
+//
+// Usage: CoverTranscoderTest <data directory>
+
+#include "Check.hpp"
+#include "CoverTranscoder.hpp"
+#include "PortableImageCodec.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace foo_showplay;
+
+namespace {
+
+auto ToBinaryData(std::vector<std::uint8_t> bytes) -> BinaryData
+{
+    auto buffer = std::make_shared<std::vector<std::uint8_t>>(std::move(bytes));
+    return BinaryData(std::shared_ptr<const std::uint8_t>(buffer, buffer->data()), buffer->size());
+}
+
+auto ReadFile(const std::string& path) -> BinaryData
+{
+    auto file  = std::ifstream(path, std::ios::binary);
+    auto bytes = std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (bytes.empty())
+    {
+        std::fprintf(stderr, "Can't read %s\n", path.c_str());
+    }
+
+    return ToBinaryData(std::move(bytes));
+}
+
+auto IsJpeg(const BinaryData& image) -> bool
+{
+    return image.Size >= 3 && image.Data.get()[0] == 0xFF && image.Data.get()[1] == 0xD8 && image.Data.get()[2] == 0xFF;
+}
+
+// Same bytes, not just equal ones.
+auto IsSame(const BinaryData& a, const BinaryData& b) -> bool
+{
+    return a.Data.get() == b.Data.get() && a.Size == b.Size;
+}
+
+auto TestDecode(ImageCodec& codec, const BinaryData& png, const BinaryData& jpeg) -> void
+{
+    auto decoded = codec.Decode(png.Data.get(), png.Size);
+    SHOWPLAY_CHECK(decoded.has_value());
+    if (decoded.has_value())
+    {
+        SHOWPLAY_CHECK(decoded->Width == 600 && decoded->Height == 400);
+        SHOWPLAY_CHECK(decoded->Stride == 1800);
+
+        // Pixel 50,0 of fixture is RGB 234,0,12, stored BGR.
+        auto pixel = decoded->Pixels.data() + 50 * 3;
+        SHOWPLAY_CHECK(pixel[0] == 12 && pixel[1] == 0 && pixel[2] == 234);
+    }
+
+    decoded = codec.Decode(jpeg.Data.get(), jpeg.Size);
+    SHOWPLAY_CHECK(decoded.has_value());
+    if (decoded.has_value())
+    {
+        SHOWPLAY_CHECK(decoded->Width == 480 && decoded->Height == 640);
+    }
+}
+
+auto TestMaxEdge(ImageCodec& codec, const BinaryData& png, const BinaryData& jpeg) -> void
+{
+    // Longest edge is fit, aspect ratio kept, result is JPEG.
+    auto result  = CoverTranscoder::Transcode(codec, png, CoverLimits(300, 0));
+    auto decoded = codec.Decode(result.Data.get(), result.Size);
+    SHOWPLAY_CHECK(IsJpeg(result));
+    SHOWPLAY_CHECK(decoded.has_value() && decoded->Width == 300 && decoded->Height == 200);
+
+    result  = CoverTranscoder::Transcode(codec, jpeg, CoverLimits(320, 0));
+    decoded = codec.Decode(result.Data.get(), result.Size);
+    SHOWPLAY_CHECK(IsJpeg(result));
+    SHOWPLAY_CHECK(decoded.has_value() && decoded->Width == 240 && decoded->Height == 320);
+    SHOWPLAY_CHECK(result.Size < jpeg.Size);
+}
+
+auto TestByteBudget(ImageCodec& codec, const BinaryData& jpeg) -> void
+{
+    // Reachable by lowering quality and size.
+    for (auto budget : { std::size_t(60000), std::size_t(30000), std::size_t(10000) })
+    {
+        auto result = CoverTranscoder::Transcode(codec, jpeg, CoverLimits(0, budget));
+        SHOWPLAY_CHECK(IsJpeg(result));
+        SHOWPLAY_CHECK(result.Size <= budget);
+        SHOWPLAY_CHECK(codec.Decode(result.Data.get(), result.Size).has_value());
+    }
+
+    // Both limits at once.
+    auto result  = CoverTranscoder::Transcode(codec, jpeg, CoverLimits(200, 20000));
+    auto decoded = codec.Decode(result.Data.get(), result.Size);
+    SHOWPLAY_CHECK(result.Size <= 20000);
+    SHOWPLAY_CHECK(decoded.has_value() && std::max(decoded->Width, decoded->Height) <= 200);
+
+    // Unreachable, smallest encoding is sent, still smaller than original.
+    result = CoverTranscoder::Transcode(codec, jpeg, CoverLimits(0, 100));
+    SHOWPLAY_CHECK(IsJpeg(result));
+    SHOWPLAY_CHECK(result.Size > 100 && result.Size < jpeg.Size);
+}
+
+auto TestPassThrough(ImageCodec& codec, const BinaryData& png, const BinaryData& jpeg) -> void
+{
+    // No limits, or cover already fits, original bytes are sent.
+    SHOWPLAY_CHECK(IsSame(CoverTranscoder::Transcode(codec, png,  CoverLimits()), png));
+    SHOWPLAY_CHECK(IsSame(CoverTranscoder::Transcode(codec, jpeg, CoverLimits()), jpeg));
+    SHOWPLAY_CHECK(IsSame(CoverTranscoder::Transcode(codec, png,  CoverLimits(600, png.Size)), png));
+    SHOWPLAY_CHECK(IsSame(CoverTranscoder::Transcode(codec, jpeg, CoverLimits(1000, 1 << 20)), jpeg));
+}
+
+auto TestCorrupt(ImageCodec& codec, const BinaryData& png) -> void
+{
+    auto limits = CoverLimits(100, 1000);
+
+    // Not an image at all.
+    auto text    = std::string("not an image");
+    auto garbage = ToBinaryData(std::vector<std::uint8_t>(text.begin(), text.end()));
+    SHOWPLAY_CHECK(!codec.Decode(garbage.Data.get(), garbage.Size).has_value());
+    SHOWPLAY_CHECK(IsSame(CoverTranscoder::Transcode(codec, garbage, limits), garbage));
+
+    // JPEG signature followed by junk.
+    auto junk = std::vector<std::uint8_t>(256, 0x5A);
+    junk[0] = 0xFF;
+    junk[1] = 0xD8;
+    junk[2] = 0xFF;
+    auto badJpeg = ToBinaryData(std::move(junk));
+    SHOWPLAY_CHECK(!codec.Decode(badJpeg.Data.get(), badJpeg.Size).has_value());
+    SHOWPLAY_CHECK(IsSame(CoverTranscoder::Transcode(codec, badJpeg, limits), badJpeg));
+
+    // PNG cut off in the middle of image data.
+    auto half      = std::vector<std::uint8_t>(png.Data.get(), png.Data.get() + png.Size / 2);
+    auto truncated = ToBinaryData(std::move(half));
+    SHOWPLAY_CHECK(!codec.Decode(truncated.Data.get(), truncated.Size).has_value());
+    SHOWPLAY_CHECK(IsSame(CoverTranscoder::Transcode(codec, truncated, limits), truncated));
+
+    // Empty.
+    auto empty = BinaryData();
+    SHOWPLAY_CHECK(!codec.Decode(empty.Data.get(), empty.Size).has_value());
+    SHOWPLAY_CHECK(IsSame(CoverTranscoder::Transcode(codec, empty, limits), empty));
+}
+
+auto TestResize(ImageCodec& codec) -> void
+{
+    // Box filter keeps flat color flat.
+    auto image = DecodedImage(97, 61);
+    for (auto y = std::uint32_t(0); y < image.Height; ++y)
+    {
+        for (auto x = std::uint32_t(0); x < image.Width; ++x)
+        {
+            auto pixel = image.Pixels.data() + y * image.Stride + x * 3;
+            pixel[0] = 10;
+            pixel[1] = 20;
+            pixel[2] = 30;
+        }
+    }
+
+    auto resized = codec.Resize(image, 13, 7);
+    SHOWPLAY_CHECK(resized.has_value() && resized->Width == 13 && resized->Height == 7);
+    if (resized.has_value())
+    {
+        auto isFlat = true;
+        for (auto y = std::uint32_t(0); y < resized->Height; ++y)
+        {
+            for (auto x = std::uint32_t(0); x < resized->Width; ++x)
+            {
+                auto pixel = resized->Pixels.data() + y * resized->Stride + x * 3;
+                isFlat = isFlat && pixel[0] == 10 && pixel[1] == 20 && pixel[2] == 30;
+            }
+        }
+        SHOWPLAY_CHECK(isFlat);
+    }
+
+    SHOWPLAY_CHECK(!codec.Resize(image, 0, 7).has_value());
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc != 2)
+    {
+        std::fprintf(stderr, "Usage: %s <data directory>\n", argv[0]);
+        return 2;
+    }
+
+    auto directory = std::string(argv[1]) + "/";
+    auto png       = ReadFile(directory + "cover.png");
+    auto jpeg      = ReadFile(directory + "cover.jpg");
+    if (png.Size == 0 || jpeg.Size == 0)
+    {
+        return 2;
+    }
+
+    auto codec = PortableImageCodec();
+    TestDecode(codec, png, jpeg);
+    TestMaxEdge(codec, png, jpeg);
+    TestByteBudget(codec, jpeg);
+    TestPassThrough(codec, png, jpeg);
+    TestCorrupt(codec, png);
+    TestResize(codec);
+
+    return SHOWPLAY_TEST_RESULT();
+}
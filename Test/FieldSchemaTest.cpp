@@ -0,0 +1,115 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+// Schemas of several servers merged and evaluated once, every server gets
+// values of its own definitions only, even where names clash.
+
+#include "Check.hpp"
+#include "FieldSchema.hpp"
+
+#include <memory>
+#include <string>
+
+using namespace foo_showplay;
+
+namespace {
+
+auto MakeField(std::string name, std::string expression, FieldType type) -> SchemaField
+{
+    auto field       = SchemaField();
+    field.Name       = std::move(name);
+    field.Expression = std::move(expression);
+    field.Type       = type;
+    return field;
+}
+
+// What player produces for merged schema.
+auto Evaluate(const FieldSchema& schema) -> CustomFields
+{
+    auto fields = CustomFields();
+    for (const auto& field : schema)
+    {
+        auto value = field.Expression + "/" + std::to_string(static_cast<int>(field.Type));
+        fields.Values.push_back(CustomField{ field.Name, value, field.Expression, field.Type });
+    }
+
+    return fields;
+}
+
+auto GetValue(const CustomFields& fields, const std::string& name) -> std::string
+{
+    for (const auto& field : fields.Values)
+    {
+        if (field.Name == name)
+        {
+            return std::get<std::string>(field.Value);
+        }
+    }
+
+    return "";
+}
+
+} // namespace
+
+auto main() -> int
+{
+    // Genre clashes by expression, Rating by type, Year is the same.
+    auto first = std::make_shared<const FieldSchema>(NormalizeSchema({
+        MakeField("Year",   "%date%",   FieldType::Integer),
+        MakeField("Genre",  "%genre%",  FieldType::String),
+        MakeField("Rating", "%rating%", FieldType::Integer),
+    }));
+    auto second = std::make_shared<const FieldSchema>(NormalizeSchema({
+        MakeField("Genre",  "$upper(%genre%)", FieldType::String),
+        MakeField("Rating", "%rating%",        FieldType::Number),
+        MakeField("Year",   "%date%",          FieldType::Integer),
+        MakeField("Year",   "%year%",          FieldType::Integer), // Same server, first wins.
+    }));
+
+    SHOWPLAY_CHECK(second->size() == 3);
+
+    auto merged = MergeSchemas({ first, second, nullptr });
+    SHOWPLAY_CHECK(merged.size() == 5);
+    SHOWPLAY_CHECK((FindConflicts(merged) == std::vector<std::string>{ "Genre", "Rating" }));
+    SHOWPLAY_CHECK(FindConflicts(*first).empty());
+
+    auto values = Evaluate(merged);
+
+    auto firstValues = values;
+    FilterFields(firstValues, *first);
+    SHOWPLAY_CHECK(firstValues.Values.size() == 3);
+    SHOWPLAY_CHECK(GetValue(firstValues, "Genre")  == "%genre%/0");
+    SHOWPLAY_CHECK(GetValue(firstValues, "Rating") == "%rating%/1");
+    SHOWPLAY_CHECK(GetValue(firstValues, "Year")   == "%date%/1");
+
+    auto secondValues = values;
+    FilterFields(secondValues, *second);
+    SHOWPLAY_CHECK(secondValues.Values.size() == 3);
+    SHOWPLAY_CHECK(GetValue(secondValues, "Genre")  == "$upper(%genre%)/0");
+    SHOWPLAY_CHECK(GetValue(secondValues, "Rating") == "%rating%/2");
+    SHOWPLAY_CHECK(GetValue(secondValues, "Year")   == "%date%/1");
+
+    // Server changed definition of a field, whole section is resent.
+    auto before = std::optional<CustomFields>(firstValues);
+    auto after  = std::optional<CustomFields>(secondValues);
+    SHOWPLAY_CHECK(DiffFields(before, after) == ALL_FIELDS);
+    SHOWPLAY_CHECK(DiffFields(before, before) == 0);
+
+    return SHOWPLAY_TEST_RESULT();
+}
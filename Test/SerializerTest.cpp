@@ -0,0 +1,243 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+
+// JsonWriter against nlohmann::json dump of the same payload, byte for byte.
+// Covers escapes, control characters, doubles, nulls, empty optionals and
+// invalid UTF-8, which both replace with U+FFFD. Frame to server without
+// features carries the keys it did before features existed.
+
+#include "Check.hpp"
+#include "Payload.hpp"
+#include "WebSocket.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+
+using namespace foo_showplay;
+
+namespace {
+
+auto Write(const Payload& payload) -> std::string
+{
+    auto buffer = std::string();
+    auto writer = JsonWriter(buffer);
+    WriteObject(writer, payload);
+    return buffer;
+}
+
+auto CheckPayload(const char* name, const Payload& payload) -> void
+{
+    auto expected = nlohmann::json(payload).dump();
+    auto written  = Write(payload);
+    SHOWPLAY_CHECK(written == expected);
+    if (written != expected)
+    {
+        std::fprintf(stderr, "%s:\n  %s\n  %s\n", name, expected.c_str(), written.c_str());
+    }
+}
+
+auto MakeImage(std::size_t size) -> BinaryData
+{
+    auto bytes = std::shared_ptr<std::uint8_t>(new std::uint8_t[size], std::default_delete<std::uint8_t[]>());
+    for (auto i = std::size_t(0); i < size; ++i)
+    {
+        bytes.get()[i] = static_cast<std::uint8_t>(i * 7);
+    }
+
+    return BinaryData(bytes, size);
+}
+
+auto MakeFullPayload() -> Payload
+{
+    auto song        = SongInfo();
+    song.Title       = std::string("Quote \" backslash \\ slash / tab \t newline \n return \r");
+    song.Artist      = std::string("Control \x01\x08\x0C\x1F and DEL \x7F");
+    song.Album       = std::string("\xC3\xA9t\xC3\xA9 \xE6\x97\xA5\xE6\x9C\xAC \xF0\x9F\x8E\xB5");
+    song.Date        = std::string();
+    song.Path        = std::string("C:\\Music\\a.flac");
+    song.TrackNumber = -7;
+    song.Length      = 245.33333333333334;
+
+    auto playback      = PlaybackInfo();
+    playback.State     = PlaybackState::Playing;
+    playback.Elapsed   = 30.0;
+    playback.Rate      = 1.0;
+    playback.Timestamp = std::numeric_limits<std::int64_t>::min();
+
+    auto cover       = CoverInfo();
+    cover.Attachment = 3;
+    cover.Hash       = std::string("0123456789abcdef");
+    cover.Image      = MakeImage(100);
+
+    auto record     = TrackRecord();
+    record.Title    = std::string("Old");
+    record.PlayedAt = std::numeric_limits<std::int64_t>::max();
+
+    auto sync    = SyncInfo();
+    sync.Changed = std::vector<std::string>{ "Cover", "Song" };
+    sync.History = std::vector<TrackRecord>{ record, TrackRecord() };
+    sync.Since   = 0;
+    sync.Version = std::numeric_limits<std::uint32_t>::max();
+
+    auto fields = CustomFields();
+    fields.Values.push_back(CustomField{ "Bpm",    std::int64_t(128),    "%bpm%",    FieldType::Integer });
+    fields.Values.push_back(CustomField{ "Gain",   -6.5,                 "%gain%",   FieldType::Number  });
+    fields.Values.push_back(CustomField{ "Genre",  std::string("Jazz"),  "%genre%",  FieldType::String  });
+    fields.Values.push_back(CustomField{ "Rating", std::monostate(),     "%rating%", FieldType::Integer });
+
+    auto payload   = Payload(PlayerInfo(), playback, song, cover, sync);
+    payload.Fields = fields;
+    payload.Stats  = StatsInfo();
+    return payload;
+}
+
+auto TestPayloads() -> void
+{
+    CheckPayload("empty", Payload());
+    CheckPayload("sections without values", Payload(PlayerInfo(), PlaybackInfo(), SongInfo(), CoverInfo(), SyncInfo()));
+    CheckPayload("full", MakeFullPayload());
+}
+
+auto TestNumbers() -> void
+{
+    const double values[] = {
+        0.0, -0.0, 1.0, -1.5, 30.0, 0.1, 1.0 / 3.0, 1e-5, 1e-7, 123456.789, 1e15, 1e16, 1e17, 1e21, 1e22,
+        1e308, 5e-324, 2.2250738585072014e-308, std::numeric_limits<double>::max(),
+        std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::infinity(),
+    };
+
+    auto check = [](double value)
+    {
+        auto buffer = std::string();
+        auto writer = JsonWriter(buffer);
+        writer.Number(value);
+
+        auto expected = nlohmann::json(value).dump();
+        SHOWPLAY_CHECK(buffer == expected);
+        if (buffer != expected)
+        {
+            std::fprintf(stderr, "number: %s, written %s\n", expected.c_str(), buffer.c_str());
+        }
+    };
+
+    for (auto value : values)
+    {
+        check(value);
+    }
+
+    // Any bit pattern, stops at first mismatch.
+    auto random   = std::mt19937_64(1);
+    auto failures = test::gFailures;
+    for (auto i = 0; i < 100000 && failures == test::gFailures; ++i)
+    {
+        auto bits  = random();
+        auto value = 0.0;
+        std::memcpy(&value, &bits, sizeof(value));
+        check(value);
+    }
+}
+
+auto TestUtf8() -> void
+{
+    auto check = [](const std::string& value)
+    {
+        auto buffer = std::string();
+        auto writer = JsonWriter(buffer);
+        writer.String(value);
+
+        auto expected = nlohmann::json(value).dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+        SHOWPLAY_CHECK(buffer == expected);
+        if (buffer != expected)
+        {
+            std::fprintf(stderr, "string:");
+            for (auto c : value)
+            {
+                std::fprintf(stderr, " %02x", static_cast<unsigned char>(c));
+            }
+            std::fprintf(stderr, "\n");
+        }
+    };
+
+    check("\x80");
+    check("\xC0\xAF");             // Overlong slash.
+    check("\xE0\x80\xAF");         // Overlong slash.
+    check("\xED\xA0\x80");         // Surrogate.
+    check("\xF4\x90\x80\x80");     // Above U+10FFFF.
+    check("\xF5\x80\x80\x80");
+    check("abc\xE6\x97");          // Cut short at end.
+    check("\xE6\x97" "abc");       // Cut short in the middle.
+    check("\xF0\x9F\x8E\xB5\xFF");
+
+    // Bytes around sequence boundaries, stops at first mismatch.
+    const unsigned char bytes[] = {
+        'a', '"', 0x01, 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xC1, 0xC2, 0xDF,
+        0xE0, 0xE1, 0xEC, 0xED, 0xEE, 0xEF, 0xF0, 0xF1, 0xF3, 0xF4, 0xF5, 0xFF,
+    };
+
+    auto random   = std::mt19937(1);
+    auto failures = test::gFailures;
+    for (auto i = 0; i < 100000 && failures == test::gFailures; ++i)
+    {
+        auto value = std::string(random() % 12, '\0');
+        for (auto& c : value)
+        {
+            c = static_cast<char>(bytes[random() % sizeof(bytes)]);
+        }
+
+        check(value);
+    }
+}
+
+auto TestLegacyFrame() -> void
+{
+    // Keys the server got before any feature existed.
+    auto expected = nlohmann::json(MakeFullPayload());
+    expected.erase("Fields");
+    expected.erase("Stats");
+    expected.erase("Sync");
+    expected["Playback"].erase("Rate");
+    expected["Playback"].erase("Timestamp");
+    expected["Cover"].erase("Attachment");
+    expected["Cover"].erase("Hash");
+
+    auto buffer = std::string();
+    auto writer = JsonWriter(buffer);
+    writer.BeginObject();
+    WriteSections(writer, MakeFullPayload(), GetNegotiatedFields(ConnectionState()), "", "");
+    writer.EndObject();
+
+    SHOWPLAY_CHECK(buffer == expected.dump());
+}
+
+} // namespace
+
+int main()
+{
+    TestPayloads();
+    TestNumbers();
+    TestUtf8();
+    TestLegacyFrame();
+
+    return SHOWPLAY_TEST_RESULT();
+}
@@ -0,0 +1,44 @@
+// foo_showplay - ShowPlay client component
+//
+// Copyright (C) 2021 VacuityBox
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-only 
+
+// Token is echoed exactly as server sent it, invalid one is dropped.
+
+#include "Check.hpp"
+#include "ServerMessage.hpp"
+
+using namespace foo_showplay;
+
+auto main() -> int
+{
+    auto upper = ParseServerMessage(R"({"Token":"0123ABCD-4567-89EF-ABCD-0123456789EF"})");
+    SHOWPLAY_CHECK(upper.HasToken);
+    SHOWPLAY_CHECK(upper.Token == ParseUuid("0123abcd-4567-89ef-abcd-0123456789ef"));
+    SHOWPLAY_CHECK(upper.TokenText == std::optional<std::string>("0123ABCD-4567-89EF-ABCD-0123456789EF"));
+
+    auto invalid = ParseServerMessage(R"({"Token":"not-a-token"})");
+    SHOWPLAY_CHECK(invalid.HasToken);
+    SHOWPLAY_CHECK(!invalid.Token.has_value());
+    SHOWPLAY_CHECK(!invalid.TokenText.has_value());
+
+    auto none = ParseServerMessage(R"({"Token":null})");
+    SHOWPLAY_CHECK(none.HasToken);
+    SHOWPLAY_CHECK(!none.TokenText.has_value());
+
+    return SHOWPLAY_TEST_RESULT();
+}